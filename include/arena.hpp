@@ -0,0 +1,81 @@
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Filas de los planos alineadas a 64 B con cualquier ancho: el paso entre filas
+// (en floats) es W redondeado a ROW_ALIGN_PX. Las columnas [W, pitch) quedan en cero.
+constexpr int ROW_ALIGN_PX = 16;
+inline int plane_pitch(int W) { return (W + ROW_ALIGN_PX - 1) / ROW_ALIGN_PX * ROW_ALIGN_PX; }
+inline size_t plane_size(int W, int H) { return size_t(plane_pitch(W)) * size_t(H); }
+
+// Arena para los planos por resolución (H, tinta, scratch de tinta, slots de
+// pipeline / triple buffer): una sola reserva alineada a 2 MiB con MADV_HUGEPAGE
+// (menos fallos de TLB al recorrer planos de varios MB). Cada plano empieza
+// alineado a 64 B y desplazado k*64 B dentro de su página, para que H/CR/CG/CB en
+// el mismo índice no compitan por el mismo set de caché (aliasing de 4 KiB).
+// Es de tipo "bump": los planos viven hasta el final del proceso. Si no se reservó
+// o ya no hay espacio, se cae a new alineado a 64 B (en ceros).
+//
+// NUMA: reserve() hace el primer toque de toda la reserva en paralelo, plano por
+// plano con el reparto por filas de los kernels (schedule(static) sobre H filas),
+// así cada página queda en el nodo del hilo que la recorre. Por eso los planos se
+// crean con resize(), que no escribe (ArenaAllocator::construct sin valor): un
+// assign(SZ, 0) desde el hilo principal no las movería, pero sí las recorrería
+// entero en serie. Con huge pages la ubicación es por bloque de 2 MiB (lo decide
+// la fila que cae primero en él).
+class FrameArena {
+public:
+    static FrameArena& global();
+
+    // Reserva (una sola llamada) espacio para 'planes' planos de plane_size(W, H)
+    // floats, en ceros y ya tocados por los hilos OpenMP (parallel_touch = false: por
+    // el hilo que llama, para quien recorre los planos en serie). Solo tiene efecto
+    // la primera vez.
+    void reserve(int W, int H, int planes, bool parallel_touch = true);
+
+    void* take(size_t bytes);            // nullptr si no cabe
+    bool  owns(const void* p) const;
+    std::string describe() const;
+
+private:
+    FrameArena() = default;
+    mutable std::mutex m_;
+    char*  base_ = nullptr;
+    size_t cap_ = 0, used_ = 0;
+    int    planes_ = 0, reserved_planes_ = 0, fallback_ = 0;
+    bool   huge_ = false;
+};
+
+template <class T>
+struct ArenaAllocator {
+    using value_type = T;
+    ArenaAllocator() = default;
+    template <class U> ArenaAllocator(const ArenaAllocator<U>&) {}
+
+    // La arena entrega memoria nueva en ceros; el respaldo también sale en ceros
+    T* allocate(size_t n) {
+        if (void* p = FrameArena::global().take(n * sizeof(T))) return static_cast<T*>(p);
+        void* p = ::operator new(n * sizeof(T), std::align_val_t(64));
+        std::memset(p, 0, n * sizeof(T));
+        return static_cast<T*>(p);
+    }
+    void deallocate(T* p, size_t) {
+        if (!FrameArena::global().owns(p)) ::operator delete(p, std::align_val_t(64));
+    }
+    // resize() sin valor no escribe (inicialización por defecto): un plano nuevo ya
+    // está en ceros. Ojo: agrandar dentro de la capacidad deja los valores viejos.
+    template <class U> void construct(U* p) noexcept { ::new (static_cast<void*>(p)) U; }
+    template <class U, class... A> void construct(U* p, A&&... a) {
+        ::new (static_cast<void*>(p)) U(std::forward<A>(a)...);
+    }
+};
+template <class T, class U> bool operator==(const ArenaAllocator<T>&, const ArenaAllocator<U>&) { return true; }
+template <class T, class U> bool operator!=(const ArenaAllocator<T>&, const ArenaAllocator<U>&) { return false; }
+
+// Plano W x H de floats de plane_size(W, H) (fila y en [y*pitch, y*pitch + W))
+using Plane = std::vector<float, ArenaAllocator<float>>;
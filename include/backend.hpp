@@ -0,0 +1,38 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "waves.hpp"
+
+// Backend de cómputo elegible en tiempo de ejecución (--backend). Las tres etapas
+// del frame que dependen del backend: gotas -> H (+ tinta), difusión/decay de la
+// tinta y sombreado a ARGB8888. El respawn es del World (igual para todos).
+class ComputeBackend {
+public:
+    virtual ~ComputeBackend() = default;
+    virtual std::string name() const = 0;
+    virtual void accumulate(World& world, float t_now) = 0;
+    virtual void ink(World& world, float dt) = 0;
+    virtual void shade(const World& world, uint32_t* pixels, int pitch) = 0;
+    // Diagnóstico extra para --profile (p. ej. robos del pool); vacío por defecto
+    virtual std::string note() { return ""; }
+};
+
+// Registro: seq (referencia secuencial), omp (bucles OpenMP), ws (tiles + work-stealing)
+struct BackendInfo {
+    const char* name;
+    const char* desc;
+    std::unique_ptr<ComputeBackend> (*make)(const AppConfig& cfg);
+};
+const std::vector<BackendInfo>& backend_registry();
+std::string backend_names();   // "seq|omp|ws"
+
+// Especificación: "NOMBRE" (las tres etapas) o por etapa "accum=ws,ink=omp,shade=seq"
+// (las etapas que falten quedan en omp). Devuelve {accum, ink, shade}; lanza
+// std::runtime_error si no es válida.
+std::array<std::string, 3> parse_backend_spec(const std::string& spec);
+
+// Backend para la especificación; cada nombre distinto se instancia una vez
+std::unique_ptr<ComputeBackend> make_backend(const std::string& spec, const AppConfig& cfg);
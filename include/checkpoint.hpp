@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "config.hpp"
+#include "waves.hpp"
+
+// Checkpoint del World (--checkpoint FILE al salir, --restore FILE al iniciar):
+// gotas, generación por gota (el estado del DropRNG: Philox es función pura de
+// (semilla, gota, generación)), heap de expiración, nextColorIdx, H y CR/CG/CB.
+// Formato versionado en orden nativo, con secciones alineadas a 4 KiB para que
+// la carga sea mmap + memcpy sin parseo:
+//   CheckpointHeader | drops | gen | expiry | H | CR | CG | CB
+constexpr char     CHECKPOINT_MAGIC[8] = {'R','I','P','C','K','P','0','1'};
+constexpr uint32_t CHECKPOINT_VERSION  = 1;
+constexpr uint64_t CHECKPOINT_ALIGN    = 4096;
+
+struct CheckpointHeader {
+    char     magic[8];
+    uint32_t version;
+    uint32_t header_bytes;      // sizeof(CheckpointHeader)
+    uint32_t drop_bytes;        // sizeof(Drop)
+    uint32_t expiry_bytes;      // sizeof(DropExpiry)
+    int32_t  width, height, N, palette;
+    int32_t  ink_enabled, next_color_idx;
+    uint64_t seed;              // resuelta
+    float    t_sim;             // tiempo simulado al guardar (s)
+    float    slope, spawn_rate;
+    float    ink_gain, ink_decay, ink_blur_mix, ink_strength, cull_eps;
+    uint32_t n_drops, n_gen, n_expiry, reserved;
+    uint64_t off_drops, off_gen, off_expiry, off_planes;
+    uint64_t plane_bytes;       // W*H*4, cada plano alineado a CHECKPOINT_ALIGN
+    uint64_t file_bytes;
+    uint64_t scene;             // drops_hash (verificación de la carga)
+};
+
+// Escribe el checkpoint (a FILE.tmp y rename, nunca queda uno a medias).
+// t_now es el tiempo simulado del llamador; lanza std::runtime_error si falla.
+void save_checkpoint(const std::string& path, const World& world, float t_now);
+
+// Copia la escena del checkpoint a cfg (W, H, N, paleta, tinta, pendiente, spawn,
+// cull-eps): la ventana y el World se crean ya con las dimensiones del archivo.
+// Lanza std::runtime_error si algún valor está fuera de los rangos de parse_args.
+void load_checkpoint_scene(const std::string& path, AppConfig& cfg);
+
+struct RestoreStats {
+    float    t_sim = 0.0f;      // tiempo simulado del checkpoint
+    uint64_t bytes = 0;
+    double   map_ms = 0.0, copy_ms = 0.0;
+    std::string describe(const std::string& path) const;
+};
+
+// Reemplaza el estado de world (creado con la escena de load_checkpoint_scene) por
+// el del archivo, rebasado para que el reloj del llamador siga en now_s. Lanza
+// std::runtime_error si el archivo no es un checkpoint válido para este World.
+RestoreStats restore_checkpoint(const std::string& path, World& world, float now_s);
@@ -0,0 +1,77 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include "arena.hpp"
+#if defined(__F16C__)
+#include <immintrin.h>
+#endif
+
+// Almacenamiento compacto del frame (--storage compact): H en fp16 (binary16) y
+// tinta en unorm16 -> 8 B/px en vez de 16 B/px. La simulación sigue en float
+// (suma atómica sobre H y la tinta); la última pasada de la tinta empaqueta cada
+// fila (ink_postprocess_packed) y el sombreado desempaqueta al leer. La tinta ya
+// sale de esa pasada en [0,1], así que unorm16 no la recorta más que el camino f32.
+using Plane16 = std::vector<uint16_t, ArenaAllocator<uint16_t>>;
+
+// float -> half con redondeo al par más cercano (desborde -> inf)
+inline uint16_t f32_to_f16(float f) {
+#if defined(__F16C__)
+    return uint16_t(_cvtss_sh(f, _MM_FROUND_TO_NEAREST_INT));
+#else
+    uint32_t x; std::memcpy(&x, &f, 4);
+    uint32_t sign = (x >> 16) & 0x8000u;
+    uint32_t ax = x & 0x7FFFFFFFu;
+    if (ax >= 0x47800000u)                       // >= 65536: inf (o NaN)
+        return uint16_t(sign | (ax > 0x7F800000u ? 0x7E00u : 0x7C00u));
+    if (ax < 0x38800000u) {                      // < 2^-14: subnormal, el FPU redondea
+        float af; std::memcpy(&af, &ax, 4);
+        af += 0.5f;
+        uint32_t r; std::memcpy(&r, &af, 4);
+        return uint16_t(sign | (r - 0x3F000000u));
+    }
+    uint32_t mant_odd = (ax >> 13) & 1u;
+    ax += 0xC8000FFFu + mant_odd;                // re-sesgo del exponente + redondeo
+    return uint16_t(sign | (ax >> 13));
+#endif
+}
+
+inline float f16_to_f32(uint16_t h) {
+#if defined(__F16C__)
+    return _cvtsh_ss(h);
+#else
+    const uint32_t shifted_exp = 0x7C00u << 13;
+    uint32_t o = uint32_t(h & 0x7FFFu) << 13;
+    uint32_t e = shifted_exp & o;
+    o += (127u - 15u) << 23;
+    if (e == shifted_exp) o += (128u - 16u) << 23;          // inf/NaN
+    else if (e == 0) {                                       // cero/subnormal
+        o += 1u << 23;
+        float f; std::memcpy(&f, &o, 4);
+        const uint32_t mu = 113u << 23; float m; std::memcpy(&m, &mu, 4);
+        f -= m;
+        std::memcpy(&o, &f, 4);
+    }
+    o |= uint32_t(h & 0x8000u) << 16;
+    float out; std::memcpy(&out, &o, 4);
+    return out;
+#endif
+}
+
+inline uint16_t to_unorm16(float x) { return uint16_t(std::clamp(x, 0.0f, 1.0f) * 65535.0f + 0.5f); }
+inline float from_unorm16(uint16_t v) { return float(v) * (1.0f / 65535.0f); }
+
+struct CompactPlanes {
+    Plane16 H, CR, CG, CB;    // mismo paso entre filas que los planos float (plane_pitch)
+
+    void resize(size_t SZ) {
+        H .assign(SZ, 0);
+        CR.assign(SZ, 0);
+        CG.assign(SZ, 0);
+        CB.assign(SZ, 0);
+    }
+};
+
+// Empaqueta las filas [y0, y1) (sin paralelismo propio)
+void pack_rows(const float* H, const float* CR, const float* CG, const float* CB,
+               int W, int y0, int y1, CompactPlanes& out);
@@ -15,6 +15,43 @@ struct AppConfig {
     int   palette = 2;      // 0=aqua, 1=mix, 2=real (defecto)
     bool  novsync = false;  // medir cómputo puro
     bool  profile = false;  // tiempos sim/render
+    bool  perfcounters = false; // contadores HW por etapa (perf_event_open)
+    int   textures = 2;     // texturas de streaming en anillo (1..3, render_sdl.hpp)
+    int   upload   = 0;     // 0=lock (sombrear en la textura), 1=update (staging + SDL_UpdateTexture), 2=thread (staging + hilo de copia)
+    int   pipeline = 0;     // 0=off; >=1 frames que la simulación puede adelantarse al render
+    int   engine   = 0;     // 0=una región OpenMP por kernel, 1=equipo persistente por frame
+    std::string backend = "omp"; // backend de cómputo (backend.hpp): seq|omp|ws o por etapa accum=X,ink=Y,shade=Z
+    int   threads  = 0;     // 0=OMP_NUM_THREADS / todos; >0 hilos OpenMP y del pool work-stealing
+    int   math     = 0;     // 0=exacta (libm), 1=rápida (aproximaciones con error acotado, fast_math.hpp)
+    int   storage  = 0;     // 0=f32, 1=compacto (H fp16 + tinta unorm16) para el frame a sombrear
+    float cull_eps = 0.0f;  // 0=off; >0 amplitud mínima de H: bandas recortadas a donde el aporte la supera
+    bool  cull_respawn = false; // con cull_eps: reemplazar la gota en cuanto queda invisible (no esperar maxLife)
+    float target_fps = 0.0f; // 0=off; >0 gobernador de calidad que sostiene este presupuesto por frame
+    int   pin      = 0;     // 0=sin fijar, 1=compact, 2=spread (hilos OpenMP -> CPUs)
+    int   bench_frames = 0; // >0: benchmark headless de kernels (omp vs ws) y salir
+    float sim_hz   = 0.0f;  // 0=sim acoplada al render; >0 hilo de simulación a paso fijo (Hz)
+    std::string golden;     // referencia golden: la secuencial la escribe, la paralela compara contra ella
+    bool  scene_args = false;     // --width, --height y --N dados en la línea de comandos
+    int   golden_frames = 120;    // frames de la referencia (dt fijo 1/60)
+    float golden_max_err  = -1.0f; // <0: umbral por backend (max |dH| y max |dTinta|)
+    float golden_min_psnr = -1.0f; // <0: umbral por backend (PSNR de la imagen, dB)
+    std::string export_path;      // exportación headless de frames ("-" = stdout), frame_export.hpp
+    int   export_format = -1;     // -1=por extensión, 0=raw ARGB, 1=y4m (YUV 4:2:0), 2=ppm
+    int   export_frames = 600;    // frames a exportar
+    float export_fps    = 60.0f;  // paso fijo dt = 1/fps (y fps del Y4M)
+    int   export_queue  = 4;      // buffers en la cola hacia el hilo escritor
+    std::string record;           // grabación de eventos de gotas (drop_log.hpp)
+    std::string replay;           // reproducir una grabación (headless, sin RNG)
+    std::string checkpoint;       // guardar el estado del World al salir (checkpoint.hpp)
+    std::string restore;          // arrancar desde un checkpoint (escena incluida)
+    int   mpi_frames = 120;       // muro MPI (screensaver_mpi): frames con dt fijo 1/60
+    bool  mpi_scaling = false;    // muro MPI: informe de escalado fuerte y débil con 1, 2, 4... rangos
+    int   canvas_y0 = 0, canvas_h = 0;   // muro MPI: el World es la franja [canvas_y0, +height) de un lienzo de canvas_h filas
+    std::string shm_name;         // anillo de frames en memoria compartida POSIX (shm_ring.hpp)
+    int   shm_slots  = 3;         // slots del anillo (el lector tiene slots-1 frames de margen)
+    float shm_fps    = 60.0f;     // ritmo de publicación (tiempo real)
+    int   shm_frames = 0;         // 0=hasta SIGINT/SIGTERM
+    std::string metrics;          // socket Unix con métricas OpenMetrics (metrics.hpp)
     
     // ---- Spawn control ----
     float spawn_rate = 1.0f;  // multiplier for drop lifespan (higher = slower spawn)
@@ -30,7 +67,7 @@ struct AppConfig {
 inline void print_usage(const char* prog) {
     std::cout << "Uso: " << prog
               << " --width W --height H --N N [--seed S] [--slope K] [--spawn-rate R]"
-                 " [--fpslog] [--palette {aqua|mix|real}] [--novsync] [--profile]"
+                 " [--fpslog] [--palette {aqua|mix|real}] [--novsync] [--profile] [--perfcounters] [--textures K] [--upload {lock|update|thread}] [--pipeline D] [--sim-hz R] [--engine {regions|team}] [--backend {seq|omp|ws|accum=X,ink=Y,shade=Z}] [--threads T] [--sched {omp|ws}] [--bench-kernels F] [--pin {none|compact|spread}] [--storage {f32|compact}] [--math {exact|fast}] [--cull-eps E] [--cull-respawn] [--target-fps F] [--golden FILE] [--golden-frames F] [--golden-max-err E] [--golden-min-psnr P] [--export FILE|-] [--export-format {raw|y4m|ppm}] [--export-frames F] [--export-fps R] [--export-queue Q] [--record FILE] [--replay FILE] [--checkpoint FILE] [--restore FILE] [--mpi-frames F] [--mpi-scaling] [--shm NAME] [--shm-slots K] [--shm-fps R] [--shm-frames F] [--metrics PATH]"
                  " [--ink {0|1}] [--ink-gain G] [--ink-decay L] [--ink-blur B] [--ink-strength S]\n";
 }
 
@@ -43,8 +80,27 @@ inline bool parse_float(const char* s, float& out, float minv, float maxv) {
     catch (...) { return false; }
 }
 
+// Mismos rangos que parse_args para una escena leída de un archivo (--restore,
+// --replay, --golden): un encabezado corrupto no llega a dimensionar el World
+inline void validate_scene(const AppConfig& c, const std::string& what) {
+    auto in = [](float v, float lo, float hi) { return v >= lo && v <= hi; };   // NaN no pasa
+    std::string bad;
+    if (c.width < 640 || c.width > 16384)             bad = "width (>=640)";
+    else if (c.height < 480 || c.height > 16384)      bad = "height (>=480)";
+    else if (c.N < 1)                                 bad = "N (>=1)";
+    else if (c.palette < 0 || c.palette > 2)          bad = "palette (0..2)";
+    else if (!in(c.slope, 0.1f, 40.0f))               bad = "slope (0.1..40)";
+    else if (!in(c.spawn_rate, 0.1f, 10.0f))          bad = "spawn-rate (0.1..10)";
+    else if (!in(c.ink_gain, 0.0f, 3.0f))             bad = "ink-gain (0..3)";
+    else if (!in(c.ink_decay, 0.0f, 5.0f))            bad = "ink-decay (0..5)";
+    else if (!in(c.ink_blur_mix, 0.0f, 1.0f))         bad = "ink-blur (0..1)";
+    else if (!in(c.ink_strength, 0.0f, 2.0f))         bad = "ink-strength (0..2)";
+    else if (!in(c.cull_eps, 0.0f, 1.0f))             bad = "cull-eps (0..1)";
+    if (!bad.empty()) throw std::runtime_error(what + ": escena fuera de rango en el archivo, " + bad);
+}
+
 inline AppConfig parse_args(int argc, char** argv) {
-    AppConfig cfg; bool gotW=false, gotH=false, gotN=false;
+    AppConfig cfg; bool gotW=false, gotH=false, gotN=false, gotTex=false;
     for (int i=1; i<argc; ++i) {
         std::string a = argv[i];
         auto need = [&](const char* name){ if (i+1>=argc) throw std::runtime_error(std::string("Falta valor para ")+name); return argv[++i]; };
@@ -59,6 +115,42 @@ inline AppConfig parse_args(int argc, char** argv) {
         else if (a=="--palette"){ const char* v=need(a.c_str()); std::string s=v; if(s=="aqua") cfg.palette=0; else if(s=="mix"||s=="aquamix") cfg.palette=1; else if(s=="real") cfg.palette=2; else throw std::runtime_error("palette invalida (aqua|mix|real)"); }
         else if (a=="--novsync"){ cfg.novsync=true; }
         else if (a=="--profile"){ cfg.profile=true; }
+        else if (a=="--perfcounters"){ cfg.perfcounters=true; }
+        else if (a=="--sim-hz"){ const char* v=need(a.c_str()); float tmp; if(!parse_float(v,tmp,0.0f,1000.0f) || (tmp>0.0f && tmp<1.0f)) throw std::runtime_error("sim-hz 0 (off) o 1..1000"); cfg.sim_hz=tmp; }
+        else if (a=="--engine"){ const char* v=need(a.c_str()); std::string s=v; if(s=="regions") cfg.engine=0; else if(s=="team") cfg.engine=1; else throw std::runtime_error("engine invalido (regions|team)"); }
+        else if (a=="--sched"){ const char* v=need(a.c_str()); std::string s=v; if(s=="omp"||s=="ws") cfg.backend=s; else throw std::runtime_error("sched invalido (omp|ws)"); }
+        else if (a=="--backend"){ cfg.backend=need(a.c_str()); }
+        else if (a=="--threads"){ const char* v=need(a.c_str()); if(!parse_int(v,cfg.threads,1,1024)) throw std::runtime_error("threads 1..1024"); }
+        else if (a=="--math"){ const char* v=need(a.c_str()); std::string s=v; if(s=="exact") cfg.math=0; else if(s=="fast") cfg.math=1; else throw std::runtime_error("math invalido (exact|fast)"); }
+        else if (a=="--cull-eps"){ const char* v=need(a.c_str()); float tmp; if(!parse_float(v,tmp,0.0f,1.0f)) throw std::runtime_error("cull-eps 0..1"); cfg.cull_eps=tmp; }
+        else if (a=="--cull-respawn"){ cfg.cull_respawn=true; }
+        else if (a=="--target-fps"){ const char* v=need(a.c_str()); float tmp; if(!parse_float(v,tmp,0.0f,1000.0f)) throw std::runtime_error("target-fps 0..1000"); cfg.target_fps=tmp; }
+        else if (a=="--storage"){ const char* v=need(a.c_str()); std::string s=v; if(s=="f32") cfg.storage=0; else if(s=="compact") cfg.storage=1; else throw std::runtime_error("storage invalido (f32|compact)"); }
+        else if (a=="--pin"){ const char* v=need(a.c_str()); std::string s=v; if(s=="none") cfg.pin=0; else if(s=="compact") cfg.pin=1; else if(s=="spread") cfg.pin=2; else throw std::runtime_error("pin invalido (none|compact|spread)"); }
+        else if (a=="--bench-kernels"){ const char* v=need(a.c_str()); if(!parse_int(v,cfg.bench_frames,1,100000)) throw std::runtime_error("bench-kernels 1..100000"); }
+        else if (a=="--golden"){ cfg.golden=need(a.c_str()); }
+        else if (a=="--golden-frames"){ const char* v=need(a.c_str()); if(!parse_int(v,cfg.golden_frames,4,100000)) throw std::runtime_error("golden-frames 4..100000"); }
+        else if (a=="--golden-max-err"){ const char* v=need(a.c_str()); if(!parse_float(v,cfg.golden_max_err,0.0f,10.0f)) throw std::runtime_error("golden-max-err 0..10"); }
+        else if (a=="--golden-min-psnr"){ const char* v=need(a.c_str()); if(!parse_float(v,cfg.golden_min_psnr,0.0f,200.0f)) throw std::runtime_error("golden-min-psnr 0..200"); }
+        else if (a=="--export"){ cfg.export_path=need(a.c_str()); }
+        else if (a=="--export-format"){ const char* v=need(a.c_str()); std::string s=v; if(s=="raw") cfg.export_format=0; else if(s=="y4m") cfg.export_format=1; else if(s=="ppm") cfg.export_format=2; else throw std::runtime_error("export-format invalido (raw|y4m|ppm)"); }
+        else if (a=="--export-frames"){ const char* v=need(a.c_str()); if(!parse_int(v,cfg.export_frames,1,10000000)) throw std::runtime_error("export-frames 1..10000000"); }
+        else if (a=="--export-fps"){ const char* v=need(a.c_str()); if(!parse_float(v,cfg.export_fps,1.0f,1000.0f)) throw std::runtime_error("export-fps 1..1000"); }
+        else if (a=="--export-queue"){ const char* v=need(a.c_str()); if(!parse_int(v,cfg.export_queue,1,64)) throw std::runtime_error("export-queue 1..64"); }
+        else if (a=="--record"){ cfg.record=need(a.c_str()); }
+        else if (a=="--replay"){ cfg.replay=need(a.c_str()); }
+        else if (a=="--checkpoint"){ cfg.checkpoint=need(a.c_str()); }
+        else if (a=="--restore"){ cfg.restore=need(a.c_str()); }
+        else if (a=="--mpi-frames"){ const char* v=need(a.c_str()); if(!parse_int(v,cfg.mpi_frames,1,10000000)) throw std::runtime_error("mpi-frames 1..10000000"); }
+        else if (a=="--mpi-scaling"){ cfg.mpi_scaling=true; }
+        else if (a=="--shm"){ cfg.shm_name=need(a.c_str()); }
+        else if (a=="--shm-slots"){ const char* v=need(a.c_str()); if(!parse_int(v,cfg.shm_slots,2,64)) throw std::runtime_error("shm-slots 2..64"); }
+        else if (a=="--shm-fps"){ const char* v=need(a.c_str()); if(!parse_float(v,cfg.shm_fps,1.0f,1000.0f)) throw std::runtime_error("shm-fps 1..1000"); }
+        else if (a=="--shm-frames"){ const char* v=need(a.c_str()); if(!parse_int(v,cfg.shm_frames,0,std::numeric_limits<int>::max())) throw std::runtime_error("shm-frames >= 0"); }
+        else if (a=="--textures"){ const char* v=need(a.c_str()); if(!parse_int(v,cfg.textures,1,3)) throw std::runtime_error("textures 1..3"); gotTex=true; }
+        else if (a=="--upload"){ const char* v=need(a.c_str()); std::string s=v; if(s=="lock") cfg.upload=0; else if(s=="update") cfg.upload=1; else if(s=="thread") cfg.upload=2; else throw std::runtime_error("upload invalido (lock|update|thread)"); }
+        else if (a=="--metrics"){ cfg.metrics=need(a.c_str()); }
+        else if (a=="--pipeline"){ const char* v=need(a.c_str()); if(!parse_int(v,cfg.pipeline,0,3)) throw std::runtime_error("pipeline 0..3"); }
         else if (a=="--ink"){ const char* v=need(a.c_str()); int tmp; if(!parse_int(v,tmp,0,1)) throw std::runtime_error("ink debe ser 0|1"); cfg.ink_enabled=(tmp!=0); }
         else if (a=="--ink-gain"){ const char* v=need(a.c_str()); float tmp; if(!parse_float(v,tmp,0.0f,3.0f)) throw std::runtime_error("ink-gain 0..3"); cfg.ink_gain=tmp; }
         else if (a=="--ink-decay"){ const char* v=need(a.c_str()); float tmp; if(!parse_float(v,tmp,0.0f,5.0f)) throw std::runtime_error("ink-decay 0..5"); cfg.ink_decay=tmp; }
@@ -67,6 +159,15 @@ inline AppConfig parse_args(int argc, char** argv) {
         else if (a=="--help"||a=="-?"){ print_usage(argv[0]); std::exit(0); }
         else { std::ostringstream oss; oss<<"Argumento desconocido: "<<a; throw std::runtime_error(oss.str()); }
     }
-    if (!gotW || !gotH || !gotN) throw std::runtime_error("Parametros requeridos: --width, --height, --N");
+    // --replay, --restore y la comparación --golden toman la escena (W, H, N, ...) del archivo
+    if (!cfg.record.empty() && !cfg.restore.empty())
+        throw std::runtime_error("--record graba desde un World vacío: no se combina con --restore");
+    // Con --upload thread se bloquea la siguiente del anillo mientras se dibuja la
+    // recién copiada; con 2 texturas la bloqueada sería la del present anterior
+    if (cfg.upload == 2 && !gotTex) cfg.textures = 3;
+    if (cfg.upload == 2 && cfg.textures < 3)
+        throw std::runtime_error("--upload thread necesita --textures 3 (una se dibuja, otra es la del present anterior y el hilo copia a la tercera)");
+    cfg.scene_args = gotW && gotH && gotN;
+    if (cfg.replay.empty() && cfg.restore.empty() && cfg.golden.empty() && !cfg.scene_args) throw std::runtime_error("Parametros requeridos: --width, --height, --N");
     return cfg;
 }
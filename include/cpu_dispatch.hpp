@@ -0,0 +1,23 @@
+#pragma once
+#include <string>
+
+// Multiversión de los kernels calientes (gotas, tinta, sombreado): GCC compila una
+// copia por nivel de ISA x86-64 y el loader elige la mejor al arrancar (ifunc +
+// cpuid). Un solo binario corre a toda velocidad en máquinas AVX2 y AVX-512 sin
+// -march=native. Con RIPPLE_NATIVE (opción de CMake) todo se compila para la
+// máquina local y la macro queda vacía.
+// Va en funciones hoja (sin regiones OpenMP dentro): el cuerpo de una región se
+// extrae a otra función que no hereda los clones. flatten inlinea todo lo que la
+// hoja llama (plantillas de kernel, helpers): si no, esas funciones quedan
+// compiladas una sola vez para la ISA base y los clones solo las llaman.
+#if defined(__x86_64__) && defined(__linux__) && defined(__GNUC__) && !defined(__clang__) \
+    && __GNUC__ >= 11 && !defined(RIPPLE_NATIVE)
+#define RIPPLE_MULTIVERSION __attribute__((target_clones("arch=x86-64-v4", "arch=x86-64-v3", "default"), flatten))
+#define RIPPLE_HAS_MULTIVERSION 1
+#else
+#define RIPPLE_MULTIVERSION
+#define RIPPLE_HAS_MULTIVERSION 0
+#endif
+
+// Ruta elegida en esta máquina, para el reporte de arranque
+std::string cpu_dispatch_report();
@@ -0,0 +1,87 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "config.hpp"
+#include "waves.hpp"
+
+// Grabación binaria de los eventos de gotas (--record) y reproducción (--replay).
+// Archivo append-only, en orden nativo (little-endian en x86):
+//   DropLogHeader
+//   { DropLogFrame, n_events x DropLogEvent }*     un registro por frame
+//   DropLogEnd                                     al cerrar (falta si se cortó)
+// Cada frame lleva su t_now y dt, las gotas activas, las perillas que mueve el
+// gobernador y cada gota (re)generada desde el frame anterior con sus parámetros
+// completos: la reproducción no usa RNG ni reloj y da el mismo H que la sesión.
+constexpr char     DROP_LOG_MAGIC[8] = {'R','I','P','L','O','G','0','1'};
+constexpr uint32_t DROP_LOG_VERSION  = 1;
+constexpr uint32_t DROP_LOG_FRAME    = 0x304D5246;   // "FRM0"
+constexpr uint32_t DROP_LOG_END      = 0x30444E45;   // "END0"
+
+struct DropLogHeader {
+    char     magic[8];
+    uint32_t version;
+    uint32_t drop_bytes;        // sizeof(Drop) al grabar
+    int32_t  width, height, N, palette;
+    int32_t  ink_enabled, math;
+    uint64_t seed;              // resuelta
+    float    slope, spawn_rate;
+    float    ink_gain, ink_decay, ink_blur_mix, ink_strength;
+};
+
+struct DropLogFrame {
+    uint32_t tag;               // DROP_LOG_FRAME
+    uint32_t n_events;
+    uint32_t n_drops;           // gotas activas en este frame
+    float    t_now, dt;
+    float    ink_blur_mix, cull_eps;    // perillas del gobernador
+};
+
+struct DropLogEvent {
+    uint32_t id;                // índice en World::drops
+    Drop     d;
+};
+
+struct DropLogEnd {
+    uint32_t tag;               // DROP_LOG_END
+    uint32_t frames;
+    uint64_t scene;             // drops_hash al cerrar
+};
+
+// Lado grabación: World llama on_spawn() por cada lote regenerado y end_frame() al
+// terminar maybe_respawn. Los eventos fuera de un frame (init, set_active_drops del
+// gobernador) van en el registro del frame siguiente, antes de los de su respawn.
+class DropRecorder {
+public:
+    DropRecorder(const std::string& path, const World& world);
+    ~DropRecorder();
+    DropRecorder(const DropRecorder&) = delete;
+    DropRecorder& operator=(const DropRecorder&) = delete;
+
+    void on_spawn(const std::vector<int>& idx, const std::vector<Drop>& drops);
+    void end_frame(float now_s, const World& world);
+    // Escribe DropLogEnd y cierra; lanza std::runtime_error si falló alguna escritura
+    void close(const World& world);
+
+    std::string summary() const;   // ruta, frames, eventos, tamaño y escena final
+    uint32_t frames() const { return frames_; }
+    uint64_t events() const { return events_; }
+    uint64_t bytes() const { return bytes_; }
+
+private:
+    void write(const void* p, size_t n);
+
+    std::string path_;
+    std::FILE* f_ = nullptr;
+    std::vector<DropLogEvent> pending_;
+    float last_t_ = 0.0f;
+    bool  failed_ = false;
+    uint32_t frames_ = 0;
+    uint64_t events_ = 0, bytes_ = 0, scene_ = 0;
+};
+
+// Modo headless: mapea la grabación (mmap), copia su escena a cfg y la reproduce
+// frame a frame con el backend elegido (--backend), sin RNG ni ventana. Imprime
+// ms/frame por etapa y compara la escena final con la grabada.
+int run_replay(const AppConfig& cfg);
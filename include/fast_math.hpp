@@ -0,0 +1,64 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// Aproximaciones para --math fast (kernels paralelos de gotas y sombreado).
+// Errores máximos medidos (--bench-kernels los vuelve a medir e imprime):
+//   fast_exp    : rel <= 7e-6 (|x| <= 80; reducción a [-0.5, 0.5] + polinomio grado 5)
+//   fast_tanh   : abs <= 2e-6
+//   powi<90>    : rel <= 4e-6 en [0.5, 1] (cuadrados sucesivos; 5 y 90 son los
+//                 exponentes enteros del sombreado)
+// Sin manejo de NaN/inf: las entradas de los kernels son finitas.
+// pow con exponente fraccionario (gamma 1/2.2, viñeta 1.2) se deja en powf de libm:
+// en el bucle escalar del sombreado exp2(y*log2(x)) polinómico no le ganaba.
+namespace fm {
+
+inline float fast_exp2(float x) {
+    x = x < -126.0f ? -126.0f : (x > 126.0f ? 126.0f : x);
+    // redondeo por conversión a entero (sin llamada a libm; vectorizable)
+    const int32_t xi = int32_t(x + (x >= 0.0f ? 0.5f : -0.5f));
+    const float f = x - float(xi);                 // [-0.5, 0.5]
+    // Taylor de 2^f = e^(f ln2) hasta grado 5
+    const float p = 1.0f + f*(0.69314718f + f*(0.24022651f + f*(0.05550411f + f*(0.00961813f + f*0.00133336f))));
+    // 2^xi sumando al exponente de p (p en [0.70, 1.42]: no hay desborde de campo)
+    int32_t bits; std::memcpy(&bits, &p, 4);
+    bits += xi << 23;
+    float r; std::memcpy(&r, &bits, 4);
+    return r;
+}
+
+inline float fast_exp(float x) { return fast_exp2(x * 1.44269504f); }
+
+// x^N con N entero fijo: cuadrados sucesivos (log2(N) + popcount(N) productos)
+template <unsigned N>
+inline float powi(float x) {
+    if constexpr (N == 0) return 1.0f;
+    else if constexpr (N == 1) return x;
+    else {
+        const float h = powi<N / 2>(x);
+        if constexpr (N % 2) return h * h * x;
+        else return h * h;
+    }
+}
+
+inline float fast_tanh(float x) {
+    x = x < -9.0f ? -9.0f : (x > 9.0f ? 9.0f : x);
+    return 1.0f - 2.0f / (fast_exp(2.0f * x) + 1.0f);
+}
+
+} // namespace fm
+
+// Políticas para los kernels plantilla: misma fórmula, distinta librería
+struct ExactMath {
+    static constexpr bool fast = false;
+    static float exp(float x)          { return std::exp(x); }
+    static float pow(float x, float y) { return std::pow(x, y); }
+    static float tanh(float x)         { return std::tanh(x); }
+};
+struct FastMath {
+    static constexpr bool fast = true;
+    static float exp(float x)          { return fm::fast_exp(x); }
+    static float pow(float x, float y) { return std::pow(x, y); }
+    static float tanh(float x)         { return fm::fast_tanh(x); }
+};
@@ -0,0 +1,28 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <vector>
+#include "arena.hpp"
+#include "compact.hpp"
+#include "waves.hpp"
+
+// Frame simulado listo para sombrear: copia de H y de la tinta en el instante t_now.
+// Lo usan los modos que desacoplan simulación y render (pipeline, hilo de simulación).
+struct FrameSlot {
+    Plane H, CR, CG, CB;
+    CompactPlanes packed;     // --storage compact: el frame va aquí en vez de H/CR/CG/CB
+    float    t_now  = 0.0f;   // tiempo de simulación (s)
+    float    dt     = 0.0f;   // paso usado para la tinta (s)
+    uint64_t seq    = 0;      // número de frame simulado
+    double   sim_ms = 0.0;    // costo de simular este frame
+    CullStats cull;           // --cull-eps: trabajo de este frame con/sin culling
+    std::chrono::steady_clock::time_point t_start;  // inicio de la simulación (latencia)
+
+    // Solo sobre un slot nuevo: resize() no escribe (arena.hpp)
+    void resize(size_t SZ) {
+        H .resize(SZ);
+        CR.resize(SZ);
+        CG.resize(SZ);
+        CB.resize(SZ);
+    }
+};
@@ -0,0 +1,78 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "config.hpp"
+
+// Exportación de frames sombreados (--export) para render offline:
+//  - raw: ARGB8888 tal cual (uint32 0xAARRGGBB en orden nativo; en little-endian
+//         los bytes quedan B,G,R,A -> ffmpeg -f rawvideo -pix_fmt bgra)
+//  - y4m: YUV4MPEG2 4:2:0 (C420jpeg: croma promediado 2x2; BT.601 rango limitado)
+//  - ppm: P6 RGB; una secuencia concatenada en un archivo/stdout o, si la ruta lleva
+//         un patrón printf ("frames/f_%05d.ppm"), un archivo por frame
+// Ruta "-" = stdout.
+enum ExportFormat { EXPORT_RAW = 0, EXPORT_Y4M = 1, EXPORT_PPM = 2 };
+
+// Formato efectivo: fmt >= 0 explícito, si no por extensión (.y4m, .ppm, resto raw)
+ExportFormat export_format_for(const std::string& path, int fmt);
+const char* export_format_name(ExportFormat f);
+
+struct ExportFrame {
+    std::vector<uint32_t> argb;     // W*H, pitch 4*W (el sombreado escribe aquí)
+    std::vector<uint8_t>  payload;  // PPM/Y4M codificado (raw escribe argb)
+    int index = 0;
+};
+
+// Cola acotada de buffers reutilizables + hilo escritor dedicado: el productor solo
+// espera si los 'queue' buffers están todos pendientes de escribir (disco más lento
+// que la simulación de forma sostenida), nunca por una escritura puntual.
+class FrameExporter {
+public:
+    // Abre la salida (lanza std::runtime_error si no se puede) y arranca el escritor
+    FrameExporter(const std::string& path, ExportFormat fmt, int W, int H, float fps, int queue);
+    ~FrameExporter();
+    FrameExporter(const FrameExporter&) = delete;
+    FrameExporter& operator=(const FrameExporter&) = delete;
+
+    // Buffer libre (bloquea si no hay); nullptr si el escritor falló
+    ExportFrame* acquire();
+    // ARGB -> payload del formato (omp parallel for, en el hilo que llama)
+    void encode(ExportFrame& f) const;
+    // Encola el frame para escribir
+    void submit(ExportFrame* f);
+    // Vacía la cola, cierra la salida y detiene el escritor; lanza si falló la escritura
+    void finish();
+
+    double   stall_ms() const { return stall_ms_; }   // espera total del productor
+    double   write_ms() const { return write_ms_; }   // tiempo total del escritor en I/O
+    uint64_t bytes()    const { return bytes_; }
+
+private:
+    void writer_loop();
+    bool write_frame(const ExportFrame& f);
+
+    std::string path_;
+    ExportFormat fmt_;
+    int W_, H_;
+    float fps_;
+    std::FILE* out_ = nullptr;     // nullptr con patrón por frame
+    bool per_file_ = false;
+    std::vector<ExportFrame> frames_;
+    std::deque<ExportFrame*> free_, ready_;
+    std::mutex m_;
+    std::condition_variable cv_free_, cv_ready_;
+    bool stop_ = false, failed_ = false, finished_ = false;
+    std::string error_;
+    double stall_ms_ = 0.0, write_ms_ = 0.0;
+    uint64_t bytes_ = 0;
+    std::thread th_;
+};
+
+// Modo headless: --export-frames frames a paso fijo 1/--export-fps con el backend
+// elegido, exportados a cfg.export_path. Progreso y resumen por stderr.
+int run_export(const AppConfig& cfg);
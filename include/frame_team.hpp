@@ -0,0 +1,47 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "waves.hpp"
+
+// Tiempos del último frame del motor de equipo (ms)
+struct TeamStats {
+    double sim_ms     = 0.0;  // respawn + limpiar H + gotas
+    double ink_ms     = 0.0;  // tinta (decay, blur, mezcla): parte de la fase de tareas
+    double shade_ms   = 0.0;  // sombreado: resto de la fase de tareas
+    double barrier_ms = 0.0;  // espera media por hilo en las barreras explícitas
+    double fork_join_ms = 0.0; // apertura (media por hilo) + cierre de la única región
+    int    barriers   = 0;    // barreras explícitas por frame
+    int    threads    = 0;
+};
+
+// Costo medio (us) de abrir/cerrar una región paralela vacía y de una barrera,
+// medido con el tamaño de equipo actual. Es solo la estimación de arranque; lo
+// medido por frame está en TeamStats y en RegionSyncStats (region_sync.hpp).
+struct SyncOverhead { double fork_join_us = 0.0, barrier_us = 0.0; };
+SyncOverhead measure_sync_overhead(int reps = 200);
+
+// Motor de frame con un único equipo OpenMP persistente: una sola región paralela
+// por frame ejecuta respawn, limpieza de H, gotas, tinta y sombreado como fases.
+// Frente a las 5 regiones (fork/join + barrera implícita cada una) del camino clásico:
+//  - el respawn (un hilo) se solapa con la limpieza de H (resto del equipo),
+//  - decay, blur, mezcla y sombreado de la tinta son tareas por banda de filas con
+//    dependencias solo entre bandas vecinas (depend), sin barreras globales: una
+//    banda se sombrea en cuanto su tinta y la de sus vecinas está lista.
+// Quedan 2 barreras explícitas (tras limpiar H y tras las gotas, que tocan filas
+// arbitrarias). La salida es idéntica bit a bit a la del camino clásico.
+class FrameTeam {
+public:
+    explicit FrameTeam(const AppConfig& cfg);
+
+    // Avanza el World a t_now y sombrea en 'pixels' (ARGB8888, pitch en bytes)
+    void run(World& world, float t_now, float dt, uint32_t* pixels, int pitch);
+
+    const TeamStats& stats() const { return stats_; }
+
+private:
+    static constexpr int BAND = 16;   // filas por tarea de tinta/sombreado
+
+    Plane TR, TG, TB;   // blur de tinta (persistente, sin realloc por frame)
+    std::vector<char> deps_;          // direcciones de las dependencias por banda
+    TeamStats stats_;
+};
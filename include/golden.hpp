@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "arena.hpp"
+#include "config.hpp"
+
+// Frames de referencia ("golden") para regresión numérica de los backends.
+// La versión secuencial (--golden FILE) simula cfg.golden_frames frames con dt fijo
+// de 1/60 s y guarda H, tinta y el frame ARGB en 4 instantes (F/4, F/2, 3F/4, F),
+// más los parámetros de la escena y su ms/frame. La versión paralela (--golden FILE)
+// repite la escena con cada backend y compara contra la referencia.
+struct GoldenHeader {
+    char     magic[8] = {'R','I','P','G','O','L','D','1'};
+    int32_t  width = 0, height = 0, N = 0, seed = 0;
+    int32_t  frames = 0, snapshots = 0;
+    int32_t  palette = 0, ink_enabled = 0;
+    float    dt = 0, slope = 0, spawn_rate = 0;
+    float    ink_gain = 0, ink_decay = 0, ink_blur_mix = 0, ink_strength = 0;
+    double   ms_frame = 0;     // ms/frame medio de la referencia (respawn + gotas + tinta + sombreado)
+    uint64_t scene = 0;        // drops_hash tras init
+};
+
+struct GoldenSnapshot {
+    int32_t frame = 0;         // 1..frames
+    Plane H, CR, CG, CB;
+    std::vector<uint32_t> argb;
+};
+
+struct GoldenFile {
+    GoldenHeader hdr;
+    std::vector<GoldenSnapshot> snaps;
+};
+
+// Frames que se guardan para 'frames' frames simulados
+std::vector<int> golden_snapshot_frames(int frames);
+// Cabecera desde/hacia la configuración (solo parámetros que cambian la escena)
+GoldenHeader golden_header_from(const AppConfig& cfg);
+void golden_apply(const GoldenHeader& hdr, AppConfig& cfg);
+
+// E/S binaria (endianness nativa); lanzan std::runtime_error
+void golden_write(const std::string& path, const GoldenFile& g);
+GoldenFile golden_read(const std::string& path);
+
+// Modos headless: escribir la referencia (secuencial) / comparar (paralela).
+// Devuelven el código de salida: 0 = ok, 1 = algún backend supera los umbrales.
+int run_golden_write(const AppConfig& cfg);
+int run_golden_check(const AppConfig& cfg);
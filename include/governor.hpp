@@ -0,0 +1,43 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "waves.hpp"
+
+// Gobernador de calidad (--target-fps): mira el costo de cómputo por etapa de cada
+// frame (sin present/vsync) y mueve perillas del World para sostener el presupuesto
+// 1000/target ms. Perillas, en el orden en que se degradan:
+//  - blur de tinta (ink_blur_mix -> 0) si la etapa de tinta pesa >= 25% del frame,
+//  - épsilon de culling (cull_eps: 0 -> 3e-4 -> 1e-3 -> 3e-3),
+//  - gotas activas (-15% por paso, mínimo max(1, N/4)).
+// Histéresis: degrada con la media móvil sobre el presupuesto durante 0.25 s,
+// recupera (deshace el último paso) con la media < 70% durante 1.5 s, y tras cada
+// cambio espera 0.5 s a que la media se asiente.
+class QualityGovernor {
+public:
+    explicit QualityGovernor(const AppConfig& cfg);
+
+    // frame_s: duración real del frame; tiempos de cómputo por etapa en ms
+    // (ink_ms = 0 si la etapa no se mide aparte). Devuelve true si cambió alguna
+    // perilla (el mensaje queda en last_change()).
+    bool update(World& world, float t_now, double frame_s,
+                double sim_ms, double ink_ms, double shade_ms);
+
+    double budget_ms() const { return budget_ms_; }
+    double avg_ms() const { return avg_ms_; }
+    int    level() const { return int(steps_.size()); }   // pasos de degradación aplicados
+    const std::string& last_change() const { return last_change_; }
+
+private:
+    enum Knob { KNOB_BLUR, KNOB_CULL, KNOB_DROPS };
+    struct Step { Knob knob; float prev; };
+
+    bool degrade(World& world, float t_now, double ink_share);
+    void restore(World& world, float t_now);
+
+    double budget_ms_, avg_ms_ = 0.0;
+    double over_ = 0.0, under_ = 0.0, cooldown_ = 0.0;   // s
+    int min_drops_, max_drops_;
+    bool at_floor_ = false;
+    std::vector<Step> steps_;
+    std::string last_change_;
+};
@@ -0,0 +1,56 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <ostream>
+#include <vector>
+
+// Diferencia entre dos imágenes ARGB8888 (acumulable sobre varios frames)
+struct ImageDiff {
+    double sq = 0; int max_rgb = 0; size_t diff_px = 0, px = 0;
+    void add(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b) { add(a.data(), b.data(), a.size()); }
+    void add(const uint32_t* a, const uint32_t* b, size_t n) {
+        for (size_t i = 0; i < n; ++i) {
+            bool differs = false;
+            for (int sh = 0; sh <= 16; sh += 8) {
+                int d = int((a[i] >> sh) & 255u) - int((b[i] >> sh) & 255u);
+                sq += double(d) * double(d);
+                max_rgb = std::max(max_rgb, std::abs(d));
+                differs |= d != 0;
+            }
+            diff_px += differs;
+        }
+        px += n;
+    }
+    double mse() const { return px ? sq / (3.0 * double(px)) : 0.0; }
+    double rms() const { return std::sqrt(mse()); }
+    // dB; infinito si las imágenes son idénticas
+    double psnr() const { return mse() > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / mse()) : INFINITY; }
+    void print(std::ostream& os) const {
+        os << "max|dRGB|=" << max_rgb << std::fixed << std::setprecision(3)
+           << ", px distintos=" << (px ? 100.0 * double(diff_px) / double(px) : 0.0) << "%, PSNR=";
+        if (mse() > 0.0) os << psnr() << " dB";
+        else             os << "inf";
+    }
+};
+
+// Diferencia entre planos float (H, tinta): máximo, RMS y valores no finitos.
+// Un NaN no entra en max_abs (std::max lo descarta), así que se cuenta aparte.
+struct PlaneDiff {
+    double sq = 0; float max_abs = 0.0f; size_t n = 0, nonfinite = 0;
+    // Por bits: con -ffast-math std::isfinite puede plegarse a true
+    static bool finite(float v) { uint32_t u; std::memcpy(&u, &v, 4); return (u & 0x7F800000u) != 0x7F800000u; }
+    void add(const float* a, const float* b, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            if (!finite(a[i]) || !finite(b[i])) { ++nonfinite; continue; }
+            const float d = std::abs(a[i] - b[i]);
+            max_abs = std::max(max_abs, d);
+            sq += double(d) * double(d);
+        }
+        n += count;
+    }
+    double rms() const { return n ? std::sqrt(sq / double(n)) : 0.0; }
+};
@@ -1,13 +1,85 @@
 #pragma once
 #include <vector>
+#include "arena.hpp"
 
 // Decaimiento + blur mezclado (difusión) por frame
 void ink_postprocess(
-    std::vector<float>& CR,
-    std::vector<float>& CG,
-    std::vector<float>& CB,
+    Plane& CR,
+    Plane& CG,
+    Plane& CB,
     int W, int H,
     float dt,
     float decay_lambda,  // s^-1
-    float blur_mix       // 0..1, mezcla de box blur 3x3
+    float blur_mix       // 0..1, mezcla de box blur 3x3 (la tinta queda en [0,1] también con 0)
 );
+
+struct CompactPlanes;   // compact.hpp
+
+// ink_postprocess que además empaqueta el frame a sombrear (H fp16 + tinta unorm16)
+// en su última pasada por fila: la conversión no relee los planos float de memoria
+void ink_postprocess_packed(
+    Plane& CR,
+    Plane& CG,
+    Plane& CB,
+    const Plane& Hf,
+    int W, int H,
+    float dt,
+    float decay_lambda,
+    float blur_mix,
+    CompactPlanes& out
+);
+
+// ---- Piezas para motores con su propio paralelismo (equipo persistente, work-stealing) ----
+// Mismas operaciones y mismo orden que ink_postprocess (decay, blur 3x3 sobre la tinta
+// ya decaída, mezcla), así cualquier reparto de filas da el mismo resultado bit a bit.
+// Factor de decay por frame
+float ink_decay_factor(float dt, float decay_lambda);
+
+// C *= kdec en las filas [y0, y1) (sin paralelismo propio)
+void ink_decay_rows(
+    Plane& CR,
+    Plane& CG,
+    Plane& CB,
+    int W,
+    int y0, int y1,
+    float kdec
+);
+
+// T = blur3x3(C) para las filas [y0, y1); lee las filas y0-1 .. y1 de C ya decaídas
+void ink_blur_rows(
+    const Plane& CR,
+    const Plane& CG,
+    const Plane& CB,
+    Plane& TR,
+    Plane& TG,
+    Plane& TB,
+    int W, int H,
+    int y0, int y1
+);
+
+// Mezcla de las filas [y0, y1): C = clamp((1-blur_mix)*C + blur_mix*T).
+// Con blur_mix <= 0 solo satura C a [0,1] (el camino clásico lo hace en el decay).
+void ink_blend_rows(
+    Plane& CR,
+    Plane& CG,
+    Plane& CB,
+    const Plane& TR,
+    const Plane& TG,
+    const Plane& TB,
+    int W,
+    int y0, int y1,
+    float blur_mix
+);
+
+// Referencia secuencial (ink.cpp)
+namespace seq {
+void ink_postprocess(
+    Plane& CR,
+    Plane& CG,
+    Plane& CB,
+    int W, int H,
+    float dt,
+    float decay_lambda,
+    float blur_mix
+);
+} // namespace seq
@@ -0,0 +1,12 @@
+#pragma once
+#include "config.hpp"
+
+// Benchmark headless (sin ventana) de los kernels, con la misma semilla en todos:
+//  - 'cfg.bench_frames' frames con dt fijo de 1/60 s: tabla ms/frame por kernel de
+//    los bucles OpenMP frente a tiles + work-stealing (speedup, robos, max|dH|),
+//    sincronización medida del motor de regiones frente al equipo persistente y
+//    el frame compacto (fp16/unorm16) frente al float;
+//  - a instantes fijos: --math fast frente a exact y con/sin --cull-eps (tiempo,
+//    error en H e imagen), costo del ciclo de vida con N grande y throughput de
+//    las variantes especializadas (tinta, paleta).
+int run_kernel_bench(const AppConfig& cfg);
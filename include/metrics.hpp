@@ -0,0 +1,90 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include "arena.hpp"
+
+// Métricas en vivo (--metrics PATH): un hilo servidor atiende un socket Unix y
+// responde con la exposición en formato OpenMetrics (texto; con cabecera HTTP si
+// el cliente manda "GET ...", p. ej. curl --unix-socket PATH http://x/metrics).
+//
+// El render solo hace push() de una muestra por frame a un anillo SPSC (copia +
+// store release, sin locks ni syscalls); el servidor lo vacía y es el único dueño
+// de los histogramas. Si el servidor se atrasa, la muestra se descarta y se cuenta.
+
+// Una muestra por frame presentado (ms; < 0 = no medido/no muestreado)
+struct FrameSample {
+    float  frame_ms = 0.0f;
+    float  sim_ms = -1.0f, ink_ms = -1.0f, shade_ms = -1.0f, present_ms = -1.0f;
+    int    drops = 0;
+    int    culled = -1;        // gotas bajo --cull-eps en todo el frame
+    int    threads = 1;
+    double px_drops = -1.0;    // píxeles que recorren los kernels de gotas (estimación)
+    float  ink_area = -1.0f;   // fracción del lienzo con tinta visible
+};
+
+class MetricsServer {
+public:
+    // Crea y escucha el socket (reemplaza uno viejo en PATH); lanza std::runtime_error
+    MetricsServer(const std::string& path, const std::string& program, int width, int height);
+    ~MetricsServer();
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    // Hilo del render: nunca bloquea
+    void push(const FrameSample& s);
+    // Hilo del render: true ~1 vez por segundo, para muestrear lo que cuesta O(N)
+    // u O(W*H) (trabajo de píxeles de las gotas, área con tinta)
+    bool want_scene();
+
+    std::string describe() const;
+
+private:
+    static constexpr size_t RING = 4096;     // potencia de 2 (~80 ms de margen a 50k frames/s)
+    static constexpr int    BUCKETS = 10;    // + "+Inf"
+    static constexpr int    STAGES = 4;      // sim, ink, shade, present
+    static constexpr size_t WINDOW = 1024;   // frames del resumen por percentiles
+
+    struct Histogram {
+        uint64_t count[BUCKETS + 1] = {};
+        uint64_t n = 0;
+        double   sum = 0.0;   // s
+        void observe(double s);
+    };
+
+    void run();
+    void drain();
+    std::string exposition() const;
+    void serve(int fd) const;
+
+    std::string path_, program_;
+    int width_, height_;
+    int listen_fd_ = -1;
+    uint64_t sock_dev_ = 0, sock_ino_ = 0;   // al cerrar solo se borra si PATH sigue siendo este socket
+
+    std::array<FrameSample, RING> ring_{};
+    alignas(64) std::atomic<uint64_t> head_{0};     // lo avanza el render
+    alignas(64) std::atomic<uint64_t> tail_{0};     // lo avanza el servidor
+    alignas(64) std::atomic<uint64_t> dropped_{0};  // muestras descartadas (anillo lleno)
+    std::chrono::steady_clock::time_point next_scene_;   // solo el render
+
+    // ---- Solo el hilo servidor ----
+    std::chrono::steady_clock::time_point t_start_;
+    uint64_t  frames_ = 0;
+    Histogram frame_, stage_[STAGES];
+    std::array<float, WINDOW> recent_{};   // últimos frame_ms
+    FrameSample last_{};                   // último valor de cada gauge
+    double px_drops_ = -1.0;
+    float  ink_area_ = -1.0f;
+
+    std::atomic<bool> stop_{false};
+    std::thread th_;
+};
+
+// Fracción de píxeles con tinta visible (mezcla del sombreado ink_strength*(r+g+b)
+// > thr), con una grilla de paso 'stride': ~W*H/stride² lecturas
+float ink_active_fraction(const Plane& CR, const Plane& CG, const Plane& CB, int W, int H,
+                          float ink_strength, int stride = 4, float thr = 0.05f);
@@ -4,13 +4,52 @@
 
 // Acumula campo H y, opcionalmente, inyecta tinta CR/CG/CB
 void accumulate_heightfield(
-    std::vector<float>& H,
-    std::vector<float>& CR,
-    std::vector<float>& CG,
-    std::vector<float>& CB,
+    Plane& H,
+    Plane& CR,
+    Plane& CG,
+    Plane& CB,
     int W, int Hh,
     const std::vector<Drop>& drops,
     float t_now,
     bool  ink_enabled,
-    float ink_gain
+    float ink_gain,
+    bool  fast_math = false,  // --math fast (solo versión paralela)
+    float cull_eps  = 0.0f,   // --cull-eps (solo versión paralela)
+    int   canvas_y0 = 0       // franja de un lienzo mayor: fila del lienzo de la fila 0 (muro MPI)
 );
+
+// Variante para el motor de equipo persistente: se llama DENTRO de una región
+// paralela ya abierta (omp for huérfano, sin barrera final) y no limpia H.
+void accumulate_heightfield_team(
+    Plane& H,
+    Plane& CR,
+    Plane& CG,
+    Plane& CB,
+    int W, int Hh,
+    const std::vector<Drop>& drops,
+    float t_now,
+    bool  ink_enabled,
+    float ink_gain,
+    bool  fast_math = false,  // --math fast (solo versión paralela)
+    float cull_eps  = 0.0f,   // --cull-eps (solo versión paralela)
+    int   canvas_y0 = 0
+);
+
+// Referencia secuencial (model_seq.cpp): un hilo, siempre exacta y sin culling.
+// Convive con la versión paralela en el mismo binario (--backend seq).
+namespace seq {
+void accumulate_heightfield(
+    Plane& H,
+    Plane& CR,
+    Plane& CG,
+    Plane& CB,
+    int W, int Hh,
+    const std::vector<Drop>& drops,
+    float t_now,
+    bool  ink_enabled,
+    float ink_gain,
+    bool  fast_math = false,  // ignorado
+    float cull_eps  = 0.0f,   // ignorado
+    int   canvas_y0 = 0
+);
+} // namespace seq
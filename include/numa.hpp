@@ -0,0 +1,34 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "arena.hpp"
+
+// Topología NUMA (Linux: /sys/devices/system/node). Si no hay información se
+// asume un solo nodo con todas las CPUs en línea.
+struct NumaTopology {
+    std::vector<std::vector<int>> node_cpus;   // CPUs por nodo
+    int num_cpus() const;
+    int node_of(int cpu) const;
+};
+
+NumaTopology read_numa_topology();
+std::string describe_topology(const NumaTopology& topo);
+
+// Fija cada hilo OpenMP a una CPU. mode: 1=compact (llena un nodo antes del
+// siguiente), 2=spread (reparte round-robin entre nodos). Devuelve el mapa
+// "hilo->cpu(nodo)" para el reporte, o el motivo si no se pudo.
+std::string pin_omp_threads(const NumaTopology& topo, int mode);
+
+// Primer toque paralelo de un plano W x H recién creado (todo ceros): se
+// descartan las páginas que tocó el hilo principal al construirlo y cada hilo
+// vuelve a escribir (ceros) las filas que le tocan con schedule(static), la misma
+// descomposición por filas que usan los kernels OpenMP. Así cada página queda en
+// el nodo del hilo que la va a recorrer en cada frame. Los planos de la arena ya
+// los tocó FrameArena::reserve con el mismo reparto: ahí no se hace nada.
+void first_touch_rows(Plane& plane, int W, int H);
+
+// Ubicación real del plano (move_pages): para cada hilo OpenMP, nodo de la página
+// de la fila central de su bloque schedule(static) contra el nodo de la CPU en la
+// que corre ese hilo. "nombre: k/T filas en el nodo de su hilo | t0 y=.. n0/n0 ..."
+std::string describe_placement(const char* name, const Plane& plane, int W, int H,
+                               const NumaTopology& topo);
@@ -0,0 +1,52 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Contadores de hardware por etapa (Linux perf_event_open).
+// Cada hilo del equipo OpenMP abre su propio grupo {cycles, instr, LLC-miss, br-miss};
+// begin()/end() se llaman desde el hilo principal entre etapas y leen todos los grupos.
+// Si el kernel no expone los contadores (perf_event_paranoid, contenedor, VM, otro SO)
+// open() devuelve false y el resto de llamadas son no-ops.
+enum PerfEvent { PC_CYCLES = 0, PC_INSTR, PC_LLC_MISS, PC_BR_MISS, PC_COUNT };
+
+struct PerfSample {
+    uint64_t v[PC_COUNT] = {};
+    bool     ok[PC_COUNT] = {};   // evento disponible en este hilo
+};
+
+class PerfCounters {
+public:
+    explicit PerfCounters(std::vector<std::string> stage_names);
+    ~PerfCounters();
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    // threads = hilos a instrumentar (1 en la versión secuencial)
+    bool open(int threads);
+    bool enabled() const { return enabled_; }
+    const std::string& status() const { return status_; }
+
+    void begin(int stage);
+    void end(int stage);
+    void frame_done() { if (enabled_) frames_++; }
+
+    // Imprime promedios por frame (IPC, LLC-miss, B/px) y reinicia acumuladores.
+    void report(size_t pixels_per_frame);
+
+private:
+    struct Group {
+        int fd[PC_COUNT] = {-1, -1, -1, -1};
+        int slot[PC_COUNT] = {-1, -1, -1, -1};  // posición en la lectura PERF_FORMAT_GROUP
+        int n = 0;
+    };
+    bool read_group(const Group& g, PerfSample& out) const;
+
+    std::vector<std::string> names_;
+    std::vector<Group> groups_;               // uno por hilo
+    std::vector<PerfSample> start_;           // [stage*threads + t]
+    std::vector<PerfSample> accum_;           // [stage*threads + t]
+    bool enabled_ = false;
+    std::string status_;
+    int frames_ = 0;
+};
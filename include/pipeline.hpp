@@ -0,0 +1,48 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "frame.hpp"
+#include "waves.hpp"
+
+// Pipeline de frames: un hilo simula el frame n+1 (respawn + H + tinta) mientras el
+// hilo principal sombrea/presenta el frame n. Los slots son buffers dobles (o más) de
+// H y tinta; 'depth' acota cuántos frames puede adelantarse la simulación.
+// El World pasa a ser propiedad del hilo de simulación mientras el pipeline corre.
+class FramePipeline {
+public:
+    FramePipeline(World& world, int depth, int sim_threads);
+    ~FramePipeline();
+    FramePipeline(const FramePipeline&) = delete;
+    FramePipeline& operator=(const FramePipeline&) = delete;
+
+    void start();
+    void stop();
+
+    // Bloquea hasta tener un frame simulado (nullptr si se detuvo).
+    FrameSlot* acquire();
+    // Devuelve el slot para que la simulación lo reutilice.
+    void release(FrameSlot* s);
+
+    int queued();   // frames listos esperando render
+    // Tiempo simulado del último frame que dejó el World (puede ir por delante del
+    // que se está mostrando); tras stop() es el instante del estado del World
+    float last_t_now();
+    int depth() const { return depth_; }
+
+private:
+    void sim_loop();
+
+    World& world_;
+    int depth_;
+    int sim_threads_;
+    std::vector<FrameSlot> slots_;
+    std::deque<FrameSlot*> free_, ready_;
+    std::mutex m_;
+    std::condition_variable cv_free_, cv_ready_;
+    bool stop_ = false;
+    float t_sim_ = 0.0f;   // bajo m_
+    std::thread th_;
+};
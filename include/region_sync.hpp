@@ -0,0 +1,63 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include <omp.h>
+
+// Sincronización medida del motor de regiones (una región OpenMP por kernel: gotas,
+// decay, blur, mezcla y sombreado). Por región y en media por hilo:
+//   fork     = entrada del hilo al cuerpo - apertura de la región
+//   barrera  = fin del último hilo - fin propio (espera en la barrera implícita)
+//   join     = vuelta al llamador - fin del último hilo
+// Mismas unidades que TeamStats (fork_join_ms, barrier_ms) para compararlos.
+struct RegionSyncStats {
+    double fork_join_ms = 0.0;
+    double barrier_ms   = 0.0;
+    int    regions      = 0;
+
+    double total_ms() const { return fork_join_ms + barrier_ms; }
+    void add(const RegionSyncStats& o) {
+        fork_join_ms += o.fork_join_ms; barrier_ms += o.barrier_ms; regions += o.regions;
+    }
+};
+
+// Mientras vive, las regiones que abren los kernels omp desde este hilo se miden y
+// se acumulan aquí (sin sonda no se mide nada). Se anidan: gana la más interna.
+class RegionProbe {
+public:
+    RegionProbe();
+    ~RegionProbe();
+    RegionProbe(const RegionProbe&) = delete;
+    RegionProbe& operator=(const RegionProbe&) = delete;
+
+    // Acumulado desde la última llamada (y lo pone a cero)
+    RegionSyncStats take();
+
+private:
+    friend class RegionTimer;
+    RegionProbe* prev_;
+    RegionSyncStats acc_;
+};
+
+// Uso dentro de un kernel (el for con nowait: la barrera que cuenta es la del final
+// de la región):
+//   RegionTimer rt;
+//   #pragma omp parallel
+//   {
+//       rt.enter();
+//       #pragma omp for nowait
+//       for (...) ...
+//       rt.leave();
+//   }
+//   rt.close();
+class RegionTimer {
+public:
+    RegionTimer();
+    void enter() { if (probe_) start_[std::size_t(omp_get_thread_num())] = omp_get_wtime(); }
+    void leave() { if (probe_) end_[std::size_t(omp_get_thread_num())] = omp_get_wtime(); }
+    void close();
+
+private:
+    RegionProbe* probe_;
+    double t_open_ = 0.0;
+    std::vector<double> start_, end_;
+};
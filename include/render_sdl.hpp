@@ -1,6 +1,111 @@
 #pragma once
 #include <SDL.h>
+#include <string>
 #include "shading.hpp"
 
-// Helpers mínimos de render (separado por claridad).
-// Ya usamos shade_and_present() para pintar y SDL_RenderCopy dentro de esa función.
+// Helpers de SDL del frontend: las texturas de streaming y el "lock + sombrear +
+// copiar" sobre el sombreado en memoria de shading.hpp (la biblioteca no usa SDL).
+
+// --upload: cómo llegan los píxeles sombreados a la textura
+enum UploadMode {
+    UPLOAD_LOCK   = 0,   // sombrear directo en la textura bloqueada
+    UPLOAD_UPDATE = 1,   // sombrear en un staging alineado + SDL_UpdateTexture
+    UPLOAD_THREAD = 2    // staging doble; un hilo lo copia a la textura bloqueada mientras se presenta
+};
+
+class UploadThread;   // render_sdl.cpp
+
+// Anillo de 1..3 texturas de streaming (--textures): cada frame se escribe la
+// siguiente, así el lock no espera a que termine la subida/dibujo del frame anterior.
+struct PixelBuffer {
+    SDL_Texture* tex = nullptr;      // última textura completa (la que se copia al renderer)
+    SDL_Texture* ring[3] = {};
+    int textures = 1, next = 0;
+    int w=0, h=0;
+    Uint32 format = SDL_PIXELFORMAT_ARGB8888;
+
+    int upload = UPLOAD_LOCK;
+    uint32_t* staging[2] = {};       // alineados a 64 B, filas de staging_pitch bytes
+    int staging_pitch = 0, staging_cur = 0;
+    SDL_Texture* inflight = nullptr; // UPLOAD_THREAD: bloqueada, la está copiando el hilo
+    UploadThread* uploader = nullptr;
+
+    // --profile: ticks de SDL_GetPerformanceCounter desde el último upload_profile()
+    Uint64 lock_ticks = 0, update_ticks = 0, wait_ticks = 0;
+    int stat_frames = 0;
+};
+
+// textures en 1..3; con UPLOAD_THREAD hacen falta al menos 2
+bool create_pixel_buffer(SDL_Renderer* r, int w, int h, PixelBuffer& out,
+                         int textures = 1, int upload = UPLOAD_LOCK);
+// Espera la copia en curso, desbloquea y libera texturas y staging
+void destroy_pixel_buffer(PixelBuffer& pb);
+
+// Bloquea la siguiente textura del anillo (midiendo la espera en lock_ticks)
+bool lock_next_texture(PixelBuffer& pb, SDL_Texture*& t, void** pixels, int* pitch);
+// Sube pb.staging[pb.staging_cur] según pb.upload y la copia al renderer. Con
+// UPLOAD_THREAD se copia el frame anterior: la subida de este corre en el hilo
+// durante el present (un frame de latencia).
+void present_staging(SDL_Renderer* renderer, PixelBuffer& pb);
+// "lock=... ms[, update=... ms][, espera-copia=... ms]" por frame desde la última llamada
+std::string upload_profile(PixelBuffer& pb);
+
+// fill(pixels, pitch) escribe ARGB8888 en la siguiente textura del anillo (o en el
+// staging) y se copia al renderer. Si no se puede bloquear, limpia a un color de fondo.
+template <class Fill>
+inline void shade_into_texture(SDL_Renderer* renderer, PixelBuffer& pb, Fill&& fill)
+{
+    pb.stat_frames++;
+    if (pb.upload != UPLOAD_LOCK) {
+        fill(pb.staging[pb.staging_cur], pb.staging_pitch);
+        present_staging(renderer, pb);
+        return;
+    }
+    SDL_Texture* t=nullptr; void* pixels=nullptr; int pitch=0;
+    if (!lock_next_texture(pb, t, &pixels, &pitch)) {
+        SDL_SetRenderDrawColor(renderer, 10,14,22,255);
+        SDL_RenderClear(renderer);
+        return;
+    }
+    fill(static_cast<uint32_t*>(pixels), pitch);
+    SDL_UnlockTexture(t);
+    pb.tex = t;
+    SDL_RenderCopy(renderer, t, nullptr, nullptr);
+}
+
+// Sombrea los planos float y presenta (kernels paralelos)
+inline void shade_and_present(SDL_Renderer* renderer, PixelBuffer& pb,
+                              const Plane& H, const Plane& CR, const Plane& CG, const Plane& CB,
+                              float slopeScale, int palette_mode, bool ink_enabled, float ink_strength,
+                              bool fast_math = false)     // --math fast (solo versión paralela)
+{
+    ShadeInputs in{ H.data(), CR.data(), CG.data(), CB.data(), pb.w, pb.h,
+                    slopeScale, palette_mode, ink_enabled, ink_strength };
+    in.fast_math = fast_math;
+    shade_into_texture(renderer, pb, [&](uint32_t* px, int pitch) { shade_frame(in, px, pitch); });
+}
+
+// Igual, leyendo el frame compacto (H fp16 + tinta unorm16); solo versión paralela
+inline void shade_and_present(SDL_Renderer* renderer, PixelBuffer& pb, const CompactPlanes& C,
+                              float slopeScale, int palette_mode, bool ink_enabled, float ink_strength,
+                              bool fast_math = false)
+{
+    ShadeInputs in{ nullptr, nullptr, nullptr, nullptr, pb.w, pb.h,
+                    slopeScale, palette_mode, ink_enabled, ink_strength };
+    in.fast_math = fast_math;
+    in.H16 = C.H.data(); in.CR16 = C.CR.data(); in.CG16 = C.CG.data(); in.CB16 = C.CB.data();
+    shade_into_texture(renderer, pb, [&](uint32_t* px, int pitch) { shade_frame(in, px, pitch); });
+}
+
+namespace seq {
+// Referencia secuencial: siempre planos float y matemática exacta
+inline void shade_and_present(SDL_Renderer* renderer, PixelBuffer& pb,
+                              const Plane& H, const Plane& CR, const Plane& CG, const Plane& CB,
+                              float slopeScale, int palette_mode, bool ink_enabled, float ink_strength,
+                              bool /*fast_math: ignorado*/ = false)
+{
+    const ShadeInputs in{ H.data(), CR.data(), CG.data(), CB.data(), pb.w, pb.h,
+                          slopeScale, palette_mode, ink_enabled, ink_strength };
+    shade_into_texture(renderer, pb, [&](uint32_t* px, int pitch) { seq::shade_frame(in, px, pitch); });
+}
+} // namespace seq
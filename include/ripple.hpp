@@ -0,0 +1,65 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "backend.hpp"
+#include "checkpoint.hpp"
+#include "drop_log.hpp"
+#include "waves.hpp"
+
+// API embebible de la biblioteca ripple (sin SDL): el llamador avanza la simulación
+// y pide el sombreado en su propio buffer ARGB8888 (0xAARRGGBB por uint32_t, filas
+// separadas por 'pitch' bytes). El kernel escribe directo en ese buffer: sirve una
+// textura bloqueada, un framebuffer mapeado o la memoria de un compositor, sin copia.
+//
+//   AppConfig cfg; cfg.width = 1280; cfg.height = 720; cfg.N = 4000;
+//   RippleEngine eng(cfg);
+//   for (;;) { eng.step(1.0f / 60.0f); eng.shade(fb, fb_pitch); }
+//
+// Los planos WxH salen de FrameArena si el llamador la reservó antes (si no, del heap).
+class RippleEngine {
+public:
+    // Crea el World e inicializa las gotas en t = 0 (con cfg.record, grabando desde
+    // ese primer lote; con cfg.restore, escena y estado salen del checkpoint). El backend (cfg.backend) se crea en el primer paso o con
+    // set_backend(); lanza std::runtime_error si la especificación no es válida.
+    explicit RippleEngine(const AppConfig& cfg);
+    ~RippleEngine();
+
+    // Avanza dt segundos: respawn, gotas -> H (+ tinta) y difusión/decay de la tinta
+    void step(float dt);
+    // Igual con el reloj del llamador (t_now en s desde la creación)
+    void step_at(float t_now, float dt);
+
+    // Etapas sueltas de step_at, para medirlas por separado
+    void respawn(float t_now);
+    void accumulate();
+    void ink(float dt);
+
+    // Sombrea el estado actual en pixels (W x H, pitch >= 4*W bytes)
+    void shade(uint32_t* pixels, int pitch);
+
+    // --record: cierra la grabación (DropLogEnd) y devuelve el resumen; "" si no hay.
+    // Lanza std::runtime_error si falló la escritura. El destructor la cierra si no.
+    std::string close_recording();
+
+    // --checkpoint: guarda el estado en el tiempo actual (lanza si falla la escritura)
+    void checkpoint(const std::string& path) const;
+    // --restore: resumen de la carga (tamaño y ms); "" si se arrancó vacío
+    const std::string& restore_info() const { return restore_info_; }
+
+    void set_backend(const std::string& spec);
+    ComputeBackend& backend();
+
+    World& world() { return world_; }
+    const World& world() const { return world_; }
+    float time() const { return t_; }
+    int width() const { return world_.cfg.width; }
+    int height() const { return world_.cfg.height; }
+
+private:
+    World world_;
+    std::unique_ptr<ComputeBackend> backend_;
+    std::unique_ptr<DropRecorder> recorder_;
+    std::string restore_info_;
+    float t_ = 0.0f;
+};
@@ -0,0 +1,196 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include "waves.hpp"
+#include "fast_math.hpp"
+
+// Kernel por gota compartido por los backends paralelos (misma matemática que
+// model_seq.cpp). Se parte en dos: la banda de influencia de la gota y el
+// "splat" sobre un rectángulo, para que los backends por tiles recorten cada
+// gota a su tile sin duplicar la fórmula.
+
+// Hash 2D igual que en waves.cpp para el jitter
+static inline float hash2(int x, int y){
+    uint32_t h = uint32_t(x)*374761393u + uint32_t(y)*668265263u;
+    h = (h ^ (h >> 13u)) * 1274126177u;
+    return float((h ^ (h >> 16u)) & 0x00FFFFFFu) / float(0x01000000);
+}
+
+struct DropBand {
+    float tau, ring;
+    float rmin, rmax;
+    float rmin2, rmax2;
+    int xmin, xmax, ymin, ymax;   // bbox recortada a la imagen (inclusive)
+};
+
+// false si la gota aún no impactó o su banda no toca la imagen. Con cull_eps > 0
+// la banda se recorta a donde el aporte supera eps (drop_cull_range) y una gota
+// invisible devuelve false; ink_gain = 0 si la tinta está apagada.
+// canvas_y0: fila del lienzo de la fila 0 de la imagen (franja del muro MPI); las
+// gotas siguen en coordenadas del lienzo y la bbox sale en filas de la imagen.
+static inline bool drop_band(const Drop& d, float t_now, int W, int Hh, DropBand& b,
+                             float cull_eps = 0.0f, float ink_gain = 0.0f, int canvas_y0 = 0) {
+    b.tau = t_now - d.t0;
+    if (b.tau <= 0.0f) return false;
+
+    b.ring = d.c * b.tau;
+
+    // Banda de influencia
+    const float band = drop_band_halfwidth(d);
+
+    b.rmin = std::max(0.0f, b.ring - band);
+    b.rmax = b.ring + band;
+    if (cull_eps > 0.0f) {
+        float lo, hi;
+        if (!drop_cull_range(d, b.tau, cull_eps, ink_gain, lo, hi)) return false;
+        b.rmin = std::max(b.rmin, lo);
+        b.rmax = std::min(b.rmax, hi);
+        if (b.rmin >= b.rmax) return false;
+    }
+    b.rmin2 = b.rmin*b.rmin;
+    b.rmax2 = b.rmax*b.rmax;
+
+    b.xmin = std::max(0, int(std::floor(d.x - b.rmax - 2)));
+    b.xmax = std::min(W-1, int(std::ceil (d.x + b.rmax + 2)));
+    b.ymin = std::max(0, int(std::floor(d.y - b.rmax - 2)) - canvas_y0);
+    b.ymax = std::min(Hh-1, int(std::ceil (d.y + b.rmax + 2)) - canvas_y0);
+    return b.xmin <= b.xmax && b.ymin <= b.ymax;
+}
+
+// Aporte de la gota a los píxeles [x0,x1]x[y0,y1] (inclusive) de su banda.
+// Atomic=true cuando varias gotas se reparten entre hilos sobre la misma imagen;
+// Atomic=false cuando cada hilo es dueño exclusivo del rectángulo (tiles).
+// Ink/Splash quedan fijos en compilación: el bucle interno no tiene ramas por
+// tinta ni por splash (la gran mayoría de las gotas vivas ya pasó su splash).
+// M = ExactMath | FastMath (--math): exp aproximada y corona del splash sin trigonometría.
+template <bool Atomic, bool Ink, bool Splash, class M = ExactMath>
+static inline void splat_drop_kernel(
+    float* H, float* CR, float* CG, float* CB, int W,
+    const Drop& d, const DropBand& b,
+    int x0, int x1, int y0, int y1,
+    float ink_gain, int canvas_y0)
+{
+    const float tau = b.tau, ring = b.ring;
+    const size_t P = size_t(plane_pitch(W));   // paso entre filas de los planos
+    // cos(m*ang + phi) = Re[(c + i s)^m * e^(i phi)] con (c, s) = (dx, dy)/r
+    const float cphi = (Splash && M::fast) ? std::cos(d.splash_phi) : 0.0f;
+    const float sphi = (Splash && M::fast) ? std::sin(d.splash_phi) : 0.0f;
+    for (int y=y0; y<=y1; ++y) {
+        const int yc = y + canvas_y0;     // fila del lienzo (posición y jitter)
+        float fy = float(yc) + 0.5f;
+        float dy = fy - d.y;
+        for (int x=x0; x<=x1; ++x) {
+            float fx = float(x) + 0.5f;
+            float dx = fx - d.x;
+            float dist2 = dx*dx + dy*dy;
+            if (dist2 < b.rmin2 || dist2 > b.rmax2) continue;
+
+            float dist = std::sqrt(dist2);
+
+            // micro-jitter al radio
+            dist += (hash2(x,yc) - 0.5f) * 0.35f;
+
+            // ---- Derivada de Gauss como perfil principal ----
+            float s     = (dist - ring) / std::max(1e-3f, d.sigma);
+            float env   = M::exp(-0.5f * s*s);
+            float dgauss= -s * env;
+            float att   = 1.0f / std::sqrt(1.0f + 0.015f * dist);
+            float damp  = M::exp(- d.alpha * tau);
+            float main  = d.A0 * damp * dgauss * att;
+
+            // ---- Capilares ----
+            float cap = 0.0f;
+            {
+                float s1 = (dist - (ring - d.cap_delta)) / std::max(1e-3f, d.cap_sigma);
+                float s2 = (dist - (ring + d.cap_delta)) / std::max(1e-3f, d.cap_sigma);
+                float g1 = -s1 * M::exp(-0.5f*s1*s1);
+                float g2 = -s2 * M::exp(-0.5f*s2*s2);
+                float damp_c = M::exp(- (d.alpha*1.25f) * tau);
+                cap = d.cap_gain * d.A0 * damp_c * 0.5f * (g1 + g2) * att;
+            }
+
+            // ---- Splash (breve) ----
+            float splash = 0.0f;
+            if constexpr (Splash) {
+                float rho = d.splash_r0;
+                float r2  = (dist2)/(2.0f*rho*rho);
+                float crown;
+                if constexpr (M::fast) {
+                    float c = 1.0f, sn = 0.0f;               // atan2(0, 0) = 0
+                    if (dist2 > 1e-12f) { float inv = 1.0f / std::sqrt(dist2); c = dx*inv; sn = dy*inv; }
+                    float pr = 1.0f, pi = 0.0f;
+                    for (int k = 0; k < d.splash_m; ++k) {
+                        float t = pr*c - pi*sn;
+                        pi = pr*sn + pi*c;
+                        pr = t;
+                    }
+                    crown = 1.0f + 0.25f * (pr*cphi - pi*sphi);
+                } else {
+                    float ang = std::atan2(dy, dx);
+                    crown = 1.0f + 0.25f * std::cos(d.splash_m * ang + d.splash_phi);
+                }
+                splash = d.splash_amp * M::exp(- d.splash_decay * tau) * M::exp(-r2) * crown;
+            }
+
+            size_t idx = size_t(y)*P + size_t(x);
+            float hv = main + cap + splash;
+            if constexpr (Atomic) {
+                #pragma omp atomic
+                H[idx] += hv;
+            } else {
+                H[idx] += hv;
+            }
+
+            // ---- Tinta: solo la envolvente (sin oscilación) ----
+            if constexpr (Ink) {
+                float ink_w = ink_gain * damp *
+                              M::exp(-0.5f * ((dist - ring)*(dist - ring)) /
+                                       (std::max(1e-3f, d.sigma)*std::max(1e-3f, d.sigma))) *
+                              att;
+                float ir = ink_w * d.col_r, ig = ink_w * d.col_g, ib = ink_w * d.col_b;
+                if constexpr (Atomic) {
+                    #pragma omp atomic
+                    CR[idx] += ir;
+                    #pragma omp atomic
+                    CG[idx] += ig;
+                    #pragma omp atomic
+                    CB[idx] += ib;
+                } else {
+                    CR[idx] += ir;
+                    CG[idx] += ig;
+                    CB[idx] += ib;
+                }
+            }
+        }
+    }
+}
+
+// Elige la variante una vez por gota (tinta por frame, splash según su tau)
+template <bool Atomic, class M>
+static inline void splat_drop_rect_m(
+    float* H, float* CR, float* CG, float* CB, int W,
+    const Drop& d, const DropBand& b,
+    int x0, int x1, int y0, int y1,
+    bool ink_enabled, float ink_gain, int canvas_y0)
+{
+    const bool splash = b.tau <= TAU_SPLASH_MAX;
+    if (ink_enabled) {
+        if (splash) splat_drop_kernel<Atomic, true,  true,  M>(H, CR, CG, CB, W, d, b, x0, x1, y0, y1, ink_gain, canvas_y0);
+        else        splat_drop_kernel<Atomic, true,  false, M>(H, CR, CG, CB, W, d, b, x0, x1, y0, y1, ink_gain, canvas_y0);
+    } else {
+        if (splash) splat_drop_kernel<Atomic, false, true,  M>(H, CR, CG, CB, W, d, b, x0, x1, y0, y1, ink_gain, canvas_y0);
+        else        splat_drop_kernel<Atomic, false, false, M>(H, CR, CG, CB, W, d, b, x0, x1, y0, y1, ink_gain, canvas_y0);
+    }
+}
+
+template <bool Atomic>
+static inline void splat_drop_rect(
+    float* H, float* CR, float* CG, float* CB, int W,
+    const Drop& d, const DropBand& b,
+    int x0, int x1, int y0, int y1,
+    bool ink_enabled, float ink_gain, bool fast_math = false, int canvas_y0 = 0)
+{
+    if (fast_math) splat_drop_rect_m<Atomic, FastMath >(H, CR, CG, CB, W, d, b, x0, x1, y0, y1, ink_enabled, ink_gain, canvas_y0);
+    else           splat_drop_rect_m<Atomic, ExactMath>(H, CR, CG, CB, W, d, b, x0, x1, y0, y1, ink_enabled, ink_gain, canvas_y0);
+}
@@ -1,14 +1,46 @@
 #pragma once
+#include <array>
+#include <cstdint>
 #include <random>
 
-struct RNG {
-    std::mt19937 gen;
-    std::uniform_real_distribution<float> U{0.0f,1.0f};
+// Semilla de la simulación: --seed S, o random_device con S < 0
+inline uint64_t resolve_seed(int seed) {
+    if (seed >= 0) return uint64_t(seed);
+    std::random_device rd;
+    return (uint64_t(rd()) << 32) | rd();
+}
 
-    RNG(int seed) {
-        if (seed < 0) { std::random_device rd; gen.seed(rd()); }
-        else          { gen.seed(static_cast<uint32_t>(seed)); }
+// Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3"):
+// bloque de 4 palabras = función pura de (clave, contador). Sin estado compartido.
+using Philox4 = std::array<uint32_t, 4>;
+
+inline Philox4 philox4x32(Philox4 c, uint32_t k0, uint32_t k1) {
+    for (int r = 0; r < 10; ++r) {
+        const uint64_t p0 = uint64_t(0xD2511F53u) * c[0];
+        const uint64_t p1 = uint64_t(0xCD9E8D57u) * c[2];
+        c = { uint32_t(p1 >> 32) ^ c[1] ^ k0, uint32_t(p1),
+              uint32_t(p0 >> 32) ^ c[3] ^ k1, uint32_t(p0) };
+        k0 += 0x9E3779B9u; k1 += 0xBB67AE85u;
+    }
+    return c;
+}
+
+// Números de un respawn: clave = semilla, contador = (gota, generación, bloque).
+// Cualquier hilo obtiene los mismos valores para la misma gota y generación, así
+// que la escena no depende del orden ni de OMP_NUM_THREADS. 24 bits por float.
+struct DropRNG {
+    uint32_t k0, k1, id, gen, block = 0;
+    Philox4 buf{};
+    int used = 4;
+
+    DropRNG(uint64_t seed, uint32_t id_, uint32_t gen_)
+    : k0(uint32_t(seed)), k1(uint32_t(seed >> 32)), id(id_), gen(gen_) {}
+
+    inline uint32_t next() {
+        if (used == 4) { buf = philox4x32({id, gen, block++, 0u}, k0, k1); used = 0; }
+        return buf[size_t(used++)];
     }
-    inline float rb(float a, float b) { return a + (b-a)*U(gen); }
-    inline int   rbi(int a, int b)    { return a + int((b-a+1)*U(gen)); }
+    inline float u()                  { return float(next() >> 8) * (1.0f / 16777216.0f); }  // [0,1)
+    inline float rb(float a, float b) { return a + (b-a)*u(); }
+    inline int   rbi(int a, int b)    { return a + int((b-a+1)*u()); }
 };
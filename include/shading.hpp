@@ -1,25 +1,44 @@
 #pragma once
-#include <SDL.h>
+#include <cstdint>
 #include <vector>
+#include "arena.hpp"
+#include "compact.hpp"
 
-struct PixelBuffer {
-    SDL_Texture* tex = nullptr;
-    int w=0, h=0;
-    Uint32 format = SDL_PIXELFORMAT_ARGB8888;
+// Sombreado “agua” con Fresnel/reflexión y tinta opcional, sin SDL: escribe ARGB8888
+// en memoria del llamador (textura bloqueada, buffer propio, framebuffer externo...).
+
+// Entradas del sombreado por filas (motores con su propia región paralela). Los planos
+// tienen filas de plane_pitch(W) elementos; el buffer ARGB, su propio pitch en bytes.
+struct ShadeInputs {
+    const float* H;
+    const float* CR;
+    const float* CG;
+    const float* CB;
+    int W, Hh;
+    float slopeScale;
+    int palette_mode;
+    bool ink_enabled;
+    float ink_strength;
+    // Frame compacto (--storage compact): si H16 no es nulo se lee de aquí
+    const uint16_t* H16  = nullptr;
+    const uint16_t* CR16 = nullptr;
+    const uint16_t* CG16 = nullptr;
+    const uint16_t* CB16 = nullptr;
+    bool fast_math = false;    // --math fast: exp/pow/tanh aproximadas (fast_math.hpp)
+    // Franja de un lienzo mayor (muro MPI): fila del lienzo de la fila 0 y alto del
+    // lienzo para la viñeta; canvas_h = 0 -> el frame es el lienzo
+    int canvas_y0 = 0, canvas_h = 0;
 };
 
-bool create_pixel_buffer(SDL_Renderer* r, int w, int h, PixelBuffer& out);
+// Sombrea los píxeles [x0, x1) de la fila y en 'row' (ARGB8888, row apunta al inicio de la fila)
+void shade_span(const ShadeInputs& in, int y, int x0, int x1, uint32_t* row);
+// Fila completa
+void shade_row(const ShadeInputs& in, int y, uint32_t* row);
+// Frame completo (omp parallel for por filas); pitch en bytes (>= 4*W)
+void shade_frame(const ShadeInputs& in, uint32_t* pixels, int pitch);
 
-// Sombrado “agua” con Fresnel/reflexión y tinta opcional
-void shade_and_present(
-    SDL_Renderer* renderer,
-    PixelBuffer& pb,
-    const std::vector<float>& H,
-    const std::vector<float>& CR,
-    const std::vector<float>& CG,
-    const std::vector<float>& CB,
-    float slopeScale,
-    int palette_mode,
-    bool ink_enabled,
-    float ink_strength
-);
+// Referencia secuencial (shading.cpp): lee siempre los planos float, sin --math fast
+namespace seq {
+void shade_row(const ShadeInputs& in, int y, uint32_t* row);
+void shade_frame(const ShadeInputs& in, uint32_t* pixels, int pitch);
+} // namespace seq
@@ -0,0 +1,111 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "config.hpp"
+
+// Anillo de frames en memoria compartida POSIX (shm_open + mmap) para entregar los
+// frames sombreados a otro proceso local sin copias ni sistema de ventanas.
+//
+// Segmento (/NOMBRE en /dev/shm):
+//   [ShmRingHeader, 4 KiB] [slot 0] [slot 1] ... [slot slots-1]
+//   slot = [ShmSlotHeader, 4 KiB] [píxeles: height filas de 'stride' bytes]
+// Píxeles ARGB8888 (uint32 0xAARRGGBB en orden nativo), stride múltiplo de 64 B.
+//
+// Protocolo (un escritor, N lectores, el escritor nunca espera):
+//  - el frame f (1, 2, ...) va al slot (f-1) % slots;
+//  - el escritor pone slot.lock = 2f-1 (impar: escribiendo), escribe píxeles y
+//    metadatos, pone slot.lock = 2f (release) y luego header.latest = f;
+//  - el lector lee latest, lock (acquire) == 2*latest, usa los píxeles en el mismo
+//    mapeo y al terminar comprueba que lock no cambió (si cambió, el escritor le dio
+//    la vuelta al anillo y el frame se descarta). Con 'slots' slots el lector tiene
+//    slots-1 frames de margen.
+constexpr char     SHM_RING_MAGIC[8] = {'R','I','P','S','H','M','0','1'};
+constexpr uint32_t SHM_RING_VERSION  = 1;
+constexpr uint32_t SHM_FORMAT_ARGB8888 = 0x34325241;   // fourcc 'AR24' (como DRM)
+
+struct ShmRingHeader {
+    char     magic[8];
+    uint32_t version;
+    uint32_t format;            // SHM_FORMAT_ARGB8888
+    uint32_t width, height;
+    uint32_t stride;            // bytes por fila
+    uint32_t slots;
+    uint64_t slot_offset;       // desde el inicio del segmento al slot 0
+    uint64_t slot_bytes;        // distancia entre slots
+    uint64_t pixel_offset;      // desde el inicio del slot a los píxeles
+    int64_t  writer_pid;
+    std::atomic<uint64_t> latest;   // último frame publicado (0 = ninguno)
+};
+
+struct ShmSlotHeader {
+    std::atomic<uint64_t> lock;     // 2f-1 escribiendo el frame f, 2f publicado
+    uint64_t frame;                 // f
+    uint64_t t_ns;                  // steady_clock (CLOCK_MONOTONIC) al publicar, ns
+    float    t_sim;                 // tiempo de simulación (s)
+    uint32_t width, height, stride;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "el anillo necesita atómicos de 64 bits sin lock");
+
+// Lado productor: crea (o reemplaza) el segmento; lo desmapea y borra al destruirse.
+class ShmRingWriter {
+public:
+    ShmRingWriter(const std::string& name, int W, int H, int slots);
+    ~ShmRingWriter();
+    ShmRingWriter(const ShmRingWriter&) = delete;
+    ShmRingWriter& operator=(const ShmRingWriter&) = delete;
+
+    // Abre el siguiente frame: devuelve los píxeles del slot (pitch = stride)
+    uint32_t* begin_frame(int& pitch);
+    // Publica el frame abierto con begin_frame
+    void publish(float t_sim);
+
+    const std::string& name() const { return name_; }
+    uint64_t frames() const { return frame_; }
+    size_t   bytes() const { return size_; }
+
+private:
+    ShmSlotHeader* slot(uint64_t f) const;
+
+    std::string name_;
+    unsigned char* base_ = nullptr;
+    size_t size_ = 0;
+    ShmRingHeader* hdr_ = nullptr;
+    uint64_t frame_ = 0;        // último frame abierto
+};
+
+// Frame leído: apunta directo al segmento (válido mientras still_valid())
+struct ShmFrameView {
+    const uint32_t* pixels = nullptr;
+    int width = 0, height = 0, pitch = 0;
+    uint64_t frame = 0, t_ns = 0;
+    float t_sim = 0.0f;
+    const ShmSlotHeader* slot = nullptr;
+};
+
+// Lado consumidor (solo lectura)
+class ShmRingReader {
+public:
+    explicit ShmRingReader(const std::string& name);
+    ~ShmRingReader();
+    ShmRingReader(const ShmRingReader&) = delete;
+    ShmRingReader& operator=(const ShmRingReader&) = delete;
+
+    // Último frame publicado con número > after; false si no hay uno nuevo estable
+    bool latest(ShmFrameView& out, uint64_t after = 0) const;
+    // true si el slot no fue reescrito desde latest() (llamar después de usar los píxeles)
+    bool still_valid(const ShmFrameView& v) const;
+
+    const ShmRingHeader& header() const { return *hdr_; }
+
+private:
+    const unsigned char* base_ = nullptr;
+    size_t size_ = 0;
+    const ShmRingHeader* hdr_ = nullptr;
+};
+
+// Modo headless: simula en tiempo real a --shm-fps y publica cada frame en el anillo
+// cfg.shm_name hasta --shm-frames frames o SIGINT/SIGTERM.
+int run_shm(const AppConfig& cfg);
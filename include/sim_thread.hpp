@@ -0,0 +1,45 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include "frame.hpp"
+#include "triple_buffer.hpp"
+#include "waves.hpp"
+
+// Hilo de simulación a paso fijo (cfg.sim_hz): avanza el World con dt = 1/sim_hz,
+// independiente del render/vsync, y publica cada frame completo en un triple buffer.
+// El hilo de render solo toma el último frame (fetch), lo sombrea y presenta.
+class SimThread {
+public:
+    explicit SimThread(World& world);
+    ~SimThread();
+    SimThread(const SimThread&) = delete;
+    SimThread& operator=(const SimThread&) = delete;
+
+    void start();
+    void stop();
+
+    // Lado render: true si hay un frame nuevo desde el último fetch
+    bool fetch() { return tb_.fetch(); }
+    const FrameSlot& latest() const { return tb_.read_buffer(); }
+
+    // Estadísticas acumuladas (lectura relajada desde el render)
+    uint64_t steps()   const { return steps_.load(std::memory_order_relaxed); }
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }  // frames pisados sin mostrarse
+    uint64_t late()    const { return late_.load(std::memory_order_relaxed); }     // pasos fuera de plazo
+    float    hz()      const { return hz_; }
+    // Tiempo simulado del último paso que dejó el World (puede ir por delante del
+    // frame que el render tomó); tras stop() es el instante del estado del World
+    float last_t_now() const { return t_sim_.load(std::memory_order_acquire); }
+
+private:
+    void loop();
+
+    World& world_;
+    float hz_;
+    TripleBuffer<FrameSlot> tb_;
+    std::atomic<bool> stop_{false};
+    std::atomic<uint64_t> steps_{0}, dropped_{0}, late_{0};
+    std::atomic<float> t_sim_{0.0f};
+    std::thread th_;
+};
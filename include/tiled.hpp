@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "ripple_kernel.hpp"
+#include "waves.hpp"
+#include "ws_pool.hpp"
+
+// Backend por tiles sobre el pool de work-stealing.
+//  - Gotas: cada frame se "binnean" las gotas en tiles de TILE x TILE según su
+//    anillo; cada tarea es dueña exclusiva de su tile (limpia H y suma sin atómicos,
+//    en orden de índice de gota: resultado determinista). El costo por tile es muy
+//    irregular (anillos de tamaños muy distintos): ahí es donde roba el pool.
+//  - Tinta: blur+decay y mezcla por bloques de filas.
+//  - Sombreado: tiles TILE x TILE (costo uniforme).
+class TiledBackend {
+public:
+    static constexpr int TILE = 64;
+
+    TiledBackend(const AppConfig& cfg, WorkStealingPool& pool);
+
+    void accumulate(World& world, float t_now);
+    void ink(World& world, float dt);
+    void shade(const World& world, uint32_t* pixels, int pitch);
+
+    // Promedio de gotas por tile no vacío del último frame (diagnóstico)
+    double drops_per_tile() const { return drops_per_tile_; }
+
+private:
+    WorkStealingPool& pool_;
+    int W_, H_, tilesX_, tilesY_;
+    std::vector<DropBand> bands_;
+    std::vector<uint8_t> live_;                 // banda válida por gota
+    std::vector<std::vector<int>> bins_;        // gotas por tile (orden creciente)
+    Plane TR, TG, TB;              // blur de tinta
+    double drops_per_tile_ = 0.0;
+};
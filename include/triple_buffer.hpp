@@ -0,0 +1,40 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// Triple buffer lock-free (1 escritor, 1 lector).
+// El escritor siempre tiene un buffer propio (back), el lector otro (front) y el
+// tercero (shared) se intercambia con un único exchange atómico. El bit DIRTY indica
+// que 'shared' contiene un frame aún no leído.
+template <class T>
+class TripleBuffer {
+public:
+    // Acceso directo para inicializar los tres buffers antes de arrancar los hilos
+    T& at(int i) { return buf_[i]; }
+
+    // ---- Escritor ----
+    T& write_buffer() { return buf_[back_]; }
+    // Publica el buffer escrito. Devuelve true si pisó un frame que el lector nunca vio.
+    bool publish() {
+        uint8_t prev = shared_.exchange(uint8_t(back_ | DIRTY), std::memory_order_acq_rel);
+        back_ = uint8_t(prev & IDX);
+        return (prev & DIRTY) != 0;
+    }
+
+    // ---- Lector ----
+    // Toma el último frame publicado; false si no hay nada nuevo desde la última vez.
+    bool fetch() {
+        if (!(shared_.load(std::memory_order_acquire) & DIRTY)) return false;
+        uint8_t prev = shared_.exchange(front_, std::memory_order_acq_rel);
+        front_ = uint8_t(prev & IDX);
+        return true;
+    }
+    const T& read_buffer() const { return buf_[front_]; }
+
+private:
+    static constexpr uint8_t IDX = 0x3, DIRTY = 0x4;
+    T buf_[3];
+    uint8_t back_  = 0;                 // solo escritor
+    uint8_t front_ = 2;                 // solo lector
+    std::atomic<uint8_t> shared_{1};
+};
@@ -1,5 +1,7 @@
 #pragma once
+#include <string>
 #include <vector>
+#include "arena.hpp"
 #include <cmath>
 #include "config.hpp"
 #include "rng.hpp"
@@ -50,24 +52,99 @@ struct WaveParams {
     int   splash_m_min     = 6,     splash_m_max     = 10;
 };
 
+// Fin de la fase de splash (s desde el impacto)
+constexpr float TAU_SPLASH_MAX = 0.25f;
+
+// Semiancho de la banda de influencia completa (anillo ± esto)
+inline float drop_band_halfwidth(const Drop& d) {
+    return 3.0f * d.sigma + (d.cap_delta + 3.0f * d.cap_sigma) + d.splash_r0;
+}
+
+// Culling por amplitud (--cull-eps): rango de distancias [lo, hi] al centro fuera
+// del cual |aporte a H| < eps (main, capilares y splash reciben eps/3 cada uno;
+// con ink_gain > 0 también el peso de tinta < eps). Cota superior: att <= 1,
+// |s|·e^(-s²/2) <= e^(-1/2), margen del jitter del radio incluido.
+// false si la gota ya no supera eps en ningún punto (invisible).
+bool drop_cull_range(const Drop& d, float tau, float eps, float ink_gain, float& lo, float& hi);
+
+// Trabajo de píxeles por frame con y sin culling (área de las bandas recortada
+// a su bbox; estimación, no conteo exacto)
+struct CullStats {
+    double px_full = 0.0, px_kept = 0.0;
+    int invisible = 0;     // gotas bajo eps en todo el frame
+    int respawned = 0;     // ... de ellas, reemplazadas (--cull-respawn)
+    int frames = 0;
+
+    void add(const CullStats& o) {
+        px_full += o.px_full; px_kept += o.px_kept;
+        invisible += o.invisible; respawned += o.respawned; frames += o.frames;
+    }
+    double saved() const { return px_full > 0.0 ? 1.0 - px_kept / px_full : 0.0; }
+};
+
+// Ciclo de vida: min-heap por instante de expiración (t0 + maxLife), así cada
+// frame solo toca las gotas que expiran. Una entrada cuya generación ya no es la
+// de su gota (reemplazada por culling) o cuyo índice quedó fuera (menos gotas
+// activas) se descarta al salir del heap.
+struct DropExpiry {
+    float t; int idx; uint32_t gen;
+    bool operator>(const DropExpiry& o) const { return t > o.t; }
+};
+
+class DropRecorder;   // drop_log.hpp
+struct RestoreStats;  // checkpoint.hpp
+
 struct World {
     AppConfig cfg;
     WaveParams wp;
-    RNG rng;
+    uint64_t seed;                 // resuelta (cfg.seed < 0 -> random_device)
     std::vector<Drop> drops;
-    std::vector<float> H;   // heightfield
-    std::vector<float> CR;  // tinta R
-    std::vector<float> CG;  // tinta G
-    std::vector<float> CB;  // tinta B
+    Plane H;   // heightfield
+    Plane CR;  // tinta R
+    Plane CG;  // tinta G
+    Plane CB;  // tinta B
 
     int nextColorIdx = 0;   // para ciclar colores de gotas
+    int respawned = 0;      // gotas regeneradas en el último maybe_respawn
+    CullStats cull;         // último frame (solo con cfg.cull_eps > 0)
+    DropRecorder* recorder = nullptr;   // --record: cada gota (re)generada y cada frame
+    // Lotes de respawn grandes en paralelo (OpenMP); la versión secuencial lo apaga.
+    // La escena no cambia: cada gota sale de su propio flujo DropRNG
+    bool parallel_respawn = true;
 
-    World(const AppConfig& c);
+    // planes = false: solo la escena (gotas y su ciclo de vida), sin H ni tinta;
+    // la usa el muro MPI, donde cada rango sombrea su franja en otro World
+    World(const AppConfig& c, bool planes = true);
 
-    void respawn_drop(Drop& d, float now_s);
     void init(float now_s);
+    // Regenera las gotas expiradas (y las invisibles con --cull-respawn)
     void maybe_respawn(float now_s);
+    // Cambia el número de gotas activas: recorta el final o agrega gotas nuevas
+    void set_active_drops(int n, float now_s);
+
+private:
+    // checkpoint.hpp: guardan y reponen también las generaciones y el heap
+    friend void save_checkpoint(const std::string& path, const World& world, float t_now);
+    friend RestoreStats restore_checkpoint(const std::string& path, World& world, float now_s);
+
+    // Regenera drops[idx[k]] (índices distintos): parámetros en paralelo con un
+    // flujo DropRNG por (semilla, gota, generación); colores en orden de idx
+    void respawn_batch(const std::vector<int>& idx, float now_s);
+    void cull_scan(float now_s);   // estadísticas de culling e invisibles
+
+    std::vector<uint32_t> gen_;        // generación por índice (no se achica)
+    std::vector<DropExpiry> expiry_;   // min-heap (std::greater)
+    std::vector<DropExpiry> retry_;    // entradas a < 1 ms que aún no expiran
+    std::vector<int> batch_;
 };
 
+// Píxeles que recorren los kernels de gotas en now_s con las bandas completas (sin
+// culling; misma estimación que CullStats::px_full). O(N): para muestrear, no por frame
+double drops_pixel_work(const World& w, float now_s);
+
+// Huella FNV-1a de los parámetros de las gotas (misma semilla -> misma huella con
+// cualquier número de hilos)
+uint64_t drops_hash(const std::vector<Drop>& drops);
+
 // contribución de onda realista (main + capilares + splash)
 float ripple_contrib(float x, float y, float t, const Drop& d);
@@ -0,0 +1,59 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Pool de hilos con work-stealing (alternativa a los bucles OpenMP).
+// Cada worker tiene su deque de rangos: trabaja LIFO por el fondo (parte su rango
+// a la mitad y deja la otra mitad en su deque) y, cuando se queda sin trabajo,
+// roba FIFO del frente de otro worker (los rangos más grandes). El hilo que llama
+// a parallel_for participa como worker 0.
+class WorkStealingPool {
+public:
+    explicit WorkStealingPool(int threads);
+    ~WorkStealingPool();
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    int size() const { return int(workers_.size()); }
+
+    // fn(i0, i1) sobre [begin, end) en rangos de a lo sumo 'grain' índices.
+    // Bloquea hasta que todo el rango se haya ejecutado.
+    void parallel_for(int begin, int end, int grain, const std::function<void(int,int)>& fn);
+
+    // Robos acumulados desde el último reset (diagnóstico de balanceo)
+    uint64_t steals() const { return steals_.load(std::memory_order_relaxed); }
+    void reset_steals() { steals_.store(0, std::memory_order_relaxed); }
+
+private:
+    struct Range { int b, e; };
+    struct alignas(64) Worker {
+        std::mutex m;
+        std::deque<Range> dq;
+        uint32_t rng = 0;
+    };
+
+    void worker_main(int id);
+    bool run_one(int id);     // false si no encontró trabajo
+    void push(int id, Range r);
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<std::thread> threads_;
+
+    const std::function<void(int,int)>* fn_ = nullptr;
+    int grain_ = 1;
+    std::atomic<long> remaining_{0};     // índices aún no ejecutados del trabajo actual
+
+    std::mutex job_m_;
+    std::condition_variable job_cv_;
+    uint64_t job_gen_ = 0;               // protegido por job_m_
+    bool quit_ = false;                  // protegido por job_m_
+
+    std::atomic<uint64_t> steals_{0};
+};
@@ -0,0 +1,90 @@
+#include "arena.hpp"
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <sstream>
+#include <iomanip>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace {
+constexpr size_t HUGE_PAGE = size_t(2) << 20;
+constexpr size_t PAGE      = 4096;
+constexpr size_t LINE      = 64;
+inline size_t align_up(size_t v, size_t a) { return (v + a - 1) & ~(a - 1); }
+}
+
+FrameArena& FrameArena::global() {
+    static FrameArena a;   // se libera con el proceso
+    return a;
+}
+
+// Primer toque: para cada plano (en el orden y con el desplazamiento de take())
+// cada hilo escribe las filas que le da schedule(static), como en los kernels
+static void first_touch(char* base, int W, int H, int planes, bool parallel) {
+    const size_t row = size_t(plane_pitch(W)) * sizeof(float);
+    std::vector<size_t> off(static_cast<size_t>(planes));
+    size_t used = 0;
+    for (int k = 0; k < planes; ++k) {
+        off[size_t(k)] = align_up(used, PAGE) + size_t(k % 16) * LINE;
+        used = off[size_t(k)] + row * size_t(H);
+    }
+    #pragma omp parallel for schedule(static) if(parallel)
+    for (int y = 0; y < H; ++y)
+        for (int k = 0; k < planes; ++k)
+            std::memset(base + off[size_t(k)] + size_t(y) * row, 0, row);
+}
+
+void FrameArena::reserve(int W, int H, int planes, bool parallel_touch) {
+    std::lock_guard<std::mutex> lk(m_);
+    if (base_ || planes <= 0 || W <= 0 || H <= 0) return;
+    const size_t count = plane_size(W, H);
+    // Cada plano: redondeo a página + desplazamiento de hasta 15 líneas
+    size_t per = align_up(count * sizeof(float), PAGE) + PAGE;
+    size_t cap = align_up(per * size_t(planes), HUGE_PAGE);
+#ifdef __linux__
+    // Se pide 2 MiB de más para poder recortar a un borde de huge page
+    size_t len = cap + HUGE_PAGE;
+    void* raw = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) return;
+    uintptr_t r = reinterpret_cast<uintptr_t>(raw);
+    uintptr_t b = align_up(r, HUGE_PAGE);
+    if (b > r) munmap(raw, b - r);
+    if (r + len > b + cap) munmap(reinterpret_cast<void*>(b + cap), r + len - (b + cap));
+    base_ = reinterpret_cast<char*>(b);
+#ifdef MADV_HUGEPAGE
+    huge_ = madvise(base_, cap, MADV_HUGEPAGE) == 0;
+#endif
+#else
+    base_ = static_cast<char*>(::operator new(cap, std::align_val_t(HUGE_PAGE)));
+#endif
+    cap_ = cap;
+    reserved_planes_ = planes;
+    first_touch(base_, W, H, planes, parallel_touch);
+}
+
+void* FrameArena::take(size_t bytes) {
+    std::lock_guard<std::mutex> lk(m_);
+    size_t off = align_up(used_, PAGE) + size_t(planes_ % 16) * LINE;
+    if (!base_ || off + bytes > cap_) { fallback_++; return nullptr; }
+    used_ = off + bytes;
+    planes_++;
+    return base_ + off;
+}
+
+bool FrameArena::owns(const void* p) const {
+    std::lock_guard<std::mutex> lk(m_);
+    const char* c = static_cast<const char*>(p);
+    return base_ && c >= base_ && c < base_ + cap_;
+}
+
+std::string FrameArena::describe() const {
+    std::lock_guard<std::mutex> lk(m_);
+    std::ostringstream os;
+    os << std::fixed << std::setprecision(1)
+       << "Arena: " << double(cap_) / double(1 << 20) << " MiB en una reserva ("
+       << reserved_planes_ << " planos), huge pages: " << (huge_ ? "madvise ok" : "no")
+       << ", planos asignados=" << planes_ << ", fuera de arena=" << fallback_;
+    return os.str();
+}
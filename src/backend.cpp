@@ -0,0 +1,159 @@
+#include "backend.hpp"
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <omp.h>
+#include "model.hpp"
+#include "ink.hpp"
+#include "shading.hpp"
+#include "tiled.hpp"
+
+namespace {
+
+class SeqBackend : public ComputeBackend {
+public:
+    std::string name() const override { return "seq"; }
+    void accumulate(World& w, float t_now) override {
+        const AppConfig& cfg = w.cfg;
+        seq::accumulate_heightfield(w.H, w.CR, w.CG, w.CB, cfg.width, cfg.height, w.drops, t_now,
+                                    cfg.ink_enabled, cfg.ink_gain, false, 0.0f, cfg.canvas_y0);
+    }
+    void ink(World& w, float dt) override {
+        const AppConfig& cfg = w.cfg;
+        seq::ink_postprocess(w.CR, w.CG, w.CB, cfg.width, cfg.height, dt, cfg.ink_decay, cfg.ink_blur_mix);
+    }
+    void shade(const World& w, uint32_t* pixels, int pitch) override {
+        const AppConfig& cfg = w.cfg;
+        ShadeInputs in{ w.H.data(), w.CR.data(), w.CG.data(), w.CB.data(), cfg.width, cfg.height,
+                        cfg.slope, cfg.palette, cfg.ink_enabled, cfg.ink_strength };
+        in.canvas_y0 = cfg.canvas_y0; in.canvas_h = cfg.canvas_h;
+        seq::shade_frame(in, pixels, pitch);
+    }
+};
+
+class OmpBackend : public ComputeBackend {
+public:
+    std::string name() const override { return "omp"; }
+    void accumulate(World& w, float t_now) override {
+        const AppConfig& cfg = w.cfg;
+        accumulate_heightfield(w.H, w.CR, w.CG, w.CB, cfg.width, cfg.height, w.drops, t_now,
+                               cfg.ink_enabled, cfg.ink_gain, cfg.math == 1, cfg.cull_eps, cfg.canvas_y0);
+    }
+    void ink(World& w, float dt) override {
+        const AppConfig& cfg = w.cfg;
+        ink_postprocess(w.CR, w.CG, w.CB, cfg.width, cfg.height, dt, cfg.ink_decay, cfg.ink_blur_mix);
+    }
+    void shade(const World& w, uint32_t* pixels, int pitch) override {
+        const AppConfig& cfg = w.cfg;
+        ShadeInputs in{ w.H.data(), w.CR.data(), w.CG.data(), w.CB.data(), cfg.width, cfg.height,
+                        cfg.slope, cfg.palette, cfg.ink_enabled, cfg.ink_strength };
+        in.fast_math = cfg.math == 1;
+        in.canvas_y0 = cfg.canvas_y0; in.canvas_h = cfg.canvas_h;
+        shade_frame(in, pixels, pitch);
+    }
+};
+
+class WsBackend : public ComputeBackend {
+public:
+    explicit WsBackend(const AppConfig& cfg)
+    : pool_(omp_get_max_threads()), tiled_(cfg, pool_) {}
+    std::string name() const override { return "ws"; }
+    void accumulate(World& w, float t_now) override { pool_.reset_steals(); tiled_.accumulate(w, t_now); }
+    void ink(World& w, float dt) override { tiled_.ink(w, dt); }
+    void shade(const World& w, uint32_t* pixels, int pitch) override { tiled_.shade(w, pixels, pitch); }
+    std::string note() override {
+        std::ostringstream os;
+        os << "steals=" << pool_.steals() << ", gotas/tile=" << tiled_.drops_per_tile();
+        return os.str();
+    }
+private:
+    WorkStealingPool pool_;
+    TiledBackend tiled_;
+};
+
+// Etapas de backends distintos (p. ej. gotas en ws y sombreado en seq)
+class StagedBackend : public ComputeBackend {
+public:
+    StagedBackend(std::vector<std::unique_ptr<ComputeBackend>> owned,
+                  ComputeBackend* a, ComputeBackend* i, ComputeBackend* s)
+    : owned_(std::move(owned)), a_(a), i_(i), s_(s) {}
+    std::string name() const override {
+        return "accum=" + a_->name() + ",ink=" + i_->name() + ",shade=" + s_->name();
+    }
+    void accumulate(World& w, float t_now) override { a_->accumulate(w, t_now); }
+    void ink(World& w, float dt) override { i_->ink(w, dt); }
+    void shade(const World& w, uint32_t* pixels, int pitch) override { s_->shade(w, pixels, pitch); }
+    std::string note() override {
+        std::string n;
+        for (auto& b : owned_) { std::string x = b->note(); if (!x.empty()) n += (n.empty() ? "" : ", ") + x; }
+        return n;
+    }
+private:
+    std::vector<std::unique_ptr<ComputeBackend>> owned_;
+    ComputeBackend *a_, *i_, *s_;
+};
+
+const BackendInfo* find_backend(const std::string& name) {
+    for (const BackendInfo& b : backend_registry())
+        if (name == b.name) return &b;
+    return nullptr;
+}
+
+} // namespace
+
+const std::vector<BackendInfo>& backend_registry() {
+    static const std::vector<BackendInfo> reg = {
+        {"seq", "referencia secuencial (model_seq/ink/shading.cpp), un hilo",
+         [](const AppConfig&) -> std::unique_ptr<ComputeBackend> { return std::make_unique<SeqBackend>(); }},
+        {"omp", "bucles OpenMP (model_parallel/ink_parallel/shading_parallel.cpp)",
+         [](const AppConfig&) -> std::unique_ptr<ComputeBackend> { return std::make_unique<OmpBackend>(); }},
+        {"ws",  "tiles + pool work-stealing (tiled_ws.cpp)",
+         [](const AppConfig& c) -> std::unique_ptr<ComputeBackend> { return std::make_unique<WsBackend>(c); }},
+    };
+    return reg;
+}
+
+std::string backend_names() {
+    std::string s;
+    for (const BackendInfo& b : backend_registry()) s += (s.empty() ? "" : "|") + std::string(b.name);
+    return s;
+}
+
+std::array<std::string, 3> parse_backend_spec(const std::string& spec) {
+    auto bad = [&](const std::string& why) {
+        return std::runtime_error("backend invalido '" + spec + "': " + why + " (" + backend_names()
+                                  + ", o accum=X,ink=Y,shade=Z)");
+    };
+    if (spec.find('=') == std::string::npos) {
+        if (!find_backend(spec)) throw bad("desconocido");
+        return {spec, spec, spec};
+    }
+    std::array<std::string, 3> st = {"omp", "omp", "omp"};
+    std::istringstream is(spec);
+    std::string item;
+    while (std::getline(is, item, ',')) {
+        const size_t eq = item.find('=');
+        if (eq == std::string::npos) throw bad("falta '=' en '" + item + "'");
+        const std::string stage = item.substr(0, eq), name = item.substr(eq + 1);
+        if (!find_backend(name)) throw bad("desconocido '" + name + "'");
+        if (stage == "accum") st[0] = name;
+        else if (stage == "ink") st[1] = name;
+        else if (stage == "shade") st[2] = name;
+        else throw bad("etapa '" + stage + "' (accum|ink|shade)");
+    }
+    return st;
+}
+
+std::unique_ptr<ComputeBackend> make_backend(const std::string& spec, const AppConfig& cfg) {
+    const std::array<std::string, 3> st = parse_backend_spec(spec);
+    if (st[0] == st[1] && st[1] == st[2]) return find_backend(st[0])->make(cfg);
+
+    std::vector<std::unique_ptr<ComputeBackend>> owned;
+    std::map<std::string, ComputeBackend*> by_name;
+    for (const std::string& n : st)
+        if (!by_name.count(n)) {
+            owned.push_back(find_backend(n)->make(cfg));
+            by_name[n] = owned.back().get();
+        }
+    return std::make_unique<StagedBackend>(std::move(owned), by_name[st[0]], by_name[st[1]], by_name[st[2]]);
+}
@@ -0,0 +1,210 @@
+#include "checkpoint.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+using clk = std::chrono::steady_clock;
+
+inline double ms_between(clk::time_point a, clk::time_point b) {
+    return std::chrono::duration<double, std::milli>(b - a).count();
+}
+
+inline uint64_t align_up(uint64_t v) {
+    return (v + CHECKPOINT_ALIGN - 1) & ~(CHECKPOINT_ALIGN - 1);
+}
+
+CheckpointHeader read_header(const std::string& path) {
+    std::FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) throw std::runtime_error("--restore: no se pudo abrir " + path);
+    CheckpointHeader h{};
+    const bool ok = std::fread(&h, sizeof(h), 1, f) == 1;
+    std::fclose(f);
+    if (!ok || std::memcmp(h.magic, CHECKPOINT_MAGIC, sizeof(h.magic)) != 0)
+        throw std::runtime_error("--restore: " + path + " no es un checkpoint");
+    if (h.version != CHECKPOINT_VERSION || h.header_bytes != sizeof(CheckpointHeader))
+        throw std::runtime_error("--restore: versión de checkpoint no soportada (" + std::to_string(h.version) + ")");
+    if (h.drop_bytes != sizeof(Drop) || h.expiry_bytes != sizeof(DropExpiry))
+        throw std::runtime_error("--restore: checkpoint con otro layout de Drop (" + std::to_string(h.drop_bytes) + " B)");
+    return h;
+}
+
+// Checkpoint mapeado en memoria (solo lectura)
+class MappedCheckpoint {
+public:
+    explicit MappedCheckpoint(const std::string& path) {
+#ifdef __linux__
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("--restore: no se pudo abrir " + path);
+        struct stat st{};
+        if (fstat(fd, &st) != 0 || st.st_size < off_t(sizeof(CheckpointHeader))) {
+            close(fd);
+            throw std::runtime_error("--restore: checkpoint truncado " + path);
+        }
+        size_ = size_t(st.st_size);
+        void* p = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+        close(fd);
+        if (p == MAP_FAILED) throw std::runtime_error("--restore: mmap falló para " + path);
+        madvise(p, size_, MADV_SEQUENTIAL);
+        data_ = static_cast<const unsigned char*>(p);
+#else
+        (void)path;
+        throw std::runtime_error("--restore: requiere mmap (Linux)");
+#endif
+    }
+    ~MappedCheckpoint() {
+#ifdef __linux__
+        if (data_) munmap(const_cast<unsigned char*>(data_), size_);
+#endif
+    }
+    MappedCheckpoint(const MappedCheckpoint&) = delete;
+    MappedCheckpoint& operator=(const MappedCheckpoint&) = delete;
+
+    const unsigned char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const unsigned char* data_ = nullptr;
+    size_t size_ = 0;
+};
+}
+
+void save_checkpoint(const std::string& path, const World& w, float t_now) {
+    const AppConfig& c = w.cfg;
+    CheckpointHeader h{};
+    std::memcpy(h.magic, CHECKPOINT_MAGIC, sizeof(h.magic));
+    h.version = CHECKPOINT_VERSION;
+    h.header_bytes = uint32_t(sizeof(CheckpointHeader));
+    h.drop_bytes = uint32_t(sizeof(Drop));
+    h.expiry_bytes = uint32_t(sizeof(DropExpiry));
+    h.width = c.width; h.height = c.height; h.N = c.N; h.palette = c.palette;
+    h.ink_enabled = c.ink_enabled ? 1 : 0;
+    h.next_color_idx = w.nextColorIdx;
+    h.seed = w.seed;
+    h.t_sim = t_now;
+    h.slope = c.slope; h.spawn_rate = c.spawn_rate;
+    h.ink_gain = c.ink_gain; h.ink_decay = c.ink_decay;
+    h.ink_blur_mix = c.ink_blur_mix; h.ink_strength = c.ink_strength; h.cull_eps = c.cull_eps;
+    h.n_drops = uint32_t(w.drops.size());
+    h.n_gen = uint32_t(w.gen_.size());
+    h.n_expiry = uint32_t(w.expiry_.size());
+    h.off_drops = align_up(sizeof(h));
+    h.off_gen = align_up(h.off_drops + uint64_t(h.n_drops) * sizeof(Drop));
+    h.off_expiry = align_up(h.off_gen + uint64_t(h.n_gen) * sizeof(uint32_t));
+    h.off_planes = align_up(h.off_expiry + uint64_t(h.n_expiry) * sizeof(DropExpiry));
+    h.plane_bytes = uint64_t(c.width) * uint64_t(c.height) * sizeof(float);
+    h.file_bytes = h.off_planes + 3 * align_up(h.plane_bytes) + h.plane_bytes;
+    h.scene = drops_hash(w.drops);
+
+    const std::string tmp = path + ".tmp";
+    std::FILE* f = std::fopen(tmp.c_str(), "wb");
+    if (!f) throw std::runtime_error("--checkpoint: no se pudo abrir " + tmp);
+    bool ok = true;
+    uint64_t pos = 0;
+    auto put = [&](uint64_t off, const void* p, size_t n) {
+        // Relleno hasta el inicio de la sección
+        static const char zeros[CHECKPOINT_ALIGN] = {};
+        while (ok && pos < off) {
+            const size_t k = size_t(std::min<uint64_t>(off - pos, sizeof(zeros)));
+            ok = std::fwrite(zeros, 1, k, f) == k;
+            pos += k;
+        }
+        if (ok && n > 0) ok = std::fwrite(p, 1, n, f) == n;
+        pos += n;
+    };
+    put(0, &h, sizeof(h));
+    put(h.off_drops, w.drops.data(), w.drops.size() * sizeof(Drop));
+    put(h.off_gen, w.gen_.data(), w.gen_.size() * sizeof(uint32_t));
+    put(h.off_expiry, w.expiry_.data(), w.expiry_.size() * sizeof(DropExpiry));
+    // Planos sin el relleno de plane_pitch: W floats por fila, filas contiguas
+    const size_t row = size_t(c.width) * sizeof(float), P = size_t(plane_pitch(c.width));
+    uint64_t off = h.off_planes;
+    for (const Plane* pl : {&w.H, &w.CR, &w.CG, &w.CB}) {
+        for (int y = 0; y < c.height; ++y)
+            put(off + uint64_t(y) * row, pl->data() + size_t(y) * P, row);
+        off += align_up(h.plane_bytes);
+    }
+    ok = std::fclose(f) == 0 && ok;
+    if (ok) ok = std::rename(tmp.c_str(), path.c_str()) == 0;
+    if (!ok) {
+        std::remove(tmp.c_str());
+        throw std::runtime_error("--checkpoint: error de escritura en " + path);
+    }
+}
+
+void load_checkpoint_scene(const std::string& path, AppConfig& cfg) {
+    const CheckpointHeader h = read_header(path);
+    cfg.width = h.width; cfg.height = h.height; cfg.N = h.N; cfg.palette = h.palette;
+    cfg.ink_enabled = h.ink_enabled != 0;
+    cfg.slope = h.slope; cfg.spawn_rate = h.spawn_rate;
+    cfg.ink_gain = h.ink_gain; cfg.ink_decay = h.ink_decay;
+    cfg.ink_blur_mix = h.ink_blur_mix; cfg.ink_strength = h.ink_strength; cfg.cull_eps = h.cull_eps;
+    validate_scene(cfg, "--restore");
+}
+
+RestoreStats restore_checkpoint(const std::string& path, World& w, float now_s) {
+    RestoreStats st;
+    const clk::time_point t0 = clk::now();
+    const CheckpointHeader h = read_header(path);
+    MappedCheckpoint m(path);
+    const clk::time_point t1 = clk::now();
+
+    if (h.width != w.cfg.width || h.height != w.cfg.height)
+        throw std::runtime_error("--restore: checkpoint de " + std::to_string(h.width) + "x" + std::to_string(h.height)
+                                 + ", el World es de " + std::to_string(w.cfg.width) + "x" + std::to_string(w.cfg.height));
+    if (m.size() < h.file_bytes || h.n_gen < h.n_drops
+        || h.plane_bytes != uint64_t(h.width) * uint64_t(h.height) * sizeof(float))
+        throw std::runtime_error("--restore: checkpoint truncado o inconsistente " + path);
+
+    const unsigned char* base = m.data();
+    w.drops.resize(h.n_drops);
+    std::memcpy(w.drops.data(), base + h.off_drops, size_t(h.n_drops) * sizeof(Drop));
+    w.gen_.resize(h.n_gen);
+    std::memcpy(w.gen_.data(), base + h.off_gen, size_t(h.n_gen) * sizeof(uint32_t));
+    w.expiry_.resize(h.n_expiry);
+    std::memcpy(w.expiry_.data(), base + h.off_expiry, size_t(h.n_expiry) * sizeof(DropExpiry));
+    const size_t row = size_t(h.width) * sizeof(float), P = size_t(plane_pitch(h.width));
+    uint64_t off = h.off_planes;
+    for (Plane* pl : {&w.H, &w.CR, &w.CG, &w.CB}) {
+        for (int y = 0; y < h.height; ++y)
+            std::memcpy(pl->data() + size_t(y) * P, base + off + uint64_t(y) * row, row);
+        off += align_up(h.plane_bytes);
+    }
+    if (drops_hash(w.drops) != h.scene)
+        throw std::runtime_error("--restore: las gotas de " + path + " no coinciden con su huella");
+
+    w.seed = h.seed;
+    w.nextColorIdx = h.next_color_idx;
+    w.respawned = 0;
+    w.batch_.reserve(h.n_gen);
+
+    // Rebase: las gotas y el heap solo dependen de t - t0, así que se corren al
+    // reloj del llamador (el orden del heap se conserva al sumar la misma cantidad)
+    const float shift = now_s - h.t_sim;
+    for (Drop& d : w.drops) d.t0 += shift;
+    for (DropExpiry& e : w.expiry_) e.t += shift;
+
+    st.t_sim = h.t_sim;
+    st.bytes = h.file_bytes;
+    st.map_ms = ms_between(t0, t1);
+    st.copy_ms = ms_between(t1, clk::now());
+    return st;
+}
+
+std::string RestoreStats::describe(const std::string& path) const {
+    std::ostringstream os;
+    os << "Restore: " << path << " t=" << std::fixed << std::setprecision(2) << t_sim << " s ("
+       << double(bytes) / double(1 << 20) << " MiB) en " << map_ms + copy_ms << " ms (mmap "
+       << map_ms << " ms, copia " << copy_ms << " ms)";
+    return os.str();
+}
@@ -0,0 +1,21 @@
+#include "compact.hpp"
+#include "cpu_dispatch.hpp"
+
+RIPPLE_MULTIVERSION
+void pack_rows(const float* H, const float* CR, const float* CG, const float* CB,
+               int W, int y0, int y1, CompactPlanes& out)
+{
+    uint16_t* h = out.H.data();
+    uint16_t* r = out.CR.data();
+    uint16_t* g = out.CG.data();
+    uint16_t* b = out.CB.data();
+    for (int y = y0; y < y1; ++y) {
+        const size_t o = size_t(y) * size_t(plane_pitch(W));
+        for (size_t i = o; i < o + size_t(W); ++i) {
+            h[i] = f32_to_f16(H[i]);
+            r[i] = to_unorm16(CR[i]);
+            g[i] = to_unorm16(CG[i]);
+            b[i] = to_unorm16(CB[i]);
+        }
+    }
+}
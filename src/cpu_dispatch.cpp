@@ -0,0 +1,15 @@
+#include "cpu_dispatch.hpp"
+
+std::string cpu_dispatch_report() {
+#if RIPPLE_HAS_MULTIVERSION
+    __builtin_cpu_init();
+    const char* path = __builtin_cpu_supports("x86-64-v4") ? "x86-64-v4 (AVX-512)"
+                     : __builtin_cpu_supports("x86-64-v3") ? "x86-64-v3 (AVX2+FMA)"
+                     :                                       "x86-64 base (SSE2)";
+    return std::string("ISA: kernels multiversión, ruta elegida ") + path;
+#elif defined(RIPPLE_NATIVE)
+    return "ISA: -march=native (sin despacho en tiempo de ejecución)";
+#else
+    return "ISA: ruta genérica (sin multiversión en este compilador/plataforma)";
+#endif
+}
@@ -0,0 +1,82 @@
+#include "drop_log.hpp"
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+DropRecorder::DropRecorder(const std::string& path, const World& world)
+: path_(path)
+{
+    f_ = std::fopen(path_.c_str(), "wb");
+    if (!f_) throw std::runtime_error("--record: no se pudo abrir " + path_);
+    std::setvbuf(f_, nullptr, _IOFBF, size_t(1) << 20);
+
+    const AppConfig& c = world.cfg;
+    DropLogHeader h{};
+    std::memcpy(h.magic, DROP_LOG_MAGIC, sizeof(h.magic));
+    h.version = DROP_LOG_VERSION;
+    h.drop_bytes = uint32_t(sizeof(Drop));
+    h.width = c.width; h.height = c.height; h.N = c.N; h.palette = c.palette;
+    h.ink_enabled = c.ink_enabled ? 1 : 0; h.math = c.math;
+    h.seed = world.seed;
+    h.slope = c.slope; h.spawn_rate = c.spawn_rate;
+    h.ink_gain = c.ink_gain; h.ink_decay = c.ink_decay;
+    h.ink_blur_mix = c.ink_blur_mix; h.ink_strength = c.ink_strength;
+    write(&h, sizeof(h));
+}
+
+DropRecorder::~DropRecorder() {
+    if (f_) std::fclose(f_);
+}
+
+void DropRecorder::write(const void* p, size_t n) {
+    if (failed_ || n == 0) return;
+    if (std::fwrite(p, 1, n, f_) != n) failed_ = true;
+    else bytes_ += n;
+}
+
+void DropRecorder::on_spawn(const std::vector<int>& idx, const std::vector<Drop>& drops) {
+    for (int i : idx) pending_.push_back({uint32_t(i), drops[size_t(i)]});
+}
+
+void DropRecorder::end_frame(float now_s, const World& world) {
+    DropLogFrame fr{};
+    fr.tag = DROP_LOG_FRAME;
+    fr.n_events = uint32_t(pending_.size());
+    fr.n_drops = uint32_t(world.drops.size());
+    fr.t_now = now_s;
+    // El paso de la tinta lo da quien llama: se graba la diferencia de t_now
+    // (init es t = 0), igual al dt del bucle salvo redondeo de float
+    fr.dt = now_s - last_t_;
+    fr.ink_blur_mix = world.cfg.ink_blur_mix;
+    fr.cull_eps = world.cfg.cull_eps;
+    write(&fr, sizeof(fr));
+    write(pending_.data(), pending_.size() * sizeof(DropLogEvent));
+    events_ += pending_.size();
+    pending_.clear();
+    last_t_ = now_s;
+    frames_++;
+}
+
+void DropRecorder::close(const World& world) {
+    if (!f_) return;
+    DropLogEnd e{};
+    e.tag = DROP_LOG_END;
+    e.frames = frames_;
+    // Eventos sin frame (p. ej. el gobernador tras el último frame): la escena
+    // grabada ya no es la que deja la reproducción, se marca como desconocida
+    e.scene = pending_.empty() ? drops_hash(world.drops) : 0;
+    scene_ = e.scene;
+    write(&e, sizeof(e));
+    const bool ok = std::fclose(f_) == 0 && !failed_;
+    f_ = nullptr;
+    if (!ok) throw std::runtime_error("--record: error de escritura en " + path_);
+}
+
+std::string DropRecorder::summary() const {
+    std::ostringstream os;
+    os << "Grabación: " << path_ << " frames=" << frames_ << " eventos=" << events_
+       << std::fixed << std::setprecision(2) << " (" << double(bytes_) / double(1 << 20) << " MiB, "
+       << sizeof(DropLogEvent) << " B/evento) escena=" << std::hex << scene_;
+    return os.str();
+}
@@ -0,0 +1,80 @@
+#include "frame_export.hpp"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <omp.h>
+#include "arena.hpp"
+#include "ripple.hpp"
+
+namespace {
+using clk = std::chrono::steady_clock;
+
+inline double ms_between(clk::time_point a, clk::time_point b) {
+    return std::chrono::duration<double, std::milli>(b - a).count();
+}
+}
+
+int run_export(const AppConfig& cfg) {
+    // stdout puede ser la salida de video: todo el texto va por stderr
+    std::ostream& log = std::cerr;
+    const ExportFormat fmt = export_format_for(cfg.export_path, cfg.export_format);
+    const int W = cfg.width, Hh = cfg.height, F = cfg.export_frames;
+    const double dt = 1.0 / double(cfg.export_fps);
+
+    // World (4) + scratch de tinta (3) + scratch del backend ws (3)
+    FrameArena::global().reserve(W, Hh, 4 + 3 + 3);
+    RippleEngine eng(cfg);
+    if (!eng.restore_info().empty()) log << eng.restore_info() << "\n";
+    FrameExporter ex(cfg.export_path, fmt, W, Hh, cfg.export_fps, cfg.export_queue);
+
+    log << "Export: " << F << " frames " << W << "x" << Hh << " " << export_format_name(fmt)
+        << " -> " << (cfg.export_path == "-" ? "stdout" : cfg.export_path)
+        << " | backend=" << eng.backend().name() << ", hilos=" << omp_get_max_threads()
+        << ", dt=1/" << cfg.export_fps << " s, cola=" << cfg.export_queue << "\n";
+
+    double sim_ms = 0.0, shade_ms = 0.0, enc_ms = 0.0;
+    const clk::time_point t_start = clk::now();
+    clk::time_point t_log = t_start;
+    int done = 0;
+    for (int k = 1; k <= F; ++k) {
+        ExportFrame* f = ex.acquire();
+        if (!f) break;                      // el escritor falló: finish() lanza el error
+        const clk::time_point t0 = clk::now();
+        eng.step_at(float(double(k) * dt), float(dt));
+        const clk::time_point t1 = clk::now();
+        eng.shade(f->argb.data(), W * int(sizeof(uint32_t)));
+        const clk::time_point t2 = clk::now();
+        ex.encode(*f);
+        const clk::time_point t3 = clk::now();
+        f->index = k - 1;
+        ex.submit(f);
+        ++done;
+        sim_ms += ms_between(t0, t1); shade_ms += ms_between(t1, t2); enc_ms += ms_between(t2, t3);
+
+        if (ms_between(t_log, t3) >= 1000.0) {
+            t_log = t3;
+            log << "  " << done << "/" << F << " frames ("
+                << std::fixed << std::setprecision(1) << done / (ms_between(t_start, t3) * 1e-3) << " fps)\n";
+        }
+    }
+    const clk::time_point t_prod = clk::now();
+    ex.finish();
+    const double total_s = ms_between(t_start, clk::now()) * 1e-3;
+
+    const double n = done > 0 ? double(done) : 1.0;
+    const double fps = done / total_s;
+    log << std::fixed << std::setprecision(2)
+        << "Export: " << done << " frames en " << total_s << " s = " << fps << " fps ("
+        << fps / double(cfg.export_fps) << "x tiempo real)\n"
+        << "  por frame: sim+ink=" << sim_ms / n << " ms, shade=" << shade_ms / n << " ms, codificar="
+        << enc_ms / n << " ms, escritor=" << ex.write_ms() / n << " ms\n"
+        << "  espera del productor por cola llena=" << ex.stall_ms() << " ms en total, vaciado final="
+        << ms_between(t_prod, clk::now()) << " ms, " << double(ex.bytes()) / double(1 << 20) << " MiB\n";
+    if (!cfg.checkpoint.empty()) {
+        eng.checkpoint(cfg.checkpoint);
+        log << "Checkpoint: " << cfg.checkpoint << " t=" << eng.time() << " s\n";
+    }
+    const std::string rec = eng.close_recording();
+    if (!rec.empty()) log << rec << "\n";
+    return 0;
+}
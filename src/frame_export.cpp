@@ -0,0 +1,245 @@
+#include "frame_export.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <omp.h>
+
+namespace {
+using clk = std::chrono::steady_clock;
+
+inline double ms_since(clk::time_point t0) {
+    return std::chrono::duration<double, std::milli>(clk::now() - t0).count();
+}
+
+bool ends_with(const std::string& s, const char* suf) {
+    const size_t n = std::strlen(suf);
+    return s.size() >= n && s.compare(s.size() - n, n, suf) == 0;
+}
+
+// BT.601 rango limitado (Y 16..235, UV 16..240), enteros de 8 bits de punto fijo
+inline uint8_t rgb_y(int r, int g, int b) { return uint8_t(((66*r + 129*g + 25*b + 128) >> 8) + 16); }
+inline uint8_t rgb_u(int r, int g, int b) { return uint8_t(((-38*r - 74*g + 112*b + 128) >> 8) + 128); }
+inline uint8_t rgb_v(int r, int g, int b) { return uint8_t(((112*r - 94*g - 18*b + 128) >> 8) + 128); }
+
+inline int ch_r(uint32_t p) { return int((p >> 16) & 0xFF); }
+inline int ch_g(uint32_t p) { return int((p >> 8) & 0xFF); }
+inline int ch_b(uint32_t p) { return int(p & 0xFF); }
+
+const char Y4M_FRAME[] = "FRAME\n";
+
+// Patrón por frame: exactamente una conversión %d con flags/ancho opcionales ("%05d")
+bool valid_frame_pattern(const std::string& p) {
+    int conv = 0;
+    for (size_t i = 0; i < p.size(); ++i) {
+        if (p[i] != '%') continue;
+        if (i + 1 < p.size() && p[i + 1] == '%') { ++i; continue; }
+        size_t j = i + 1;
+        while (j < p.size() && (p[j] == '0' || p[j] == '-' || p[j] == '+' || p[j] == ' ')) ++j;
+        while (j < p.size() && p[j] >= '0' && p[j] <= '9') ++j;
+        if (j >= p.size() || p[j] != 'd') return false;
+        ++conv; i = j;
+    }
+    return conv == 1;
+}
+
+std::string ppm_header(int W, int H) {
+    return "P6\n" + std::to_string(W) + " " + std::to_string(H) + "\n255\n";
+}
+} // namespace
+
+ExportFormat export_format_for(const std::string& path, int fmt) {
+    if (fmt >= 0) return ExportFormat(fmt);
+    if (ends_with(path, ".y4m")) return EXPORT_Y4M;
+    if (ends_with(path, ".ppm")) return EXPORT_PPM;
+    return EXPORT_RAW;
+}
+
+const char* export_format_name(ExportFormat f) {
+    switch (f) {
+        case EXPORT_Y4M: return "y4m";
+        case EXPORT_PPM: return "ppm";
+        default:         return "raw";
+    }
+}
+
+FrameExporter::FrameExporter(const std::string& path, ExportFormat fmt, int W, int H, float fps, int queue)
+: path_(path), fmt_(fmt), W_(W), H_(H), fps_(fps)
+{
+    per_file_ = fmt_ == EXPORT_PPM && path_.find('%') != std::string::npos;
+    if (per_file_ && !valid_frame_pattern(path_))
+        throw std::runtime_error("--export: patrón por frame inválido (una sola conversión %d, p. ej. f_%05d.ppm)");
+    if (path_ == "-") out_ = stdout;
+    else if (!per_file_) {
+        out_ = std::fopen(path_.c_str(), "wb");
+        if (!out_) throw std::runtime_error("--export: no se pudo abrir " + path_);
+    }
+    // Buffer de stdio grande: pocas syscalls por frame
+    if (out_) std::setvbuf(out_, nullptr, _IOFBF, size_t(4) << 20);
+
+    if (fmt_ == EXPORT_Y4M && out_) {
+        // fps como racional exacto a milésimas (29.97 -> 29970:1000)
+        const long num = std::lround(double(fps_) * 1000.0);
+        std::string hdr = "YUV4MPEG2 W" + std::to_string(W_) + " H" + std::to_string(H_)
+                        + " F" + std::to_string(num) + ":1000 Ip A1:1 C420jpeg XCOLORRANGE=LIMITED\n";
+        if (std::fwrite(hdr.data(), 1, hdr.size(), out_) != hdr.size()) {
+            // Si el constructor lanza el destructor no corre: cerrar aquí
+            if (out_ != stdout) std::fclose(out_);
+            out_ = nullptr;
+            throw std::runtime_error("--export: error de escritura en " + path_);
+        }
+        bytes_ += hdr.size();
+    }
+
+    const size_t SZ = size_t(W_) * size_t(H_);
+    const size_t CW = size_t(W_ + 1) / 2, CH = size_t(H_ + 1) / 2;
+    size_t payload = 0;
+    if (fmt_ == EXPORT_Y4M) payload = sizeof(Y4M_FRAME) - 1 + SZ + 2 * CW * CH;
+    else if (fmt_ == EXPORT_PPM) payload = ppm_header(W_, H_).size() + 3 * SZ;
+
+    frames_.resize(size_t(queue < 1 ? 1 : queue));
+    for (ExportFrame& f : frames_) {
+        f.argb.assign(SZ, 0u);
+        f.payload.assign(payload, 0u);
+        free_.push_back(&f);
+    }
+    th_ = std::thread(&FrameExporter::writer_loop, this);
+}
+
+FrameExporter::~FrameExporter() {
+    try { finish(); } catch (...) {}
+}
+
+ExportFrame* FrameExporter::acquire() {
+    std::unique_lock<std::mutex> lk(m_);
+    if (free_.empty()) {
+        const clk::time_point t0 = clk::now();
+        cv_free_.wait(lk, [&]{ return !free_.empty() || failed_; });
+        stall_ms_ += ms_since(t0);
+    }
+    if (failed_) return nullptr;
+    ExportFrame* f = free_.front();
+    free_.pop_front();
+    return f;
+}
+
+void FrameExporter::encode(ExportFrame& f) const {
+    const int W = W_, H = H_;
+    const uint32_t* px = f.argb.data();
+    uint8_t* out = f.payload.data();
+
+    if (fmt_ == EXPORT_PPM) {
+        const std::string hdr = ppm_header(W, H);
+        std::memcpy(out, hdr.data(), hdr.size());
+        uint8_t* rgb = out + hdr.size();
+        #pragma omp parallel for schedule(static)
+        for (int y = 0; y < H; ++y) {
+            const uint32_t* row = px + size_t(y) * size_t(W);
+            uint8_t* o = rgb + size_t(y) * size_t(W) * 3;
+            for (int x = 0; x < W; ++x) {
+                o[3*x + 0] = uint8_t(ch_r(row[x]));
+                o[3*x + 1] = uint8_t(ch_g(row[x]));
+                o[3*x + 2] = uint8_t(ch_b(row[x]));
+            }
+        }
+    } else if (fmt_ == EXPORT_Y4M) {
+        std::memcpy(out, Y4M_FRAME, sizeof(Y4M_FRAME) - 1);
+        const int CW = (W + 1) / 2, CH = (H + 1) / 2;
+        uint8_t* Yp = out + sizeof(Y4M_FRAME) - 1;
+        uint8_t* Up = Yp + size_t(W) * size_t(H);
+        uint8_t* Vp = Up + size_t(CW) * size_t(CH);
+        // Por par de filas: luma de ambas y croma del bloque 2x2 (bordes impares replicados)
+        #pragma omp parallel for schedule(static)
+        for (int cy = 0; cy < CH; ++cy) {
+            const int y0 = 2 * cy, y1 = y0 + 1 < H ? y0 + 1 : y0;
+            const uint32_t* r0 = px + size_t(y0) * size_t(W);
+            const uint32_t* r1 = px + size_t(y1) * size_t(W);
+            uint8_t* Y0 = Yp + size_t(y0) * size_t(W);
+            uint8_t* Y1 = Yp + size_t(y1) * size_t(W);
+            for (int x = 0; x < W; ++x) {
+                Y0[x] = rgb_y(ch_r(r0[x]), ch_g(r0[x]), ch_b(r0[x]));
+                Y1[x] = rgb_y(ch_r(r1[x]), ch_g(r1[x]), ch_b(r1[x]));
+            }
+            uint8_t* U = Up + size_t(cy) * size_t(CW);
+            uint8_t* V = Vp + size_t(cy) * size_t(CW);
+            for (int cx = 0; cx < CW; ++cx) {
+                const int x0 = 2 * cx, x1 = x0 + 1 < W ? x0 + 1 : x0;
+                const int r = (ch_r(r0[x0]) + ch_r(r0[x1]) + ch_r(r1[x0]) + ch_r(r1[x1]) + 2) >> 2;
+                const int g = (ch_g(r0[x0]) + ch_g(r0[x1]) + ch_g(r1[x0]) + ch_g(r1[x1]) + 2) >> 2;
+                const int b = (ch_b(r0[x0]) + ch_b(r0[x1]) + ch_b(r1[x0]) + ch_b(r1[x1]) + 2) >> 2;
+                U[cx] = rgb_u(r, g, b);
+                V[cx] = rgb_v(r, g, b);
+            }
+        }
+    }
+}
+
+void FrameExporter::submit(ExportFrame* f) {
+    {
+        std::lock_guard<std::mutex> lk(m_);
+        ready_.push_back(f);
+    }
+    cv_ready_.notify_one();
+}
+
+bool FrameExporter::write_frame(const ExportFrame& f) {
+    const void* data = f.payload.data();
+    size_t len = f.payload.size();
+    if (fmt_ == EXPORT_RAW) { data = f.argb.data(); len = f.argb.size() * sizeof(uint32_t); }
+
+    std::FILE* out = out_;
+    if (per_file_) {
+        char name[4096];
+        std::snprintf(name, sizeof(name), path_.c_str(), f.index);
+        out = std::fopen(name, "wb");
+        if (!out) { error_ = std::string("no se pudo abrir ") + name; return false; }
+    }
+    const bool ok = std::fwrite(data, 1, len, out) == len;
+    const bool closed = !per_file_ || std::fclose(out) == 0;
+    if (!ok || !closed) error_ = "error de escritura en " + path_;
+    return ok && closed;
+}
+
+void FrameExporter::writer_loop() {
+    for (;;) {
+        ExportFrame* f = nullptr;
+        {
+            std::unique_lock<std::mutex> lk(m_);
+            cv_ready_.wait(lk, [&]{ return !ready_.empty() || stop_; });
+            if (ready_.empty()) return;     // stop_ y cola vacía
+            f = ready_.front();
+            ready_.pop_front();
+        }
+        const clk::time_point t0 = clk::now();
+        const bool ok = write_frame(*f);
+        const size_t len = fmt_ == EXPORT_RAW ? f->argb.size() * sizeof(uint32_t) : f->payload.size();
+        {
+            std::lock_guard<std::mutex> lk(m_);
+            write_ms_ += ms_since(t0);
+            if (ok) bytes_ += len;
+            else failed_ = true;
+            free_.push_back(f);
+        }
+        cv_free_.notify_one();
+        if (!ok) return;
+    }
+}
+
+void FrameExporter::finish() {
+    if (finished_) return;
+    finished_ = true;
+    {
+        std::lock_guard<std::mutex> lk(m_);
+        stop_ = true;
+    }
+    cv_ready_.notify_all();
+    if (th_.joinable()) th_.join();
+    bool close_failed = false;
+    if (out_) {
+        close_failed = std::fflush(out_) != 0;
+        if (out_ != stdout) close_failed = std::fclose(out_) != 0 || close_failed;
+        out_ = nullptr;
+    }
+    if (failed_) throw std::runtime_error("--export: " + (error_.empty() ? "error de escritura en " + path_ : error_));
+    if (close_failed) throw std::runtime_error("--export: error al cerrar " + path_);
+}
@@ -0,0 +1,170 @@
+#include "frame_team.hpp"
+#include <algorithm>
+#include "model.hpp"
+#include "ink.hpp"
+#include "shading.hpp"
+#include "numa.hpp"
+#include <omp.h>
+
+FrameTeam::FrameTeam(const AppConfig& cfg) {
+    size_t SZ = plane_size(cfg.width, cfg.height);
+    TR.resize(SZ);
+    TG.resize(SZ);
+    TB.resize(SZ);
+    first_touch_rows(TR, cfg.width, cfg.height);
+    first_touch_rows(TG, cfg.width, cfg.height);
+    first_touch_rows(TB, cfg.width, cfg.height);
+}
+
+SyncOverhead measure_sync_overhead(int reps) {
+    SyncOverhead o;
+    int sink = 0;
+    double t0 = omp_get_wtime();
+    for (int r = 0; r < reps; ++r) {
+        #pragma omp parallel
+        {
+            #pragma omp atomic
+            sink++;
+        }
+    }
+    double t1 = omp_get_wtime();
+    #pragma omp parallel
+    {
+        for (int r = 0; r < reps; ++r) {
+            #pragma omp barrier
+        }
+    }
+    double t2 = omp_get_wtime();
+    (void)sink;
+    o.fork_join_us = 1e6 * (t1 - t0) / reps;
+    o.barrier_us   = 1e6 * (t2 - t1) / reps;
+    return o;
+}
+
+// Barrera explícita cronometrada (la espera de cada hilo se acumula en 'acc')
+static inline void timed_barrier(double& acc) {
+    double t0 = omp_get_wtime();
+    #pragma omp barrier
+    acc += omp_get_wtime() - t0;
+}
+
+void FrameTeam::run(World& world, float t_now, float dt, uint32_t* pixels, int pitch) {
+    const AppConfig& cfg = world.cfg;
+    const int W = cfg.width, Hh = cfg.height, P = plane_pitch(W);
+    const float kdec = ink_decay_factor(dt, cfg.ink_decay);
+    const bool blur = cfg.ink_blur_mix > 0.0f;
+    ShadeInputs in{ world.H.data(), world.CR.data(), world.CG.data(), world.CB.data(), W, Hh,
+                    cfg.slope, cfg.palette, cfg.ink_enabled, cfg.ink_strength };
+    in.fast_math = cfg.math == 1;
+    in.canvas_y0 = cfg.canvas_y0; in.canvas_h = cfg.canvas_h;
+    uint8_t* base = reinterpret_cast<uint8_t*>(pixels);
+
+    // Bandas de BAND filas; dec[b+1] / blr[b+1] marcan "banda b decaída / difuminada"
+    // (dec[0], dec[nb+1], ... son centinelas que ninguna tarea escribe)
+    const int nb = (Hh + BAND - 1) / BAND;
+    deps_.assign(size_t(2 * (nb + 2)), 0);
+    // (solo aparecen en cláusulas depend: GCC las da por no usadas)
+    [[maybe_unused]] char* dec = deps_.data();
+    [[maybe_unused]] char* blr = deps_.data() + (nb + 2);
+
+    const int T = omp_get_max_threads();
+    std::vector<double> wait(size_t(T), 0.0), enter(size_t(T), -1.0), leave(size_t(T), 0.0);
+    // Tiempo ocupado en tareas de tinta / de sombreado, por hilo que las ejecuta
+    std::vector<double> ink_busy(size_t(T), 0.0), shade_busy(size_t(T), 0.0);
+    double t_begin = omp_get_wtime(), t_shade = t_begin;
+
+    #pragma omp parallel
+    {
+        const int tid = omp_get_thread_num();
+        enter[size_t(tid)] = omp_get_wtime();
+        double& w = wait[size_t(tid)];
+
+        // Fase 0: respawn (un hilo) || limpiar H (resto del equipo)
+        #pragma omp single nowait
+        world.maybe_respawn(t_now);
+
+        #pragma omp for schedule(static) nowait
+        for (int y = 0; y < Hh; ++y)
+            std::fill_n(world.H.begin() + std::ptrdiff_t(y)*P, P, 0.0f);
+        timed_barrier(w);
+
+        // Fase 1: gotas (reparto dinámico, sumas atómicas). Una gota toca filas
+        // arbitrarias, así que aquí sí hace falta la barrera global.
+        accumulate_heightfield_team(world.H, world.CR, world.CG, world.CB,
+                                    W, Hh, world.drops, t_now,
+                                    cfg.ink_enabled, cfg.ink_gain, cfg.math == 1, cfg.cull_eps);
+        timed_barrier(w);
+
+        #pragma omp master
+        t_shade = omp_get_wtime();
+
+        // Fase 2: tinta + sombreado como grafo de tareas por banda, sin barreras:
+        //   decay(b) -> blur(b) necesita decay(b-1..b+1)
+        //            -> mezcla+sombreado(b) necesita blur(b-1..b+1) (el blur de las
+        //               vecinas lee las filas de borde de b antes de que se mezclen)
+        // Mismas operaciones y orden que ink_postprocess: resultado idéntico bit a bit.
+        #pragma omp single
+        {
+            for (int b = 0; b < nb; ++b) {
+                const int y0 = b * BAND, y1 = std::min(Hh, y0 + BAND);
+                #pragma omp task firstprivate(y0, y1) depend(out: dec[b+1])
+                {
+                    double t0 = omp_get_wtime();
+                    ink_decay_rows(world.CR, world.CG, world.CB, W, y0, y1, kdec);
+                    ink_busy[size_t(omp_get_thread_num())] += omp_get_wtime() - t0;
+                }
+            }
+            if (blur) {
+                for (int b = 0; b < nb; ++b) {
+                    const int y0 = b * BAND, y1 = std::min(Hh, y0 + BAND);
+                    #pragma omp task firstprivate(y0, y1) depend(in: dec[b], dec[b+1], dec[b+2]) depend(out: blr[b+1])
+                    {
+                        double t0 = omp_get_wtime();
+                        ink_blur_rows(world.CR, world.CG, world.CB, TR, TG, TB, W, Hh, y0, y1);
+                        ink_busy[size_t(omp_get_thread_num())] += omp_get_wtime() - t0;
+                    }
+                }
+            }
+            for (int b = 0; b < nb; ++b) {
+                const int y0 = b * BAND, y1 = std::min(Hh, y0 + BAND);
+                #pragma omp task firstprivate(y0, y1) depend(in: dec[b+1], blr[b], blr[b+1], blr[b+2])
+                {
+                    const size_t me = size_t(omp_get_thread_num());
+                    double t0 = omp_get_wtime();
+                    ink_blend_rows(world.CR, world.CG, world.CB, TR, TG, TB, W, y0, y1, cfg.ink_blur_mix);
+                    double t1 = omp_get_wtime();
+                    for (int y = y0; y < y1; ++y)
+                        shade_row(in, y, reinterpret_cast<uint32_t*>(base + y*size_t(pitch)));
+                    ink_busy[me] += t1 - t0;
+                    shade_busy[me] += omp_get_wtime() - t1;
+                }
+            }
+        }
+        leave[size_t(tid)] = omp_get_wtime();
+    }
+    double t_end = omp_get_wtime();
+
+    // Mismo criterio que RegionTimer: fork medio por hilo + último hilo -> llamador
+    double wsum = 0.0, fork = 0.0, last = t_begin, ink = 0.0, shd = 0.0;
+    int n = 0;
+    for (int t = 0; t < T; ++t) {
+        wsum += wait[size_t(t)];
+        ink += ink_busy[size_t(t)];
+        shd += shade_busy[size_t(t)];
+        if (enter[size_t(t)] < 0.0) continue;
+        fork += enter[size_t(t)] - t_begin;
+        last = std::max(last, leave[size_t(t)]);
+        n++;
+    }
+    stats_.threads    = T;
+    stats_.barriers   = 2;
+    stats_.barrier_ms = 1000.0 * wsum / double(T);
+    stats_.fork_join_ms = 1000.0 * ((n ? fork / n : 0.0) + (t_end - last));
+    stats_.sim_ms     = 1000.0 * (t_shade - t_begin);
+    // La fase 2 solapa tinta y sombreado: su tiempo de pared se reparte según el
+    // tiempo ocupado de cada tipo de tarea
+    const double phase2 = 1000.0 * (t_end - t_shade);
+    const double ink_frac = (ink + shd) > 0.0 ? ink / (ink + shd) : 0.0;
+    stats_.ink_ms     = phase2 * ink_frac;
+    stats_.shade_ms   = phase2 - stats_.ink_ms;
+}
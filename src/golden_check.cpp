@@ -0,0 +1,188 @@
+#include "golden.hpp"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <omp.h>
+#include "waves.hpp"
+#include "shading.hpp"
+#include "compact.hpp"
+#include "ink.hpp"
+#include "frame_team.hpp"
+#include "backend.hpp"
+#include "image_diff.hpp"
+
+namespace {
+using clk = std::chrono::steady_clock;
+
+// Backends del registro (backend.hpp) + variantes del camino omp
+enum BackendKind { BK_REG, BK_TEAM, BK_COMPACT, BK_FAST, BK_CULL };
+
+struct BackendSpec {
+    BackendKind kind;
+    const char* name;
+    bool exact;     // mismo cálculo que la referencia salvo el orden de las sumas
+};
+const BackendSpec BACKENDS[] = {
+    {BK_REG,     "seq",     true},
+    {BK_REG,     "omp",     true},
+    {BK_TEAM,    "team",    true},
+    {BK_REG,     "ws",      true},
+    {BK_COMPACT, "compact", false},
+    {BK_FAST,    "fast",    false},
+    {BK_CULL,    "cull",    false},
+};
+
+// Umbrales por defecto. Exactos: sumas atómicas en otro orden (~1e-6 en H,
+// a lo sumo 1 nivel en la imagen). Aproximados: fp16 (|H| <= ~2 -> ~1e-3),
+// exp/pow/tanh rápidas, o bandas recortadas a |aporte| >= eps (1e-3 por gota).
+constexpr float EXACT_MAX_ERR = 1e-4f, EXACT_MIN_PSNR = 80.0f;
+constexpr float APPROX_MAX_ERR = 4e-3f, APPROX_MIN_PSNR = 55.0f;
+
+struct BackendResult {
+    double ms_frame = 0.0;
+    PlaneDiff h, ink;
+    ImageDiff img;
+};
+
+BackendResult run_backend(const BackendSpec& spec, const AppConfig& base, const GoldenFile& ref) {
+    AppConfig cfg = base;
+    if (spec.kind == BK_FAST) cfg.math = 1;
+    if (spec.kind == BK_CULL) { cfg.cull_eps = base.cull_eps > 0.0f ? base.cull_eps : 1e-3f; cfg.cull_respawn = false; }
+    const int W = cfg.width, Hh = cfg.height, F = ref.hdr.frames;
+    const size_t SZ = plane_size(W, Hh), P = size_t(plane_pitch(W));
+    const int pitch = W * int(sizeof(uint32_t));
+    const float dt = ref.hdr.dt;
+
+    World world(cfg);
+    world.init(0.0f);
+    if (drops_hash(world.drops) != ref.hdr.scene)
+        throw std::runtime_error("golden: la escena inicial no coincide con la referencia (otra versión del generador)");
+
+    std::unique_ptr<FrameTeam> team;
+    std::unique_ptr<ComputeBackend> be;
+    if (spec.kind == BK_TEAM) team = std::make_unique<FrameTeam>(cfg);
+    else be = make_backend(spec.kind == BK_REG ? spec.name : "omp", cfg);
+    CompactPlanes packed;
+    if (spec.kind == BK_COMPACT) packed.resize(SZ);
+    Plane unpacked;   // planos tal como los lee el sombreado compacto
+
+    std::vector<uint32_t> px(size_t(W) * size_t(Hh));
+    ShadeInputs in{ world.H.data(), world.CR.data(), world.CG.data(), world.CB.data(), W, Hh,
+                    cfg.slope, cfg.palette, cfg.ink_enabled, cfg.ink_strength };
+    in.fast_math = cfg.math == 1;
+    if (spec.kind == BK_COMPACT) {
+        in.H16 = packed.H.data(); in.CR16 = packed.CR.data(); in.CG16 = packed.CG.data(); in.CB16 = packed.CB.data();
+    }
+
+    BackendResult res;
+    size_t next = 0;
+    for (int f = 1; f <= F; ++f) {
+        const float t_now = float(f) * dt;
+        const auto t0 = clk::now();
+        switch (spec.kind) {
+        case BK_TEAM:
+            team->run(world, t_now, dt, px.data(), pitch);
+            break;
+        case BK_COMPACT:
+            world.maybe_respawn(t_now);
+            be->accumulate(world, t_now);
+            ink_postprocess_packed(world.CR, world.CG, world.CB, world.H, W, Hh,
+                                   dt, cfg.ink_decay, cfg.ink_blur_mix, packed);
+            #pragma omp parallel for schedule(static)
+            for (int y = 0; y < Hh; ++y) shade_row(in, y, px.data() + size_t(y) * size_t(W));
+            break;
+        default:
+            world.maybe_respawn(t_now);
+            be->accumulate(world, t_now);
+            be->ink(world, dt);
+            be->shade(world, px.data(), pitch);
+            break;
+        }
+        res.ms_frame += std::chrono::duration<double, std::milli>(clk::now() - t0).count();
+
+        if (next < ref.snaps.size() && f == ref.snaps[next].frame) {
+            const GoldenSnapshot& s = ref.snaps[next++];
+            // Solo las columnas [0, W) de cada fila: el relleno no entra en la estadística
+            auto add_plane = [&](PlaneDiff& d, const float* a, const float* b) {
+                for (int y = 0; y < Hh; ++y) d.add(a + size_t(y) * P, b + size_t(y) * P, size_t(W));
+            };
+            if (spec.kind == BK_COMPACT) {
+                unpacked.resize(SZ);
+                for (size_t i = 0; i < SZ; ++i) unpacked[i] = f16_to_f32(packed.H[i]);
+                add_plane(res.h, unpacked.data(), s.H.data());
+                const Plane16* p16[3] = {&packed.CR, &packed.CG, &packed.CB};
+                const Plane* pr[3] = {&s.CR, &s.CG, &s.CB};
+                for (int c = 0; c < 3; ++c) {
+                    for (size_t i = 0; i < SZ; ++i) unpacked[i] = from_unorm16((*p16[c])[i]);
+                    add_plane(res.ink, unpacked.data(), pr[c]->data());
+                }
+            } else {
+                add_plane(res.h, world.H.data(), s.H.data());
+                add_plane(res.ink, world.CR.data(), s.CR.data());
+                add_plane(res.ink, world.CG.data(), s.CG.data());
+                add_plane(res.ink, world.CB.data(), s.CB.data());
+            }
+            res.img.add(px.data(), s.argb.data(), px.size());
+        }
+    }
+    res.ms_frame /= F;
+    return res;
+}
+
+std::string fmt_sci(double v) {
+    std::ostringstream os;
+    os << std::scientific << std::setprecision(2) << v;
+    return os.str();
+}
+}
+
+int run_golden_check(const AppConfig& cfg_in) {
+    const GoldenFile ref = golden_read(cfg_in.golden);
+    AppConfig cfg = cfg_in;
+    golden_apply(ref.hdr, cfg);   // la escena sale de la referencia, no de la línea de comandos
+
+    std::cout << "Golden: " << cfg.golden << " " << cfg.width << "x" << cfg.height << " N=" << cfg.N
+              << " seed=" << cfg.seed << " frames=" << ref.hdr.frames << " (" << ref.snaps.size()
+              << " instantes), hilos=" << omp_get_max_threads() << "\n"
+              << "  referencia secuencial: " << std::fixed << std::setprecision(3) << ref.hdr.ms_frame
+              << " ms/frame; errores = máximo sobre los instantes, tinta = 3 canales\n";
+    std::cout << std::left << std::setw(9) << "backend" << std::right
+              << std::setw(10) << "ms/frame" << std::setw(9) << "speedup"
+              << std::setw(11) << "max|dH|" << std::setw(11) << "rms|dH|"
+              << std::setw(11) << "max|dInk|" << std::setw(11) << "rms|dInk|"
+              << std::setw(10) << "max|dRGB|" << std::setw(10) << "rms|dRGB|" << std::setw(10) << "PSNR(dB)"
+              << "  umbral\n";
+
+    int failed = 0;
+    for (const BackendSpec& spec : BACKENDS) {
+        const BackendResult r = run_backend(spec, cfg, ref);
+        const float max_err  = cfg.golden_max_err  >= 0.0f ? cfg.golden_max_err
+                                                          : (spec.exact ? EXACT_MAX_ERR : APPROX_MAX_ERR);
+        const float min_psnr = cfg.golden_min_psnr >= 0.0f ? cfg.golden_min_psnr
+                                                          : (spec.exact ? EXACT_MIN_PSNR : APPROX_MIN_PSNR);
+        const double psnr = r.img.psnr();
+        const size_t nonfinite = r.h.nonfinite + r.ink.nonfinite;
+        const bool ok = nonfinite == 0 && r.h.max_abs <= max_err && r.ink.max_abs <= max_err && psnr >= min_psnr;
+        failed += !ok;
+
+        std::ostringstream ps;
+        ps << std::fixed << std::setprecision(1) << psnr;
+        std::cout << std::left << std::setw(9) << spec.name << std::right << std::fixed
+                  << std::setw(10) << std::setprecision(3) << r.ms_frame
+                  << std::setw(9) << std::setprecision(2) << (r.ms_frame > 0.0 ? ref.hdr.ms_frame / r.ms_frame : 0.0)
+                  << std::setw(11) << fmt_sci(r.h.max_abs) << std::setw(11) << fmt_sci(r.h.rms())
+                  << std::setw(11) << fmt_sci(r.ink.max_abs) << std::setw(11) << fmt_sci(r.ink.rms())
+                  << std::setw(10) << r.img.max_rgb << std::setw(10) << std::setprecision(3) << r.img.rms()
+                  << std::setw(10) << (r.img.mse() > 0.0 ? ps.str() : "inf")
+                  << "  <=" << fmt_sci(max_err) << " >=" << std::setprecision(0) << min_psnr << "dB "
+                  << (ok ? "ok" : "FALLA");
+        if (nonfinite) std::cout << " (" << nonfinite << " valores no finitos en H/tinta)";
+        std::cout << "\n";
+    }
+    std::cout << (failed ? "Golden: FALLA (" + std::to_string(failed) + " backend(s) fuera de umbral)\n"
+                         : std::string("Golden: ok\n"));
+    return failed ? 1 : 0;
+}
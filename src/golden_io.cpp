@@ -0,0 +1,86 @@
+#include "golden.hpp"
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+std::vector<int> golden_snapshot_frames(int frames) {
+    std::vector<int> f;
+    for (int k = 1; k <= 4; ++k) {
+        const int v = (frames * k) / 4;
+        if (v >= 1 && (f.empty() || f.back() != v)) f.push_back(v);
+    }
+    return f;
+}
+
+GoldenHeader golden_header_from(const AppConfig& cfg) {
+    GoldenHeader h;
+    h.width = cfg.width; h.height = cfg.height; h.N = cfg.N; h.seed = cfg.seed;
+    h.frames = cfg.golden_frames;
+    h.palette = cfg.palette; h.ink_enabled = cfg.ink_enabled ? 1 : 0;
+    h.dt = 1.0f / 60.0f; h.slope = cfg.slope; h.spawn_rate = cfg.spawn_rate;
+    h.ink_gain = cfg.ink_gain; h.ink_decay = cfg.ink_decay;
+    h.ink_blur_mix = cfg.ink_blur_mix; h.ink_strength = cfg.ink_strength;
+    return h;
+}
+
+void golden_apply(const GoldenHeader& h, AppConfig& cfg) {
+    cfg.width = h.width; cfg.height = h.height; cfg.N = h.N; cfg.seed = h.seed;
+    cfg.golden_frames = h.frames;
+    cfg.palette = h.palette; cfg.ink_enabled = h.ink_enabled != 0;
+    cfg.slope = h.slope; cfg.spawn_rate = h.spawn_rate;
+    cfg.ink_gain = h.ink_gain; cfg.ink_decay = h.ink_decay;
+    cfg.ink_blur_mix = h.ink_blur_mix; cfg.ink_strength = h.ink_strength;
+    validate_scene(cfg, "golden");
+}
+
+void golden_write(const std::string& path, const GoldenFile& g) {
+    std::ofstream f(path, std::ios::binary | std::ios::trunc);
+    if (!f) throw std::runtime_error("golden: no se puede escribir " + path);
+    const int W = g.hdr.width, Hh = g.hdr.height;
+    const size_t SZ = size_t(W) * size_t(Hh), P = size_t(plane_pitch(W));
+    f.write(reinterpret_cast<const char*>(&g.hdr), sizeof(g.hdr));
+    for (const GoldenSnapshot& s : g.snaps) {
+        f.write(reinterpret_cast<const char*>(&s.frame), sizeof(s.frame));
+        // Filas sin el relleno de plane_pitch: el archivo no depende del paso en memoria
+        for (const Plane* p : {&s.H, &s.CR, &s.CG, &s.CB})
+            for (int y = 0; y < Hh; ++y)
+                f.write(reinterpret_cast<const char*>(p->data() + size_t(y) * P), std::streamsize(size_t(W) * sizeof(float)));
+        f.write(reinterpret_cast<const char*>(s.argb.data()), std::streamsize(SZ * sizeof(uint32_t)));
+    }
+    if (!f) throw std::runtime_error("golden: error al escribir " + path);
+}
+
+GoldenFile golden_read(const std::string& path) {
+    std::ifstream f(path, std::ios::binary);
+    if (!f) throw std::runtime_error("golden: no se puede abrir " + path);
+    GoldenFile g;
+    f.read(reinterpret_cast<char*>(&g.hdr), sizeof(g.hdr));
+    const GoldenHeader ref;
+    if (!f || std::memcmp(g.hdr.magic, ref.magic, sizeof(ref.magic)) != 0)
+        throw std::runtime_error("golden: " + path + " no es una referencia (o es de otra versión)");
+    if (g.hdr.width < 1 || g.hdr.height < 1 || g.hdr.frames < 1 || g.hdr.snapshots < 1 || g.hdr.snapshots > 4)
+        throw std::runtime_error("golden: cabecera inválida en " + path);
+    // Escena validada antes de reservar planos de width*height
+    AppConfig scene;
+    golden_apply(g.hdr, scene);
+    const int W = g.hdr.width, Hh = g.hdr.height;
+    const size_t SZ = size_t(W) * size_t(Hh), P = size_t(plane_pitch(W));
+    g.snaps.resize(size_t(g.hdr.snapshots));
+    int32_t prev = 0;
+    for (GoldenSnapshot& s : g.snaps) {
+        f.read(reinterpret_cast<char*>(&s.frame), sizeof(s.frame));
+        // La comparación avanza frame a frame hasta cada instantánea: 1..frames, crecientes
+        if (f && (s.frame <= prev || s.frame > g.hdr.frames))
+            throw std::runtime_error("golden: instantánea fuera de orden o de rango en " + path);
+        prev = s.frame;
+        for (Plane* p : {&s.H, &s.CR, &s.CG, &s.CB}) {
+            p->resize(plane_size(W, Hh));
+            for (int y = 0; y < Hh; ++y)
+                f.read(reinterpret_cast<char*>(p->data() + size_t(y) * P), std::streamsize(size_t(W) * sizeof(float)));
+        }
+        s.argb.resize(SZ);
+        f.read(reinterpret_cast<char*>(s.argb.data()), std::streamsize(SZ * sizeof(uint32_t)));
+    }
+    if (!f) throw std::runtime_error("golden: " + path + " truncado");
+    return g;
+}
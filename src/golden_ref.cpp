@@ -0,0 +1,62 @@
+#include "golden.hpp"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include "waves.hpp"
+#include "model.hpp"
+#include "ink.hpp"
+#include "shading.hpp"
+
+// Referencia secuencial: mismos kernels que el bucle de main.cpp, sin SDL
+int run_golden_write(const AppConfig& cfg_in) {
+    using clk = std::chrono::steady_clock;
+    AppConfig cfg = cfg_in;
+    if (cfg.seed < 0) cfg.seed = 1;   // la referencia tiene que poder repetirse
+    const int W = cfg.width, Hh = cfg.height, F = cfg.golden_frames;
+
+    GoldenFile g;
+    g.hdr = golden_header_from(cfg);
+    const std::vector<int> snap = golden_snapshot_frames(F);
+    g.hdr.snapshots = int(snap.size());
+
+    World world(cfg);
+    world.parallel_respawn = false;
+    world.init(0.0f);
+    g.hdr.scene = drops_hash(world.drops);
+
+    std::vector<uint32_t> px(size_t(W) * size_t(Hh));
+    const ShadeInputs in{ world.H.data(), world.CR.data(), world.CG.data(), world.CB.data(), W, Hh,
+                          cfg.slope, cfg.palette, cfg.ink_enabled, cfg.ink_strength };
+    const float dt = g.hdr.dt;
+    double ms = 0.0;
+    size_t next = 0;
+    for (int f = 1; f <= F; ++f) {
+        const float t_now = float(f) * dt;
+        const auto t0 = clk::now();
+        world.maybe_respawn(t_now);
+        seq::accumulate_heightfield(world.H, world.CR, world.CG, world.CB, W, Hh, world.drops, t_now,
+                               cfg.ink_enabled, cfg.ink_gain);
+        seq::ink_postprocess(world.CR, world.CG, world.CB, W, Hh, dt, cfg.ink_decay, cfg.ink_blur_mix);
+        for (int y = 0; y < Hh; ++y) seq::shade_row(in, y, px.data() + size_t(y) * size_t(W));
+        ms += std::chrono::duration<double, std::milli>(clk::now() - t0).count();
+
+        if (next < snap.size() && f == snap[next]) {
+            GoldenSnapshot s;
+            s.frame = f;
+            s.H = world.H; s.CR = world.CR; s.CG = world.CG; s.CB = world.CB;
+            s.argb = px;
+            g.snaps.push_back(std::move(s));
+            ++next;
+        }
+    }
+    g.hdr.ms_frame = ms / F;
+    golden_write(cfg.golden, g);
+
+    std::cout << "Golden: referencia secuencial " << W << "x" << Hh << " N=" << cfg.N << " seed=" << cfg.seed
+              << " frames=" << F << " (instantes";
+    for (int f : snap) std::cout << " " << f;
+    std::cout << ") -> " << cfg.golden << "\n"
+              << "  " << std::fixed << std::setprecision(3) << g.hdr.ms_frame << " ms/frame, escena="
+              << std::hex << g.hdr.scene << std::dec << "\n";
+    return 0;
+}
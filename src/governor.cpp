@@ -0,0 +1,84 @@
+#include "governor.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <sstream>
+
+namespace {
+constexpr double EMA_K         = 0.1;   // peso del frame nuevo en la media móvil
+constexpr double UPGRADE_RATIO = 0.70;  // recuperar por debajo de 70% del presupuesto
+constexpr double OVER_S        = 0.25;  // segundos seguidos sobre el presupuesto para degradar
+constexpr double UNDER_S       = 1.5;   // ... bajo 70% para recuperar
+constexpr double COOLDOWN_S    = 0.5;   // tras un cambio, sin decidir
+constexpr float  CULL_STEPS[]  = {3e-4f, 1e-3f, 3e-3f};
+}
+
+QualityGovernor::QualityGovernor(const AppConfig& cfg)
+: budget_ms_(1000.0 / double(cfg.target_fps)),
+  min_drops_(std::max(1, cfg.N / 4)), max_drops_(cfg.N) {}
+
+bool QualityGovernor::update(World& world, float t_now, double frame_s,
+                             double sim_ms, double ink_ms, double shade_ms) {
+    const double work = sim_ms + ink_ms + shade_ms;
+    avg_ms_ = (avg_ms_ == 0.0) ? work : (1.0 - EMA_K) * avg_ms_ + EMA_K * work;
+    if (cooldown_ > 0.0) { cooldown_ -= frame_s; return false; }
+
+    over_  = avg_ms_ > budget_ms_ ? over_ + frame_s : 0.0;
+    under_ = avg_ms_ < UPGRADE_RATIO * budget_ms_ ? under_ + frame_s : 0.0;
+
+    bool changed = false;
+    if (over_ >= OVER_S) {
+        changed = degrade(world, t_now, work > 0.0 ? ink_ms / work : 0.0);
+        over_ = 0.0;
+    } else if (under_ >= UNDER_S && !steps_.empty()) {
+        restore(world, t_now);
+        changed = true;
+        under_ = 0.0;
+    }
+    if (changed) cooldown_ = COOLDOWN_S;
+    return changed;
+}
+
+bool QualityGovernor::degrade(World& world, float t_now, double ink_share) {
+    AppConfig& c = world.cfg;
+    std::ostringstream os;
+    os << "Governor: " << avg_ms_ << " ms > " << budget_ms_ << " ms -> ";
+    if (ink_share >= 0.25 && c.ink_blur_mix > 0.0f) {
+        steps_.push_back({KNOB_BLUR, c.ink_blur_mix});
+        c.ink_blur_mix = 0.0f;
+        os << "blur de tinta off";
+    } else if (c.cull_eps < CULL_STEPS[std::size(CULL_STEPS) - 1]) {
+        steps_.push_back({KNOB_CULL, c.cull_eps});
+        for (float e : CULL_STEPS) if (e > c.cull_eps) { c.cull_eps = e; break; }
+        os << "cull-eps=" << c.cull_eps;
+    } else if (int(world.drops.size()) > min_drops_) {
+        const int n = int(world.drops.size());
+        steps_.push_back({KNOB_DROPS, float(n)});
+        world.set_active_drops(std::max(min_drops_, int(std::floor(n * 0.85))), t_now);
+        os << "gotas=" << world.drops.size();
+    } else {
+        if (at_floor_) return false;
+        at_floor_ = true;
+        os << "sin margen (calidad mínima)";
+    }
+    last_change_ = os.str();
+    return true;
+}
+
+void QualityGovernor::restore(World& world, float t_now) {
+    AppConfig& c = world.cfg;
+    const Step s = steps_.back();
+    steps_.pop_back();
+    at_floor_ = false;
+    std::ostringstream os;
+    os << "Governor: " << avg_ms_ << " ms < " << UPGRADE_RATIO * budget_ms_ << " ms -> ";
+    switch (s.knob) {
+        case KNOB_BLUR:  c.ink_blur_mix = s.prev; os << "blur de tinta=" << c.ink_blur_mix; break;
+        case KNOB_CULL:  c.cull_eps = s.prev;     os << "cull-eps=" << c.cull_eps; break;
+        case KNOB_DROPS:
+            world.set_active_drops(std::min(max_drops_, int(s.prev)), t_now);
+            os << "gotas=" << world.drops.size();
+            break;
+    }
+    last_change_ = os.str();
+}
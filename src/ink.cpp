@@ -4,27 +4,34 @@
 
 static inline float clamp01(float x){ return std::clamp(x, 0.0f, 1.0f); }
 
+namespace seq {
+
 void ink_postprocess(
-    std::vector<float>& CR,
-    std::vector<float>& CG,
-    std::vector<float>& CB,
+    Plane& CR,
+    Plane& CG,
+    Plane& CB,
     int W, int H,
     float dt,
     float decay_lambda,
     float blur_mix)
 {
-    size_t SZ = size_t(W)*size_t(H);
+    size_t SZ = plane_size(W, H);
+    const size_t P = size_t(plane_pitch(W));
     // Decay exponencial por canal
     float kdec = std::exp(-decay_lambda * std::max(0.0f, dt));
+    if (blur_mix <= 0.0f) {
+        // Sin blur se satura igual que en la mezcla
+        for (size_t i=0;i<SZ;++i){ CR[i]=clamp01(CR[i]*kdec); CG[i]=clamp01(CG[i]*kdec); CB[i]=clamp01(CB[i]*kdec); }
+        return;
+    }
     for (size_t i=0;i<SZ;++i){ CR[i]*=kdec; CG[i]*=kdec; CB[i]*=kdec; }
 
-    if (blur_mix <= 0.0f) return;
-
-    // Box blur 3x3 y mezcla
-    std::vector<float> TR(SZ), TG(SZ), TB(SZ);
+    // Box blur 3x3 y mezcla (scratch persistente en la arena, no por frame)
+    static thread_local Plane TR, TG, TB;
+    if (TR.size() != SZ) { TR.assign(SZ, 0.0f); TG.assign(SZ, 0.0f); TB.assign(SZ, 0.0f); }
     auto at = [&](int x,int y)->size_t{
         x = std::clamp(x,0,W-1); y = std::clamp(y,0,H-1);
-        return size_t(y)*size_t(W)+size_t(x);
+        return size_t(y)*P+size_t(x);
     };
     for (int y=0;y<H;++y){
         for (int x=0;x<W;++x){
@@ -34,7 +41,7 @@ void ink_postprocess(
                     size_t id = at(x+i,y+j);
                     sr += CR[id]; sg += CG[id]; sb += CB[id];
                 }
-            size_t idx = size_t(y)*size_t(W)+size_t(x);
+            size_t idx = size_t(y)*P+size_t(x);
             TR[idx] = sr/9.0f; TG[idx] = sg/9.0f; TB[idx] = sb/9.0f;
         }
     }
@@ -45,3 +52,5 @@ void ink_postprocess(
         CB[i] = clamp01(keep*CB[i] + blur_mix*TB[i]);
     }
 }
+
+} // namespace seq
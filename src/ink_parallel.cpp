@@ -1,64 +1,200 @@
 #include "ink.hpp"
+#include "numa.hpp"
+#include "cpu_dispatch.hpp"
+#include "compact.hpp"
+#include "region_sync.hpp"
 #include <algorithm>
 #include <cmath>
 #include <omp.h>
 
 static inline float clamp01(float x){ return std::clamp(x, 0.0f, 1.0f); }
 
-void ink_postprocess(
-    std::vector<float>& CR,
-    std::vector<float>& CG,
-    std::vector<float>& CB,
-    int W, int H,
-    float dt,
-    float decay_lambda,
-    float blur_mix)
-{
-    size_t SZ = size_t(W)*size_t(H);
-    
-    // Decay exponencial por canal - parallelized
-    float kdec = std::exp(-decay_lambda * std::max(0.0f, dt));
-    
-    #pragma omp parallel for
-    for (size_t i = 0; i < SZ; ++i) { 
-        CR[i] *= kdec; 
-        CG[i] *= kdec; 
-        CB[i] *= kdec; 
+// ---- Filas (hojas multiversión, sin OpenMP dentro): las comparten el camino
+// clásico, el equipo persistente y work-stealing ----
+RIPPLE_MULTIVERSION
+static void decay_span(float* CR, float* CG, float* CB, size_t i0, size_t i1, float kdec) {
+    for (size_t i = i0; i < i1; ++i) { CR[i] *= kdec; CG[i] *= kdec; CB[i] *= kdec; }
+}
+
+// Sin blur la tinta se satura igual que en la mezcla: ambos caminos quedan en [0,1]
+RIPPLE_MULTIVERSION
+static void decay_clamp_span(float* CR, float* CG, float* CB, size_t i0, size_t i1, float kdec) {
+    for (size_t i = i0; i < i1; ++i) {
+        CR[i] = clamp01(CR[i] * kdec);
+        CG[i] = clamp01(CG[i] * kdec);
+        CB[i] = clamp01(CB[i] * kdec);
     }
+}
 
-    if (blur_mix <= 0.0f) return;
+RIPPLE_MULTIVERSION
+static void clamp_span(float* CR, float* CG, float* CB, size_t i0, size_t i1) {
+    for (size_t i = i0; i < i1; ++i) { CR[i] = clamp01(CR[i]); CG[i] = clamp01(CG[i]); CB[i] = clamp01(CB[i]); }
+}
 
-    std::vector<float> TR(SZ), TG(SZ), TB(SZ);
-    
+RIPPLE_MULTIVERSION
+static void box_blur_row(const float* CR, const float* CG, const float* CB,
+                         float* TR, float* TG, float* TB, int W, int H, int y) {
+    const size_t P = size_t(plane_pitch(W));
     auto at = [&](int x,int y)->size_t{
         x = std::clamp(x,0,W-1); y = std::clamp(y,0,H-1);
-        return size_t(y)*size_t(W)+size_t(x);
+        return size_t(y)*P+size_t(x);
     };
-    
-    #pragma omp parallel for collapse(2)
-    for (int y = 0; y < H; ++y) {
-        for (int x = 0; x < W; ++x) {
-            float sr = 0, sg = 0, sb = 0;
-            for (int j = -1; j <= 1; ++j)
-                for (int i = -1; i <= 1; ++i) {
-                    size_t id = at(x+i,y+j);
-                    sr += CR[id]; 
-                    sg += CG[id]; 
-                    sb += CB[id];
-                }
-            size_t idx = size_t(y)*size_t(W)+size_t(x);
-            TR[idx] = sr/9.0f; 
-            TG[idx] = sg/9.0f; 
-            TB[idx] = sb/9.0f;
-        }
+    for (int x = 0; x < W; ++x) {
+        float sr = 0, sg = 0, sb = 0;
+        for (int j = -1; j <= 1; ++j)
+            for (int i = -1; i <= 1; ++i) {
+                size_t id = at(x+i,y+j);
+                sr += CR[id];
+                sg += CG[id];
+                sb += CB[id];
+            }
+        size_t idx = size_t(y)*P+size_t(x);
+        TR[idx] = sr/9.0f;
+        TG[idx] = sg/9.0f;
+        TB[idx] = sb/9.0f;
     }
-    
-    float keep = 1.0f - blur_mix;
-    
-    #pragma omp parallel for
-    for (size_t i = 0; i < SZ; ++i) {
+}
+
+RIPPLE_MULTIVERSION
+static void mix_span(float* CR, float* CG, float* CB, const float* TR, const float* TG, const float* TB,
+                     size_t i0, size_t i1, float keep, float blur_mix) {
+    for (size_t i = i0; i < i1; ++i) {
         CR[i] = clamp01(keep*CR[i] + blur_mix*TR[i]);
         CG[i] = clamp01(keep*CG[i] + blur_mix*TG[i]);
         CB[i] = clamp01(keep*CB[i] + blur_mix*TB[i]);
     }
 }
+
+// out != nullptr: la última pasada por fila (mezcla, o decay sin blur) empaqueta
+// además esa fila de H y de la tinta mientras sigue en L1
+static void postprocess(Plane& CR, Plane& CG, Plane& CB, int W, int H,
+                        float dt, float decay_lambda, float blur_mix,
+                        const Plane* Hf, CompactPlanes* out)
+{
+    size_t SZ = plane_size(W, H);
+    const size_t RW = size_t(plane_pitch(W));   // filas completas, relleno incluido (queda en cero)
+
+    // Decay exponencial por canal - parallelized
+    float kdec = std::exp(-decay_lambda * std::max(0.0f, dt));
+
+    // Cada pasada es una región propia (con --profile se mide su sincronización)
+    if (blur_mix <= 0.0f) {
+        RegionTimer rt;
+        #pragma omp parallel
+        {
+            rt.enter();
+            #pragma omp for nowait
+            for (int y = 0; y < H; ++y) {
+                decay_clamp_span(CR.data(), CG.data(), CB.data(), size_t(y)*RW, size_t(y+1)*RW, kdec);
+                if (out) pack_rows(Hf->data(), CR.data(), CG.data(), CB.data(), W, y, y + 1, *out);
+            }
+            rt.leave();
+        }
+        rt.close();
+        return;
+    }
+
+    {
+        RegionTimer rt;
+        #pragma omp parallel
+        {
+            rt.enter();
+            #pragma omp for nowait
+            for (int y = 0; y < H; ++y)
+                decay_span(CR.data(), CG.data(), CB.data(), size_t(y)*RW, size_t(y+1)*RW, kdec);
+            rt.leave();
+        }
+        rt.close();
+    }
+
+    // Scratch persistente: evita malloc + memset serial (y en un solo nodo) por frame.
+    // Se crea una vez con primer toque paralelo por filas. Es thread_local del hilo
+    // que llama (render o simulación); el equipo OpenMP lo usa vía referencias.
+    static thread_local Plane sR, sG, sB;
+    if (sR.size() != SZ) {
+        for (auto* p : {&sR, &sG, &sB}) { p->assign(SZ, 0.0f); first_touch_rows(*p, W, H); }
+    }
+    float* TR = sR.data();
+    float* TG = sG.data();
+    float* TB = sB.data();
+
+    {
+        RegionTimer rt;
+        #pragma omp parallel
+        {
+            rt.enter();
+            #pragma omp for nowait
+            for (int y = 0; y < H; ++y)
+                box_blur_row(CR.data(), CG.data(), CB.data(), TR, TG, TB, W, H, y);
+            rt.leave();
+        }
+        rt.close();
+    }
+
+    float keep = 1.0f - blur_mix;
+
+    RegionTimer rt;
+    #pragma omp parallel
+    {
+        rt.enter();
+        #pragma omp for nowait
+        for (int y = 0; y < H; ++y) {
+            mix_span(CR.data(), CG.data(), CB.data(), TR, TG, TB, size_t(y)*RW, size_t(y+1)*RW, keep, blur_mix);
+            if (out) pack_rows(Hf->data(), CR.data(), CG.data(), CB.data(), W, y, y + 1, *out);
+        }
+        rt.leave();
+    }
+    rt.close();
+}
+
+void ink_postprocess(
+    Plane& CR,
+    Plane& CG,
+    Plane& CB,
+    int W, int H,
+    float dt,
+    float decay_lambda,
+    float blur_mix)
+{
+    postprocess(CR, CG, CB, W, H, dt, decay_lambda, blur_mix, nullptr, nullptr);
+}
+
+void ink_postprocess_packed(
+    Plane& CR,
+    Plane& CG,
+    Plane& CB,
+    const Plane& Hf,
+    int W, int H,
+    float dt,
+    float decay_lambda,
+    float blur_mix,
+    CompactPlanes& out)
+{
+    postprocess(CR, CG, CB, W, H, dt, decay_lambda, blur_mix, &Hf, &out);
+}
+
+float ink_decay_factor(float dt, float decay_lambda) {
+    return std::exp(-decay_lambda * std::max(0.0f, dt));
+}
+
+void ink_decay_rows(Plane& CR, Plane& CG, Plane& CB, int W, int y0, int y1, float kdec) {
+    const size_t RW = size_t(plane_pitch(W));
+    decay_span(CR.data(), CG.data(), CB.data(), size_t(y0)*RW, size_t(y1)*RW, kdec);
+}
+
+void ink_blur_rows(const Plane& CR, const Plane& CG, const Plane& CB,
+                   Plane& TR, Plane& TG, Plane& TB, int W, int H, int y0, int y1) {
+    for (int y = y0; y < y1; ++y)
+        box_blur_row(CR.data(), CG.data(), CB.data(), TR.data(), TG.data(), TB.data(), W, H, y);
+}
+
+void ink_blend_rows(Plane& CR, Plane& CG, Plane& CB, const Plane& TR, const Plane& TG, const Plane& TB,
+                    int W, int y0, int y1, float blur_mix) {
+    const size_t RW = size_t(plane_pitch(W));
+    if (blur_mix <= 0.0f) {
+        clamp_span(CR.data(), CG.data(), CB.data(), size_t(y0)*RW, size_t(y1)*RW);
+        return;
+    }
+    mix_span(CR.data(), CG.data(), CB.data(), TR.data(), TG.data(), TB.data(),
+             size_t(y0)*RW, size_t(y1)*RW, 1.0f - blur_mix, blur_mix);
+}
@@ -0,0 +1,404 @@
+#include "kernel_bench.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <omp.h>
+#include "waves.hpp"
+#include "model.hpp"
+#include "ink.hpp"
+#include "shading.hpp"
+#include "tiled.hpp"
+#include "frame_team.hpp"
+#include "region_sync.hpp"
+#include "compact.hpp"
+#include "ripple_kernel.hpp"
+#include "cpu_dispatch.hpp"
+#include "fast_math.hpp"
+#include "image_diff.hpp"
+
+namespace {
+using clk = std::chrono::steady_clock;
+inline double ms_since(clk::time_point t) {
+    return std::chrono::duration<double, std::milli>(clk::now() - t).count();
+}
+struct KernelTimes { double accum = 0, ink = 0, shade = 0; };
+// Camino compacto frente al float sobre el mismo World
+struct CompactStats { double ink_pack = 0, shade = 0; float max_h = 0; ImageDiff img; };
+
+// Error máximo de las aproximaciones de fast_math.hpp en los rangos que usan los kernels
+void print_fast_math_errors() {
+    double e_exp = 0, e_powi = 0, e_tanh = 0;
+    for (float x = -40.0f; x <= 0.0f; x += 1e-4f) {
+        double ex = std::exp(double(x));
+        e_exp = std::max(e_exp, std::abs(double(fm::fast_exp(x)) - ex) / ex);
+    }
+    for (float x = 0.5f; x <= 1.0f; x += 1e-5f) {
+        double ex = std::pow(double(x), 90.0);
+        e_powi = std::max(e_powi, std::abs(double(fm::powi<90>(x)) - ex) / ex);
+    }
+    for (float x = -8.0f; x <= 8.0f; x += 1e-4f)
+        e_tanh = std::max(e_tanh, std::abs(double(fm::fast_tanh(x)) - std::tanh(double(x))));
+    std::cout << std::scientific << std::setprecision(2)
+              << "  aproximaciones: exp rel=" << e_exp << " (x en [-40,0]), x^90 rel=" << e_powi << " (x en [0.5,1])"
+              << ", tanh abs=" << e_tanh << "\n" << std::fixed;
+}
+
+// Variante de los kernels a comparar: gotas -> H (+ tinta) en t, y sombreado
+struct Variant {
+    std::function<void(World&, float)> accum;
+    std::function<void(const World&, uint32_t*)> shade;
+};
+// Resultado de b frente a a (tiempos medios por instante)
+struct VariantDiff {
+    double accum_ms[2] = {0, 0}, shade_ms[2] = {0, 0};
+    float max_h = 0.0f;
+    ImageDiff img;
+};
+
+ShadeInputs shade_inputs(const World& w, bool fast_math) {
+    const AppConfig& c = w.cfg;
+    ShadeInputs in{ w.H.data(), w.CR.data(), w.CG.data(), w.CB.data(), c.width, c.height,
+                    c.slope, c.palette, c.ink_enabled, c.ink_strength };
+    in.fast_math = fast_math;
+    return in;
+}
+
+// Mismas gotas (World nuevo con la semilla de cfg), tinta desde cero en cada
+// instante de ts: corre a y b, cronometra gotas y sombreado y compara H e imagen
+VariantDiff compare_variant(const AppConfig& cfg, const std::vector<float>& ts,
+                            const Variant& a, const Variant& b) {
+    World w(cfg);
+    w.init(0.0f);
+    VariantDiff r;
+    Plane Ha;
+    std::vector<uint32_t> px[2];
+    for (auto& p : px) p.resize(size_t(cfg.width) * size_t(cfg.height));
+    for (float t : ts) {
+        for (int v = 0; v <= 1; ++v) {
+            const Variant& var = v ? b : a;
+            for (auto* p : {&w.CR, &w.CG, &w.CB}) std::fill(p->begin(), p->end(), 0.0f);
+            auto tm = clk::now();
+            var.accum(w, t);
+            r.accum_ms[v] += ms_since(tm); tm = clk::now();
+            var.shade(w, px[v].data());
+            r.shade_ms[v] += ms_since(tm);
+            if (!v) Ha = w.H;
+            else for (size_t i = 0; i < Ha.size(); ++i) r.max_h = std::max(r.max_h, std::abs(Ha[i] - w.H[i]));
+        }
+        r.img.add(px[0], px[1]);
+    }
+    for (int v = 0; v <= 1; ++v) { r.accum_ms[v] /= double(ts.size()); r.shade_ms[v] /= double(ts.size()); }
+    return r;
+}
+
+void print_error(const VariantDiff& d) {
+    std::cout << "  error: max|dH|=" << std::setprecision(6) << d.max_h << ", ";
+    d.img.print(std::cout);
+    std::cout << "\n";
+}
+
+// --math fast frente a exact (incluye instantes con gotas en fase de splash para
+// cubrir la corona sin trigonometría)
+void bench_fast_math(const AppConfig& cfg) {
+    auto variant = [&](bool fast) {
+        return Variant{
+            [=](World& w, float t) {
+                const AppConfig& c = w.cfg;
+                accumulate_heightfield(w.H, w.CR, w.CG, w.CB, c.width, c.height, w.drops, t,
+                                       c.ink_enabled, c.ink_gain, fast);
+            },
+            [=](const World& w, uint32_t* px) { shade_frame(shade_inputs(w, fast), px, w.cfg.width * 4); }};
+    };
+    const std::vector<float> ts = {0.05f, 0.15f, 0.5f, 1.0f, 2.0f};
+    const VariantDiff d = compare_variant(cfg, ts, variant(false), variant(true));
+    std::cout << std::setprecision(3) << "Math fast vs exact (" << ts.size() << " instantes): accum exact="
+              << d.accum_ms[0] << " ms, fast=" << d.accum_ms[1] << " ms | shade exact="
+              << d.shade_ms[0] << " ms, fast=" << d.shade_ms[1] << " ms\n";
+    print_error(d);
+    print_fast_math_errors();
+}
+
+// Culling por amplitud: mismas gotas con y sin eps. Píxeles evaluados contados
+// exactamente sobre las bandas (drop_band)
+void bench_cull(const AppConfig& cfg) {
+    const float eps = cfg.cull_eps > 0.0f ? cfg.cull_eps : 1e-3f;
+    const float ink_gain = cfg.ink_enabled ? cfg.ink_gain : 0.0f;
+    const int W = cfg.width, Hh = cfg.height;
+    const std::vector<float> ts = {0.5f, 1.0f, 2.0f, 3.0f};
+
+    World scene(cfg, false);
+    scene.init(0.0f);
+    double px[2] = {0, 0};
+    for (float t : ts)
+        for (int cull = 0; cull <= 1; ++cull)
+            for (const Drop& d : scene.drops) {
+                DropBand b;
+                if (!drop_band(d, t, W, Hh, b, cull ? eps : 0.0f, ink_gain)) continue;
+                for (int y = b.ymin; y <= b.ymax; ++y)
+                    for (int x = b.xmin; x <= b.xmax; ++x) {
+                        float dx = float(x) + 0.5f - d.x, dy = float(y) + 0.5f - d.y;
+                        float r2 = dx*dx + dy*dy;
+                        px[cull] += (r2 >= b.rmin2 && r2 <= b.rmax2);
+                    }
+            }
+
+    auto variant = [&](float e) {
+        return Variant{
+            [=](World& w, float t) {
+                const AppConfig& c = w.cfg;
+                accumulate_heightfield(w.H, w.CR, w.CG, w.CB, c.width, c.height, w.drops, t,
+                                       c.ink_enabled, c.ink_gain, c.math == 1, e);
+            },
+            [](const World& w, uint32_t* p) { shade_frame(shade_inputs(w, false), p, w.cfg.width * 4); }};
+    };
+    const VariantDiff d = compare_variant(cfg, ts, variant(0.0f), variant(eps));
+    const double k = 1.0 / double(ts.size());
+    std::cout << std::setprecision(3) << "Culling eps=" << eps << " (" << ts.size() << " instantes): px evaluados "
+              << std::setprecision(0) << px[0]*k << " -> " << px[1]*k << " por frame (ahorro "
+              << std::setprecision(1) << (px[0] > 0 ? 100.0 * (1.0 - px[1] / px[0]) : 0.0) << "%)"
+              << std::setprecision(3) << " | accum " << d.accum_ms[0] << " -> " << d.accum_ms[1] << " ms\n";
+    print_error(d);
+}
+
+// Ciclo de vida: maybe_respawn (heap de expiración + lote) frente al barrido O(N)
+// que hacía antes, con N grande y 10 s simulados para que haya expiraciones
+void bench_lifecycle(const AppConfig& cfg, float dt) {
+    AppConfig cl = cfg;
+    cl.N = std::max(cfg.N, 200000);
+    cl.cull_eps = 0.0f;
+    World wl(cl, false);
+    auto tm = clk::now();
+    wl.init(0.0f);
+    const double ms_init = ms_since(tm);
+    const int lf = 600;
+    double ms_heap = 0.0, ms_scan = 0.0;
+    long expired = 0, resp = 0;
+    for (int f = 1; f <= lf; ++f) {
+        const float t = float(f) * dt;
+        tm = clk::now();
+        for (const Drop& d : wl.drops) expired += (t - d.t0 > d.maxLife);
+        ms_scan += ms_since(tm);
+        tm = clk::now();
+        wl.maybe_respawn(t);
+        ms_heap += ms_since(tm);
+        resp += wl.respawned;
+    }
+    std::cout << std::setprecision(3) << "Ciclo de vida N=" << cl.N << " (" << lf << " frames): init="
+              << ms_init << " ms, respawn=" << ms_heap / lf << " ms/frame ("
+              << std::setprecision(1) << double(resp) / lf << " gotas/frame)"
+              << std::setprecision(3) << " | solo barrer O(N)=" << ms_scan / lf << " ms/frame"
+              << (expired == resp ? "" : " [expiradas distintas]") << "\n";
+}
+
+// Throughput por variante especializada (ink on/off, paleta) sobre el estado de w
+void bench_specializations(World& w, float t, int reps, std::vector<uint32_t>& px) {
+    const int W = w.cfg.width, Hh = w.cfg.height;
+    const double mpx = double(W) * double(Hh) * 1e-6;
+    int splash_drops = 0;
+    for (const Drop& d : w.drops) { float tau = t - d.t0; splash_drops += (tau > 0.0f && tau <= TAU_SPLASH_MAX); }
+    std::cout << "Variantes (" << reps << " reps, gotas en splash=" << splash_drops << "/" << w.drops.size() << "):\n"
+              << std::left << std::setw(22) << "kernel" << std::right << std::setw(10) << "ms" << std::setw(10) << "Mpx/s" << "\n";
+    auto vrow = [&](const std::string& name, const std::function<void()>& run) {
+        auto tm = clk::now();
+        for (int r = 0; r < reps; ++r) run();
+        const double ms = ms_since(tm) / reps;
+        std::cout << std::left << std::setw(22) << name << std::right << std::fixed
+                  << std::setw(10) << std::setprecision(3) << ms
+                  << std::setw(10) << std::setprecision(1) << (ms > 0 ? mpx / (ms * 1e-3) : 0.0) << "\n";
+    };
+    for (int ink = 0; ink <= 1; ++ink)
+        vrow(std::string("accum ink=") + char('0' + ink), [&] {
+            accumulate_heightfield(w.H, w.CR, w.CG, w.CB, W, Hh, w.drops, t, ink != 0, w.cfg.ink_gain);
+        });
+    const char* pal_names[3] = {"aqua", "mix", "real"};
+    for (int pal = 0; pal < 3; ++pal)
+        for (int ink = 0; ink <= 1; ++ink) {
+            ShadeInputs in = shade_inputs(w, false);
+            in.palette_mode = pal; in.ink_enabled = ink != 0;
+            vrow(std::string("shade ") + pal_names[pal] + " ink=" + char('0' + ink),
+                 [&] { shade_frame(in, px.data(), W * int(sizeof(uint32_t))); });
+        }
+}
+}
+
+int run_kernel_bench(const AppConfig& cfg_in) {
+    AppConfig cfg = cfg_in;
+    if (cfg.seed < 0) cfg.seed = 1;   // ambos World deben ser idénticos
+    const int frames = cfg.bench_frames;
+    const int warmup = std::min(5, frames / 5);
+    const float dt = 1.0f / 60.0f;
+    const int W = cfg.width, Hh = cfg.height;
+
+    // 4 World (16) + scratch de tinta OpenMP (3) + scratch del backend por tiles (3)
+    // + scratch del motor team (3) + frame compacto (4 planos de 16 bits = 2)
+    FrameArena::global().reserve(W, Hh, 16 + 3 + 3 + 3 + 2);
+    World wo(cfg), ww(cfg), wc(cfg), wt(cfg);
+    wo.init(0.0f); ww.init(0.0f); wc.init(0.0f); wt.init(0.0f);
+    const uint64_t scene = drops_hash(wo.drops);
+    std::vector<uint32_t> po(size_t(W)*size_t(Hh)), pw(po.size());
+    const int pitch = W * int(sizeof(uint32_t));
+
+    WorkStealingPool pool(omp_get_max_threads());
+    TiledBackend tiled(cfg, pool);
+
+    CompactPlanes packed;
+    packed.resize(plane_size(W, Hh));
+    std::vector<uint32_t> pc(po.size());
+    CompactStats cs;
+
+    // Sincronización medida por frame: motor de regiones (el camino OpenMP de abajo,
+    // 5 regiones) frente al equipo persistente sobre otro World con la misma escena
+    FrameTeam team(cfg);
+    std::vector<uint32_t> pt(po.size());
+    RegionSyncStats sync_regions;
+    TeamStats sync_team;
+    double team_ms = 0.0;
+
+    KernelTimes to, tw;
+    uint64_t steals[3] = {0, 0, 0};
+    for (int f = 0; f < frames; ++f) {
+        const float t_now = float(f) * dt;
+        const bool rec = f >= warmup;
+
+        // ---- OpenMP (motor de regiones) ----
+        wo.maybe_respawn(t_now);
+        double a, b, c;
+        {
+            RegionProbe probe;
+            auto t0 = clk::now();
+            accumulate_heightfield(wo.H, wo.CR, wo.CG, wo.CB, W, Hh, wo.drops, t_now,
+                                   cfg.ink_enabled, cfg.ink_gain);
+            a = ms_since(t0); t0 = clk::now();
+            ink_postprocess(wo.CR, wo.CG, wo.CB, W, Hh, dt, cfg.ink_decay, cfg.ink_blur_mix);
+            b = ms_since(t0); t0 = clk::now();
+            shade_frame(shade_inputs(wo, false), po.data(), pitch);
+            c = ms_since(t0);
+            if (rec) sync_regions.add(probe.take());
+        }
+        if (rec) { to.accum += a; to.ink += b; to.shade += c; }
+
+        // ---- Mismo frame con el equipo persistente (una región) ----
+        {
+            auto t0 = clk::now();
+            team.run(wt, t_now, dt, pt.data(), pitch);
+            if (rec) {
+                team_ms += ms_since(t0);
+                const TeamStats& ts = team.stats();
+                sync_team.fork_join_ms += ts.fork_join_ms;
+                sync_team.barrier_ms += ts.barrier_ms;
+            }
+        }
+
+        // ---- Mismo frame en compacto, como el pipeline: la tinta empaqueta en su última pasada ----
+        wc.maybe_respawn(t_now);
+        accumulate_heightfield(wc.H, wc.CR, wc.CG, wc.CB, W, Hh, wc.drops, t_now,
+                               cfg.ink_enabled, cfg.ink_gain);
+        auto t0 = clk::now();
+        ink_postprocess_packed(wc.CR, wc.CG, wc.CB, wc.H, W, Hh, dt, cfg.ink_decay, cfg.ink_blur_mix, packed);
+        double pk = ms_since(t0); t0 = clk::now();
+        {
+            ShadeInputs in = shade_inputs(wc, false);
+            in.H = in.CR = in.CG = in.CB = nullptr;
+            in.H16 = packed.H.data(); in.CR16 = packed.CR.data(); in.CG16 = packed.CG.data(); in.CB16 = packed.CB.data();
+            shade_frame(in, pc.data(), pitch);
+        }
+        double sc = ms_since(t0);
+        if (rec) {
+            cs.ink_pack += pk; cs.shade += sc;
+            for (size_t i = 0; i < packed.H.size(); ++i)
+                cs.max_h = std::max(cs.max_h, std::abs(wc.H[i] - f16_to_f32(packed.H[i])));
+            cs.img.add(po, pc);
+        }
+
+        // ---- Tiles + work-stealing ----
+        ww.maybe_respawn(t_now);
+        pool.reset_steals(); t0 = clk::now();
+        tiled.accumulate(ww, t_now);
+        a = ms_since(t0); if (rec) steals[0] += pool.steals();
+        pool.reset_steals(); t0 = clk::now();
+        tiled.ink(ww, dt);
+        b = ms_since(t0); if (rec) steals[1] += pool.steals();
+        pool.reset_steals(); t0 = clk::now();
+        tiled.shade(ww, pw.data(), pitch);
+        c = ms_since(t0); if (rec) steals[2] += pool.steals();
+        if (rec) { tw.accum += a; tw.ink += b; tw.shade += c; }
+    }
+
+    // Diferencias (sumas atómicas en otro orden -> difieren en redondeo)
+    float dH = 0.0f;
+    for (size_t i = 0; i < wo.H.size(); ++i) dH = std::max(dH, std::abs(wo.H[i] - ww.H[i]));
+    int dpx = 0;
+    for (size_t i = 0; i < po.size(); ++i)
+        for (int sh = 0; sh <= 16; sh += 8)
+            dpx = std::max(dpx, std::abs(int((po[i] >> sh) & 255u) - int((pw[i] >> sh) & 255u)));
+
+    const double n = double(std::max(1, frames - warmup));
+    auto row = [&](const char* name, double o, double w, uint64_t st){
+        std::cout << std::left << std::setw(8) << name << std::right << std::fixed << std::setprecision(3)
+                  << std::setw(12) << o/n << std::setw(12) << w/n
+                  << std::setw(10) << std::setprecision(2) << (w > 0 ? o/w : 0.0)
+                  << std::setw(12) << std::setprecision(1) << double(st)/n << "\n";
+    };
+    std::cout << "Kernel bench: " << W << "x" << Hh << " N=" << cfg.N << " frames=" << frames
+              << " (warmup " << warmup << ") hilos=" << omp_get_max_threads()
+              << " gotas/tile=" << std::setprecision(1) << std::fixed << tiled.drops_per_tile()
+              << " escena=" << std::hex << scene << std::dec << "\n"
+              << cpu_dispatch_report() << "\n";
+    std::cout << std::left << std::setw(8) << "kernel" << std::right << std::setw(12) << "omp(ms)"
+              << std::setw(12) << "ws(ms)" << std::setw(10) << "speedup" << std::setw(12) << "robos/frame" << "\n";
+    row("accum", to.accum, tw.accum, steals[0]);
+    row("ink",   to.ink,   tw.ink,   steals[1]);
+    row("shade", to.shade, tw.shade, steals[2]);
+    row("total", to.accum + to.ink + to.shade, tw.accum + tw.ink + tw.shade, steals[0] + steals[1] + steals[2]);
+    std::cout << std::setprecision(6) << "max|dH|=" << dH << ", max|dRGB|=" << dpx << "\n";
+
+    // Sincronización medida (media por hilo fuera del cuerpo de los bucles)
+    {
+        ImageDiff img;
+        img.add(po, pt);
+        std::cout << std::setprecision(3) << "Sync por frame: regions=" << sync_regions.total_ms()/n
+                  << " ms (fork/join=" << sync_regions.fork_join_ms/n << ", barreras implícitas="
+                  << sync_regions.barrier_ms/n << "; " << std::setprecision(1)
+                  << double(sync_regions.regions)/n << " regiones)" << std::setprecision(3)
+                  << " | team=" << (sync_team.fork_join_ms + sync_team.barrier_ms)/n
+                  << " ms (fork/join=" << sync_team.fork_join_ms/n << ", barreras=" << sync_team.barrier_ms/n
+                  << "; 1 región + 2 barreras)\n"
+                  << "  frame omp=" << (to.accum + to.ink + to.shade)/n << " ms, team=" << team_ms/n
+                  << " ms (incluye respawn); imagen team vs omp: ";
+        img.print(std::cout);
+        std::cout << "\n";
+    }
+
+    // Almacenamiento compacto: bytes por frame que cuesta entregar el frame al sombreado
+    // y sombrearlo (accum y la tinta en float son comunes a todos y no se cuentan).
+    //   clásico f32:     shade lee H + tinta (16)
+    //   pipeline f32:    copia de la tinta al slot (12 + 12) + shade (16)
+    //   pipeline compacto: la última pasada de tinta relee H (4) y escribe el frame
+    //                    empaquetado (8) + shade (8)
+    {
+        const double mib = double(po.size()) / double(1 << 20);
+        std::cout << std::setprecision(2)
+                  << "Compacto (H fp16 + tinta unorm16), bytes/frame entrega + sombreado:\n"
+                  << "  clásico f32 16 B/px = " << 16 * mib << " MiB; pipeline f32 40 B/px = " << 40 * mib
+                  << " MiB; pipeline compacto 20 B/px = " << 20 * mib << " MiB (incluye el empaquetado)\n";
+    }
+    std::cout << std::setprecision(3)
+              << "  tinta+pack=" << cs.ink_pack/n << " ms (tinta f32=" << to.ink/n << " ms), shade16="
+              << cs.shade/n << " ms (shade f32=" << to.shade/n << " ms)\n"
+              << "  error vs f32: max|dH|=" << std::setprecision(6) << cs.max_h << ", ";
+    cs.img.print(std::cout);
+    std::cout << "\n";
+
+    bench_fast_math(cfg);
+    bench_cull(cfg);
+    bench_lifecycle(cfg, dt);
+    // Mismo estado final del World OpenMP
+    bench_specializations(wo, float(frames) * dt, std::max(3, std::min(20, frames / 5)), po);
+    return 0;
+}
@@ -6,12 +6,52 @@
 #include "config.hpp"
 #include "waves.hpp"
 #include "model.hpp"
-#include "shading.hpp"
+#include "render_sdl.hpp"
 #include "ink.hpp"
+#include "perfcounters.hpp"
+#include "sim_thread.hpp"
+#include "golden.hpp"
+#include "drop_log.hpp"
+#include "checkpoint.hpp"
+#include "metrics.hpp"
+#include <memory>
 
 int main(int argc, char** argv) {
     try {
         AppConfig cfg = parse_args(argc, argv);
+        // La versión secuencial es la referencia exacta (también la que graba --golden)
+        if (cfg.math == 1)
+            throw std::runtime_error("--math fast solo en screensaver_parallel (la versión secuencial siempre usa matemática exacta)");
+        // El kernel secuencial no recorta bandas: --cull-eps solo pagaría el barrido
+        // O(N) por frame y --cull-respawn cambiaría la escena de referencia
+        if (cfg.cull_eps > 0.0f || cfg.cull_respawn)
+            throw std::runtime_error("--cull-eps/--cull-respawn solo en screensaver_parallel (la versión secuencial no hace culling)");
+        // Modos y opciones de screensaver_parallel: aquí se ignorarían en silencio
+        const char* par_only = !cfg.export_path.empty() ? "--export"
+                             : !cfg.shm_name.empty()    ? "--shm"
+                             : !cfg.replay.empty()      ? "--replay"
+                             : cfg.bench_frames > 0     ? "--bench-kernels"
+                             : cfg.pipeline > 0         ? "--pipeline"
+                             : cfg.engine != 0          ? "--engine team"
+                             : cfg.backend != "omp"     ? "--backend/--sched"
+                             : cfg.threads > 0          ? "--threads"
+                             : cfg.pin != 0             ? "--pin"
+                             : cfg.storage != 0         ? "--storage compact"
+                             : cfg.target_fps > 0.0f    ? "--target-fps"
+                             : nullptr;
+        if (par_only)
+            throw std::runtime_error(std::string(par_only) + " solo en screensaver_parallel (la versión secuencial no lo implementa)");
+        if (cfg.mpi_scaling)
+            throw std::runtime_error("--mpi-scaling solo en screensaver_mpi");
+        if (!cfg.golden.empty()) {
+            if (!cfg.scene_args) throw std::runtime_error("--golden escribe la referencia: Parametros requeridos: --width, --height, --N");
+            return run_golden_write(cfg);
+        }
+        if (!cfg.restore.empty()) {
+            load_checkpoint_scene(cfg.restore, cfg);
+            if (cfg.cull_eps > 0.0f)
+                throw std::runtime_error("--restore: el checkpoint se grabó con --cull-eps; restaurarlo con screensaver_parallel");
+        }
 
         if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_TIMER) != 0) {
             std::cerr << "SDL_Init error: " << SDL_GetError() << "\n";
@@ -45,15 +85,75 @@ int main(int argc, char** argv) {
         }
 
         PixelBuffer pb;
-        if (!create_pixel_buffer(renderer, cfg.width, cfg.height, pb)) {
+        if (!create_pixel_buffer(renderer, cfg.width, cfg.height, pb, cfg.textures, cfg.upload)) {
             std::cerr << "SDL_CreateTexture: " << SDL_GetError() << "\n";
             SDL_DestroyRenderer(renderer); SDL_DestroyWindow(window); SDL_Quit(); return 1;
         }
 
+        // Planos WxH en una sola reserva: World (4) + scratch de tinta (3)
+        // + triple buffer del hilo de simulación (3 x 4). Primer toque en serie:
+        // aquí los kernels recorren los planos desde un solo hilo
+        FrameArena::global().reserve(cfg.width, cfg.height,
+                                     4 + 3 + (cfg.sim_hz > 0.0f ? 12 : 0), false);
+
         World world(cfg);
+        world.parallel_respawn = false;
+        std::unique_ptr<DropRecorder> recorder;
+        if (!cfg.record.empty()) {
+            recorder = std::make_unique<DropRecorder>(cfg.record, world);
+            world.recorder = recorder.get();
+        }
         Uint64 pf = SDL_GetPerformanceFrequency();
         Uint64 t0 = SDL_GetPerformanceCounter();
-        world.init(0.0f);
+        if (!cfg.restore.empty())
+            std::cout << restore_checkpoint(cfg.restore, world, 0.0f).describe(cfg.restore) << "\n";
+        else
+            world.init(0.0f);
+
+        // Contadores HW opcionales (degradan a no-op si no hay acceso)
+        enum { ST_SIM, ST_INK, ST_SHADE, ST_PRESENT };
+        PerfCounters perf({"sim", "ink", "shade", "present"});
+        if (cfg.perfcounters) {
+            perf.open(1);
+            std::cout << perf.status() << "\n";
+        }
+
+        // Simulación a paso fijo en su propio hilo (opcional): este hilo solo
+        // atiende eventos y sombrea/presenta el último frame publicado.
+        std::unique_ptr<SimThread> sim;
+        if (cfg.sim_hz > 0.0f) {
+            sim = std::make_unique<SimThread>(world);
+            sim->start();
+        }
+        if (cfg.fpslog || cfg.profile) std::cout << FrameArena::global().describe() << "\n";
+        uint64_t sim_steps_prev = 0, sim_drop_prev = 0, sim_late_prev = 0;
+        int render_new = 0, render_repeat = 0;
+        std::string rate_info;
+
+        // Métricas en vivo (--metrics): una muestra por frame; trabajo de las gotas y
+        // área con tinta ~1 vez por segundo
+        std::unique_ptr<MetricsServer> metrics;
+        if (!cfg.metrics.empty()) {
+            metrics = std::make_unique<MetricsServer>(cfg.metrics, "screensaver", cfg.width, cfg.height);
+            std::cout << metrics->describe() << "\n";
+        }
+        auto publish = [&](double dt_s, double sim_ms, double ink_ms, double shade_ms, double present_ms,
+                           float t_now, const FrameSlot* fs) {
+            FrameSample s;
+            s.frame_ms = float(dt_s * 1000.0);
+            s.sim_ms = float(sim_ms); s.ink_ms = float(ink_ms);
+            s.shade_ms = float(shade_ms); s.present_ms = float(present_ms);
+            s.drops = int(world.drops.size());
+            if (metrics->want_scene()) {
+                // Con --sim-hz las gotas son del hilo de simulación: solo los planos del slot
+                if (!fs) s.px_drops = drops_pixel_work(world, t_now);
+                const Plane& CR = fs ? fs->CR : world.CR;
+                const Plane& CG = fs ? fs->CG : world.CG;
+                const Plane& CB = fs ? fs->CB : world.CB;
+                s.ink_area = cfg.ink_enabled ? ink_active_fraction(CR, CG, CB, cfg.width, cfg.height, cfg.ink_strength) : 0.0f;
+            }
+            metrics->push(s);
+        };
 
         bool running = true;
         SDL_Event ev;
@@ -64,11 +164,13 @@ int main(int argc, char** argv) {
             tt<<"Rain Ripples"
               <<" | "<<cfg.width<<"x"<<cfg.height
               <<" | N="<<cfg.N
-              <<" | FPS="<<(int)std::round(fps);
+              <<" | FPS="<<(int)std::round(fps)
+              <<rate_info;
             SDL_SetWindowTitle(window, tt.str().c_str());
         };
         update_title(0.0);
 
+        float t_last = 0.0f;   // tiempo simulado del último frame (--checkpoint)
         while (running) {
             while (SDL_PollEvent(&ev)) {
                 if (ev.type == SDL_QUIT) running = false;
@@ -80,41 +182,100 @@ int main(int argc, char** argv) {
             t0 = t1;
             static double accTime = 0.0; accTime += dt;
             float t_now = float(accTime);
+            t_last = t_now;
 
-            world.maybe_respawn(t_now);
-
-            // ---- Simulación + inyección de tinta ----
-            Uint64 tA = 0, tB = 0, tC = 0;
-            if (cfg.profile) tA = SDL_GetPerformanceCounter();
-
-            accumulate_heightfield(
-                world.H, world.CR, world.CG, world.CB,
-                cfg.width, cfg.height, world.drops, t_now,
-                cfg.ink_enabled, cfg.ink_gain
-            );
-
-            // Difusión/decay de tinta
-            ink_postprocess(world.CR, world.CG, world.CB,
-                            cfg.width, cfg.height,
-                            float(dt), cfg.ink_decay, cfg.ink_blur_mix);
-
-            if (cfg.profile) tB = SDL_GetPerformanceCounter();
-
-            // ---- Render ----
-            SDL_SetRenderDrawColor(renderer, 8,12,18,255);
-            SDL_RenderClear(renderer);
-            shade_and_present(renderer, pb, world.H,
-                              world.CR, world.CG, world.CB,
-                              cfg.slope, cfg.palette,
-                              cfg.ink_enabled, cfg.ink_strength);
-            SDL_RenderPresent(renderer);
-
-            if (cfg.profile) {
-                tC = SDL_GetPerformanceCounter();
-                double k = 1000.0 / double(pf);
-                double sim_ms   = (tB - tA) * k;
-                double shade_ms = (tC - tB) * k;
-                std::cout << "sim+ink=" << sim_ms << " ms, shade+present=" << shade_ms << " ms\n";
+            if (sim) {
+                // ---- Último frame del hilo de simulación ----
+                bool fresh = sim->fetch();
+                const FrameSlot& fs = sim->latest();
+
+                Uint64 tB = SDL_GetPerformanceCounter();
+                SDL_SetRenderDrawColor(renderer, 8,12,18,255);
+                SDL_RenderClear(renderer);
+                perf.begin(ST_SHADE);
+                if (fresh) {
+                    seq::shade_and_present(renderer, pb, fs.H,
+                                           fs.CR, fs.CG, fs.CB,
+                                           cfg.slope, cfg.palette,
+                                           cfg.ink_enabled, cfg.ink_strength);
+                    render_new++;
+                } else {
+                    // Nada nuevo: se re-presenta la textura anterior sin volver a sombrear
+                    if (pb.tex) SDL_RenderCopy(renderer, pb.tex, nullptr, nullptr);
+                    render_repeat++;
+                }
+                perf.end(ST_SHADE);
+                Uint64 tS = SDL_GetPerformanceCounter();
+                perf.begin(ST_PRESENT);
+                SDL_RenderPresent(renderer);
+                perf.end(ST_PRESENT);
+                perf.frame_done();
+                if (metrics) {
+                    const double k = 1000.0 / double(pf);
+                    publish(dt, fresh ? fs.sim_ms : -1.0, -1.0, (tS - tB) * k,
+                            (SDL_GetPerformanceCounter() - tS) * k, t_now, &fs);
+                }
+
+                if (cfg.profile && fresh) {
+                    double shade_ms = (SDL_GetPerformanceCounter() - tB) * 1000.0 / double(pf);
+                    std::cout << "sim+ink(simthread)=" << fs.sim_ms << " ms, shade+present=" << shade_ms
+                              << " ms, " << upload_profile(pb) << "\n";
+                }
+                // Sin vsync el render no debe girar en vacío esperando al simulador
+                if (!fresh && cfg.novsync) SDL_Delay(1);
+            } else {
+                world.maybe_respawn(t_now);
+
+                // ---- Simulación + inyección de tinta ----
+                const bool timed = cfg.profile || metrics;
+                Uint64 tA = 0, tI = 0, tB = 0, tS = 0, tC = 0;
+                if (timed) tA = SDL_GetPerformanceCounter();
+
+                perf.begin(ST_SIM);
+                seq::accumulate_heightfield(
+                    world.H, world.CR, world.CG, world.CB,
+                    cfg.width, cfg.height, world.drops, t_now,
+                    cfg.ink_enabled, cfg.ink_gain
+                );
+                perf.end(ST_SIM);
+                if (timed) tI = SDL_GetPerformanceCounter();
+
+                // Difusión/decay de tinta
+                perf.begin(ST_INK);
+                seq::ink_postprocess(world.CR, world.CG, world.CB,
+                                     cfg.width, cfg.height,
+                                     float(dt), cfg.ink_decay, cfg.ink_blur_mix);
+                perf.end(ST_INK);
+
+                if (timed) tB = SDL_GetPerformanceCounter();
+
+                // ---- Render ----
+                SDL_SetRenderDrawColor(renderer, 8,12,18,255);
+                SDL_RenderClear(renderer);
+                perf.begin(ST_SHADE);
+                seq::shade_and_present(renderer, pb, world.H,
+                                       world.CR, world.CG, world.CB,
+                                       cfg.slope, cfg.palette,
+                                       cfg.ink_enabled, cfg.ink_strength);
+                perf.end(ST_SHADE);
+                if (timed) tS = SDL_GetPerformanceCounter();
+                perf.begin(ST_PRESENT);
+                SDL_RenderPresent(renderer);
+                perf.end(ST_PRESENT);
+                perf.frame_done();
+                if (timed) tC = SDL_GetPerformanceCounter();
+                if (metrics) {
+                    const double k = 1000.0 / double(pf);
+                    publish(dt, (tI - tA) * k, (tB - tI) * k, (tS - tB) * k, (tC - tS) * k, t_now, nullptr);
+                }
+
+                if (cfg.profile) {
+                    double k = 1000.0 / double(pf);
+                    double sim_ms   = (tB - tA) * k;
+                    double shade_ms = (tC - tB) * k;
+                    std::cout << "sim+ink=" << sim_ms << " ms, shade+present=" << shade_ms
+                              << " ms, " << upload_profile(pb) << "\n";
+                }
             }
 
             // ---- FPS (cada ~1s) ----
@@ -122,13 +283,47 @@ int main(int argc, char** argv) {
             if (fps_accum >= 1.0) {
                 double fps_inst = fps_frames / fps_accum;
                 fps_smoothed = (fps_smoothed==0.0) ? fps_inst : (0.8*fps_smoothed + 0.2*fps_inst);
+                if (sim) {
+                    uint64_t st = sim->steps(), dr = sim->dropped(), lt = sim->late();
+                    double sim_rate = double(st - sim_steps_prev) / fps_accum;
+                    std::ostringstream ri;
+                    // --sim-hz admite fracciones: tasa y objetivo con un decimal
+                    ri << std::fixed << std::setprecision(1)
+                       << " | Sim=" << sim_rate << "/" << sim->hz() << "Hz"
+                       << " | SimDrop=" << dr << " | Repeat=" << render_repeat;
+                    rate_info = ri.str();
+                    if (cfg.profile || cfg.fpslog) {
+                        std::cout << "simthread: rate=" << std::fixed << std::setprecision(1) << sim_rate
+                                  << " Hz (target " << sim->hz() << ")" << std::defaultfloat << std::setprecision(6)
+                                  << ", late=" << (lt - sim_late_prev)
+                                  << ", dropped=" << (dr - sim_drop_prev)
+                                  << " | render: fps=" << fps_inst
+                                  << ", new=" << render_new << ", repeat=" << render_repeat << "\n";
+                    }
+                    sim_steps_prev = st; sim_drop_prev = dr; sim_late_prev = lt;
+                    render_new = 0; render_repeat = 0;
+                }
                 update_title(fps_smoothed);
                 if (cfg.fpslog) std::cout << "FPS= " << fps_smoothed << "\n";
+                perf.report(size_t(cfg.width) * size_t(cfg.height));
                 fps_accum = 0.0; fps_frames = 0;
             }
         }
 
-        SDL_DestroyTexture(pb.tex);
+        if (sim) {
+            sim->stop();
+            t_last = sim->last_t_now();   // el World puede ir por delante del último frame mostrado
+        }
+        if (!cfg.checkpoint.empty()) {
+            save_checkpoint(cfg.checkpoint, world, t_last);
+            std::cout << "Checkpoint: " << cfg.checkpoint << " t=" << t_last << " s\n";
+        }
+        if (recorder) {
+            world.recorder = nullptr;
+            recorder->close(world);
+            std::cout << recorder->summary() << "\n";
+        }
+        destroy_pixel_buffer(pb);
         SDL_DestroyRenderer(renderer);
         SDL_DestroyWindow(window);
         SDL_Quit();
@@ -0,0 +1,315 @@
+// Muro de video MPI: un lienzo virtual (p. ej. 15360x4320) repartido en franjas
+// horizontales, una por rango. Cada rango:
+//   - avanza la misma escena global (World sin planos, semilla difundida por el
+//     rango 0: la lista de gotas nunca viaja por la red),
+//   - acumula H y tinta solo en su franja + 1 fila de halo por lado (los kernels
+//     reciben la fila del lienzo de la franja: mismo resultado que un solo proceso),
+//   - intercambia con sus vecinos las filas de borde de H (estencil del sombreado)
+//     y de CR/CG/CB (blur 3x3 de la tinta),
+//   - sombrea sus filas y, con --export, escribe su propio tile.
+// Con --mpi-scaling repite la corrida con 1, 2, 4... rangos del mismo mpirun
+// (subcomunicadores) e imprime el escalado fuerte y débil.
+//
+//   mpirun -np 4 ./screensaver_mpi --width 15360 --height 4320 --N 20000 --mpi-scaling
+#include <mpi.h>
+#include <omp.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+#include "backend.hpp"
+#include "config.hpp"
+#include "frame_export.hpp"
+#include "numa.hpp"
+#include "rng.hpp"
+#include "waves.hpp"
+
+namespace {
+using clk = std::chrono::steady_clock;
+
+inline double ms_between(clk::time_point a, clk::time_point b) {
+    return std::chrono::duration<double, std::milli>(b - a).count();
+}
+
+// Filas [y0, y1) del lienzo para el rango r de p (las primeras Hg % p llevan una más)
+struct Strip {
+    int y0 = 0, y1 = 0;
+    int top = 0, bot = 0;      // 1 si hay fila de halo arriba / abajo (vecino)
+    int rows() const { return y1 - y0; }
+    int local_rows() const { return rows() + top + bot; }
+    int offset() const { return y0 - top; }   // fila global de la fila local 0
+};
+
+Strip make_strip(int Hg, int r, int p) {
+    Strip s;
+    const int base = Hg / p, rem = Hg % p;
+    s.y0 = r * base + std::min(r, rem);
+    s.y1 = s.y0 + base + (r < rem ? 1 : 0);
+    s.top = r > 0 ? 1 : 0;
+    s.bot = r < p - 1 ? 1 : 0;
+    return s;
+}
+
+// Ruta del tile de cada rango: "muro.y4m" -> "muro_r3.y4m"
+std::string rank_path(const std::string& path, int rank) {
+    const size_t slash = path.find_last_of('/');
+    size_t dot = path.find_last_of('.');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) dot = path.size();
+    return path.substr(0, dot) + "_r" + std::to_string(rank) + path.substr(dot);
+}
+
+// Intercambio de halos: las filas de borde propias de H, CR, CG y CB van empaquetadas
+// en un solo mensaje por vecino (4*W floats)
+class HaloExchange {
+public:
+    HaloExchange(MPI_Comm comm, const Strip& s, int W) : comm_(comm), s_(s), W_(W) {
+        int r, p;
+        MPI_Comm_rank(comm, &r);
+        MPI_Comm_size(comm, &p);
+        up_ = r > 0 ? r - 1 : MPI_PROC_NULL;
+        down_ = r < p - 1 ? r + 1 : MPI_PROC_NULL;
+        for (auto* b : {&send_up_, &send_down_, &recv_up_, &recv_down_}) b->resize(size_t(4) * size_t(W));
+    }
+
+    void run(World& w) {
+        Plane* planes[4] = {&w.H, &w.CR, &w.CG, &w.CB};
+        const size_t W = size_t(W_), P = size_t(plane_pitch(W_));   // fila y en y*P
+        const size_t first = size_t(s_.top);                       // primera fila propia
+        const size_t last = size_t(s_.top + s_.rows() - 1);        // última fila propia
+        for (int k = 0; k < 4; ++k) {
+            std::memcpy(&send_up_[k * W], planes[k]->data() + first * P, W * sizeof(float));
+            std::memcpy(&send_down_[k * W], planes[k]->data() + last * P, W * sizeof(float));
+        }
+        const int n = int(4 * W);
+        MPI_Sendrecv(send_up_.data(), n, MPI_FLOAT, up_, 0, recv_down_.data(), n, MPI_FLOAT, down_, 0,
+                     comm_, MPI_STATUS_IGNORE);
+        MPI_Sendrecv(send_down_.data(), n, MPI_FLOAT, down_, 1, recv_up_.data(), n, MPI_FLOAT, up_, 1,
+                     comm_, MPI_STATUS_IGNORE);
+        for (int k = 0; k < 4; ++k) {
+            if (s_.top) std::memcpy(planes[k]->data(), &recv_up_[k * W], W * sizeof(float));
+            if (s_.bot) std::memcpy(planes[k]->data() + (last + 1) * P, &recv_down_[k * W], W * sizeof(float));
+        }
+        bytes_ += uint64_t(s_.top + s_.bot) * 2 * 4 * W * sizeof(float);   // enviado + recibido
+    }
+    uint64_t bytes() const { return bytes_; }
+
+private:
+    MPI_Comm comm_;
+    Strip s_;
+    int W_;
+    int up_ = MPI_PROC_NULL, down_ = MPI_PROC_NULL;
+    std::vector<float> send_up_, send_down_, recv_up_, recv_down_;
+    uint64_t bytes_ = 0;
+};
+
+enum { ST_SCENE, ST_ACCUM, ST_INK, ST_HALO, ST_SHADE, ST_OUT, ST_COUNT };
+const char* const STAGE_NAMES[ST_COUNT] = {"escena", "gotas", "tinta", "halo", "sombreado", "salida"};
+
+struct WallResult {
+    int ranks = 0, W = 0, H = 0, N = 0, frames = 0;
+    double wall_s = 0.0;
+    double stage_max[ST_COUNT] = {}, stage_mean[ST_COUNT] = {};   // ms/frame entre rangos
+    double halo_mb = 0.0;                                          // MiB/frame en todo el muro
+    double fps() const { return wall_s > 0.0 ? frames / wall_s : 0.0; }
+    double ms() const { return wall_s * 1e3 / std::max(1, frames); }
+    double imbalance() const {     // cómputo del rango más lento / media (1 = parejo)
+        double mx = 0.0, mean = 0.0;
+        for (int k : {ST_ACCUM, ST_INK, ST_SHADE}) { mx += stage_max[k]; mean += stage_mean[k]; }
+        return mean > 0.0 ? mx / mean : 1.0;
+    }
+};
+
+// Una corrida del muro sobre comm (colectiva); el resultado vale en el rango 0
+WallResult run_wall(const AppConfig& cfg, uint64_t seed, MPI_Comm comm, bool export_tiles) {
+    int rank, P;
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &P);
+    const int W = cfg.width, Hg = cfg.height;
+    if (Hg < 2 * P) throw std::runtime_error("lienzo con menos de 2 filas por rango");
+    const Strip s = make_strip(Hg, rank, P);
+    const float dt = 1.0f / 60.0f;
+
+    // Escena global, idéntica en todos los rangos
+    World scene(cfg, false);
+    scene.seed = seed;
+    scene.init(0.0f);
+
+    // Franja local: mismas perillas, alto = filas propias + halos
+    AppConfig lc = cfg;
+    lc.height = s.local_rows();
+    lc.canvas_y0 = s.offset();
+    lc.canvas_h = Hg;
+    World tile(lc);
+    for (auto* pl : {&tile.H, &tile.CR, &tile.CG, &tile.CB})
+        first_touch_rows(*pl, W, lc.height);
+    std::unique_ptr<ComputeBackend> be = make_backend(cfg.backend, lc);
+    HaloExchange halo(comm, s, W);
+    std::vector<uint32_t> px(size_t(W) * size_t(lc.height));
+    const int pitch = W * int(sizeof(uint32_t));
+
+    std::unique_ptr<FrameExporter> ex;
+    if (export_tiles) {
+        const std::string path = rank_path(cfg.export_path, rank);
+        ex = std::make_unique<FrameExporter>(path, export_format_for(path, cfg.export_format),
+                                             W, s.rows(), 60.0f, cfg.export_queue);
+    }
+
+    double st[ST_COUNT] = {};
+    MPI_Barrier(comm);
+    const double w0 = MPI_Wtime();
+    for (int k = 1; k <= cfg.mpi_frames; ++k) {
+        const float t_now = float(k) * dt;
+        const clk::time_point t0 = clk::now();
+        // Gotas en coordenadas del lienzo: el kernel recorta cada banda a las filas
+        // de la franja (canvas_y0) y usa la fila del lienzo para el jitter
+        scene.maybe_respawn(t_now);
+        tile.drops = scene.drops;
+        const clk::time_point t1 = clk::now();
+        be->accumulate(tile, t_now);
+        const clk::time_point t2 = clk::now();
+        be->ink(tile, dt);
+        const clk::time_point t3 = clk::now();
+        halo.run(tile);
+        const clk::time_point t4 = clk::now();
+        be->shade(tile, px.data(), pitch);
+        const clk::time_point t5 = clk::now();
+        if (ex) {
+            ExportFrame* f = ex->acquire();
+            if (f) {
+                std::memcpy(f->argb.data(), px.data() + size_t(s.top) * size_t(W),
+                            size_t(s.rows()) * size_t(pitch));
+                ex->encode(*f);
+                f->index = k - 1;
+                ex->submit(f);
+            }
+        }
+        const clk::time_point t6 = clk::now();
+        st[ST_SCENE] += ms_between(t0, t1); st[ST_ACCUM] += ms_between(t1, t2);
+        st[ST_INK] += ms_between(t2, t3); st[ST_HALO] += ms_between(t3, t4);
+        st[ST_SHADE] += ms_between(t4, t5); st[ST_OUT] += ms_between(t5, t6);
+    }
+    if (ex) ex->finish();
+    MPI_Barrier(comm);
+    const double w1 = MPI_Wtime();
+
+    WallResult res;
+    res.ranks = P; res.W = W; res.H = Hg; res.N = cfg.N; res.frames = cfg.mpi_frames;
+    res.wall_s = w1 - w0;
+    for (double& v : st) v /= double(cfg.mpi_frames);
+    MPI_Reduce(st, res.stage_max, ST_COUNT, MPI_DOUBLE, MPI_MAX, 0, comm);
+    MPI_Reduce(st, res.stage_mean, ST_COUNT, MPI_DOUBLE, MPI_SUM, 0, comm);
+    for (double& v : res.stage_mean) v /= double(P);
+    double hb = double(halo.bytes()) / 2.0, hb_sum = 0.0;   // contar cada fila una vez
+    MPI_Reduce(&hb, &hb_sum, 1, MPI_DOUBLE, MPI_SUM, 0, comm);
+    res.halo_mb = hb_sum / double(cfg.mpi_frames) / double(1 << 20);
+    return res;
+}
+
+void print_result(const WallResult& r, int threads) {
+    std::cout << std::fixed << std::setprecision(2)
+              << "Muro: " << r.W << "x" << r.H << " N=" << r.N << " en " << r.ranks << " rangos x "
+              << threads << " hilos (franjas de ~" << r.H / r.ranks << " filas), " << r.frames << " frames en "
+              << r.wall_s << " s = " << r.fps() << " fps (" << r.ms() << " ms/frame)\n"
+              << "  ms/frame por etapa (máx / media entre rangos):";
+    for (int k = 0; k < ST_COUNT; ++k)
+        std::cout << " " << STAGE_NAMES[k] << "=" << r.stage_max[k] << "/" << r.stage_mean[k];
+    std::cout << "\n  halos=" << r.halo_mb << " MiB/frame, desbalance de cómputo=" << r.imbalance() << "x\n";
+}
+
+// Escalado con p = 1, 2, 4, ... (y el total) rangos del mismo mpirun.
+// Fuerte: el lienzo y N de la línea de comandos, fijos.
+// Débil: por rango 1/P del alto y de N (con p = P coincide con el fuerte).
+void run_scaling(const AppConfig& cfg, uint64_t seed, MPI_Comm world) {
+    int rank, P;
+    MPI_Comm_rank(world, &rank);
+    MPI_Comm_size(world, &P);
+    std::vector<int> counts;
+    for (int p = 1; p < P; p *= 2) counts.push_back(p);
+    counts.push_back(P);
+
+    std::vector<WallResult> strong, weak;
+    for (int p : counts) {
+        MPI_Comm sub;
+        MPI_Comm_split(world, rank < p ? 0 : MPI_UNDEFINED, rank, &sub);
+        if (sub != MPI_COMM_NULL) {
+            WallResult a = run_wall(cfg, seed, sub, false);
+            AppConfig wc = cfg;
+            wc.height = std::max(2 * p, int(int64_t(cfg.height) * p / P));
+            wc.N = std::max(1, int(int64_t(cfg.N) * p / P));
+            WallResult b = run_wall(wc, seed, sub, false);
+            if (rank == 0) {
+                strong.push_back(a); weak.push_back(b);
+                std::cout << "  p=" << p << " listo\n" << std::flush;
+            }
+            MPI_Comm_free(&sub);
+        }
+        MPI_Barrier(world);
+    }
+    if (rank != 0) return;
+
+    auto table = [&](const char* title, const std::vector<WallResult>& rs, bool weak_mode) {
+        std::cout << title << "\n"
+                  << "  rangos   lienzo        N       ms/frame   fps      speedup  eficiencia  halo ms  desbalance\n";
+        const double base = rs.front().ms();
+        for (const WallResult& r : rs) {
+            // Fuerte: T1 / Tp y T1 / (p Tp). Débil: T1 / Tp (ideal 1)
+            const double sp = weak_mode ? base / r.ms() * r.ranks : base / r.ms();
+            const double ef = weak_mode ? base / r.ms() : base / (r.ms() * r.ranks);
+            std::ostringstream dim;
+            dim << r.W << "x" << r.H;
+            std::cout << std::fixed << std::setprecision(2) << "  " << std::setw(6) << r.ranks << "   "
+                      << std::left << std::setw(12) << dim.str() << std::right << std::setw(7) << r.N
+                      << std::setw(11) << r.ms() << std::setw(9) << r.fps() << std::setw(9) << sp
+                      << std::setw(11) << 100.0 * ef << "%" << std::setw(9) << r.stage_max[ST_HALO]
+                      << std::setw(10) << r.imbalance() << "x\n";
+        }
+    };
+    table("Escalado fuerte (lienzo fijo):", strong, false);
+    table("Escalado débil (alto y N por rango fijos):", weak, true);
+}
+}
+
+int main(int argc, char** argv) {
+    int provided = 0;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+    int rank = 0, P = 1;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &P);
+    try {
+        AppConfig cfg = parse_args(argc, argv);
+        if (cfg.threads > 0) omp_set_num_threads(cfg.threads);
+        if (!cfg.golden.empty()) throw std::runtime_error("--golden: la referencia la graba screensaver y la compara screensaver_parallel");
+        if (cfg.export_path == "-") throw std::runtime_error("--export: cada rango escribe su tile, no se admite stdout");
+
+        // Una sola semilla para todos: la escena es la misma en cada rango
+        unsigned long long seed = rank == 0 ? resolve_seed(cfg.seed) : 0;
+        MPI_Bcast(&seed, 1, MPI_UNSIGNED_LONG_LONG, 0, MPI_COMM_WORLD);
+
+        if (rank == 0)
+            std::cout << "MPI: " << P << " rangos, backend=" << cfg.backend << ", hilos/rango="
+                      << omp_get_max_threads() << ", semilla=" << seed << "\n" << std::flush;
+        if (cfg.mpi_scaling) {
+            run_scaling(cfg, seed, MPI_COMM_WORLD);
+        } else {
+            const WallResult r = run_wall(cfg, seed, MPI_COMM_WORLD, !cfg.export_path.empty());
+            if (rank == 0) {
+                print_result(r, omp_get_max_threads());
+                if (!cfg.export_path.empty())
+                    std::cout << "  tiles: " << rank_path(cfg.export_path, 0) << " .. "
+                              << rank_path(cfg.export_path, P - 1) << "\n";
+            }
+        }
+    } catch (const std::exception& ex) {
+        std::cerr << "Error (rango " << rank << "): " << ex.what() << "\n";
+        if (rank == 0) print_usage(argv[0]);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+        return 1;
+    }
+    MPI_Finalize();
+    return 0;
+}
@@ -3,15 +3,76 @@
 #include <sstream>
 #include <iomanip>
 #include <cmath>
+#include <algorithm>
 #include "config.hpp"
 #include "waves.hpp"
 #include "model.hpp"
-#include "shading.hpp"
+#include "render_sdl.hpp"
 #include "ink.hpp"
+#include "perfcounters.hpp"
+#include "pipeline.hpp"
+#include "frame_team.hpp"
+#include "region_sync.hpp"
+#include "ripple.hpp"
+#include "kernel_bench.hpp"
+#include "numa.hpp"
+#include "cpu_dispatch.hpp"
+#include "governor.hpp"
+#include "golden.hpp"
+#include "frame_export.hpp"
+#include "shm_ring.hpp"
+#include "drop_log.hpp"
+#include "checkpoint.hpp"
+#include "metrics.hpp"
+#include <memory>
+#include <omp.h>
 
 int main(int argc, char** argv) {
     try {
         AppConfig cfg = parse_args(argc, argv);
+        // El hilo a paso fijo es de la versión secuencial; aquí el desacople es --pipeline
+        if (cfg.sim_hz > 0.0f)
+            throw std::runtime_error("--sim-hz solo en screensaver (secuencial); en paralelo usar --pipeline D");
+        // Opciones de la ventana: los modos sin ventana las ignorarían en silencio
+        const char* headless = cfg.bench_frames > 0     ? "--bench-kernels"
+                             : !cfg.golden.empty()      ? "--golden"
+                             : !cfg.replay.empty()      ? "--replay"
+                             : !cfg.export_path.empty() ? "--export"
+                             : !cfg.shm_name.empty()    ? "--shm"
+                             : nullptr;
+        const char* win_only = cfg.pipeline > 0         ? "--pipeline"
+                             : cfg.engine != 0          ? "--engine team"
+                             : cfg.storage != 0         ? "--storage compact"
+                             : cfg.target_fps > 0.0f    ? "--target-fps"
+                             : cfg.upload != 0          ? "--upload"
+                             : cfg.textures != 2        ? "--textures"
+                             : nullptr;
+        if (headless && win_only)
+            throw std::runtime_error(std::string(win_only) + " solo en modo ventana (no aplica a " + headless + ")");
+        if (cfg.threads > 0) omp_set_num_threads(cfg.threads);   // también dimensiona el pool ws
+        const std::array<std::string, 3> stages = parse_backend_spec(cfg.backend);
+        const bool uses_ws = stages[0] == "ws" || stages[1] == "ws" || stages[2] == "ws";
+        const bool omp_only = stages[0] == "omp" && stages[1] == "omp" && stages[2] == "omp";
+        // Combinaciones inválidas: se rechazan antes de abrir SDL o reservar nada
+        if (cfg.engine == 1 && cfg.pipeline > 0)
+            throw std::runtime_error("--engine team no se combina con --pipeline");
+        if (!omp_only && (cfg.pipeline > 0 || cfg.engine == 1))
+            throw std::runtime_error("--backend " + cfg.backend + " no se combina con --pipeline ni --engine team (usan omp)");
+        // Almacenamiento compacto del frame a sombrear: solo en los slots del pipeline,
+        // donde reemplaza la copia float de la tinta. En el camino clásico el sombreado
+        // ya lee los planos float; empaquetarlos sumaría tráfico en vez de ahorrarlo.
+        if (cfg.storage == 1 && (cfg.pipeline == 0 || !omp_only))
+            throw std::runtime_error("--storage compact solo con --pipeline y --backend omp");
+        // El gobernador ajusta world.cfg / world.drops entre frames, así que necesita
+        // que el World sea de este hilo (no con el pipeline)
+        if (cfg.target_fps > 0.0f && cfg.pipeline > 0)
+            throw std::runtime_error("--target-fps no se combina con --pipeline");
+        if (cfg.bench_frames > 0) return run_kernel_bench(cfg);
+        if (!cfg.golden.empty()) return run_golden_check(cfg);
+        if (!cfg.replay.empty()) return run_replay(cfg);
+        if (!cfg.restore.empty()) load_checkpoint_scene(cfg.restore, cfg);
+        if (!cfg.export_path.empty()) return run_export(cfg);
+        if (!cfg.shm_name.empty()) return run_shm(cfg);
 
         if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_TIMER) != 0) {
             std::cerr << "SDL_Init error: " << SDL_GetError() << "\n";
@@ -45,35 +106,154 @@ int main(int argc, char** argv) {
         }
 
         PixelBuffer pb;
-        if (!create_pixel_buffer(renderer, cfg.width, cfg.height, pb)) {
+        if (!create_pixel_buffer(renderer, cfg.width, cfg.height, pb, cfg.textures, cfg.upload)) {
             std::cerr << "SDL_CreateTexture: " << SDL_GetError() << "\n";
             SDL_DestroyRenderer(renderer); SDL_DestroyWindow(window); SDL_Quit(); return 1;
         }
 
-        World world(cfg);
+        // Topología + pinning antes de crear los buffers: el primer toque debe
+        // hacerlo el hilo (ya fijado) que luego recorre esas filas.
+        NumaTopology topo = read_numa_topology();
+        std::cout << describe_topology(topo) << "\n";
+        std::cout << cpu_dispatch_report() << "\n";
+        if (cfg.pin) std::cout << pin_omp_threads(topo, cfg.pin) << "\n";
+
+        // Todos los planos WxH salen de una sola reserva: World (4) + scratch de
+        // tinta (3) + slots del pipeline + scratch del motor team/ws (3)
+        int planes = 4 + 3;
+        if (cfg.pipeline > 0) planes += (cfg.storage == 1 ? 2 : 4) * (cfg.pipeline + 1);
+        if (cfg.engine == 1 || uses_ws) planes += 3;
+        FrameArena::global().reserve(cfg.width, cfg.height, planes);
+
+        // Simulación + sombreado (biblioteca ripple): el frontend solo aporta la textura
+        RippleEngine engine(cfg);
+        World& world = engine.world();
+        if (!engine.restore_info().empty()) std::cout << engine.restore_info() << "\n";
         Uint64 pf = SDL_GetPerformanceFrequency();
         Uint64 t0 = SDL_GetPerformanceCounter();
-        world.init(0.0f);
+
+        // Pipeline opcional: la simulación del frame n+1 corre en otro hilo mientras
+        // este sombrea/presenta el frame n. Los hilos OpenMP se reparten entre ambos.
+        std::unique_ptr<FramePipeline> pipe;
+        const int compute_threads = omp_get_max_threads();
+        if (cfg.pipeline > 0) {
+            int P = omp_get_max_threads();
+            int shade_threads = std::max(1, P/3);
+            int sim_threads   = std::max(1, P - shade_threads);
+            omp_set_num_threads(shade_threads);
+            pipe = std::make_unique<FramePipeline>(world, cfg.pipeline, sim_threads);
+            pipe->start();
+            std::cout << "Pipeline: depth=" << cfg.pipeline
+                      << ", hilos sim=" << sim_threads << ", hilos shade=" << shade_threads << "\n";
+        }
+
+        // Motor de equipo persistente (una región paralela por frame)
+        std::unique_ptr<FrameTeam> team;
+        if (cfg.engine == 1) team = std::make_unique<FrameTeam>(cfg);
+
+        // Backend de cómputo del camino clásico (pipeline y team usan los kernels omp)
+        ComputeBackend* backend = nullptr;
+        if (!pipe && !team) {
+            engine.set_backend(cfg.backend);
+            backend = &engine.backend();
+            std::cout << "Backend: " << backend->name() << " (hilos=" << omp_get_max_threads()
+                      << "; tecla B alterna " << backend_names() << ")\n";
+        }
+        // Gobernador de calidad (ajusta world.cfg / world.drops entre frames)
+        std::unique_ptr<QualityGovernor> gov;
+        if (cfg.target_fps > 0.0f) {
+            gov = std::make_unique<QualityGovernor>(cfg);
+            std::cout << "Governor: objetivo " << cfg.target_fps << " FPS (" << gov->budget_ms() << " ms de cómputo por frame)\n";
+        }
+        // Sincronización: estimación de arranque (micro-benchmark) y, por frame, la
+        // medida en cada región del camino clásico (RegionProbe) o del equipo (TeamStats)
+        std::unique_ptr<RegionProbe> region_probe;
+        if (cfg.profile && !pipe) {
+            SyncOverhead so = measure_sync_overhead();
+            std::cout << "Sync (estimación): fork/join=" << so.fork_join_us << " us, barrier=" << so.barrier_us
+                      << " us -> por frame: regions~" << 5.0*so.fork_join_us
+                      << " us (5 regiones), team~" << so.fork_join_us + 2.0*so.barrier_us
+                      << " us (1 región + 2 barreras)\n";
+            if (!team) region_probe = std::make_unique<RegionProbe>();
+        }
+
+        if (cfg.fpslog || cfg.profile) std::cout << FrameArena::global().describe() << "\n";
+        // Dónde quedó cada bloque de filas tras el primer toque (solo consulta)
+        if (cfg.profile) {
+            std::cout << describe_placement("H", world.H, cfg.width, cfg.height, topo) << "\n";
+            std::cout << describe_placement("CR", world.CR, cfg.width, cfg.height, topo) << "\n";
+        }
+
+        // Contadores HW opcionales (degradan a no-op si no hay acceso)
+        enum { ST_SIM, ST_INK, ST_SHADE, ST_PRESENT, ST_TEAM };
+        PerfCounters perf({"sim", "ink", "shade", "present", "team"});
+        if (cfg.perfcounters) {
+            perf.open(omp_get_max_threads());
+            std::cout << perf.status() << "\n";
+        }
+
+        // Métricas en vivo: una muestra por frame al anillo del servidor; lo que
+        // cuesta O(N) u O(W*H) (trabajo de las gotas, área con tinta) ~1 vez por segundo
+        std::unique_ptr<MetricsServer> metrics;
+        if (!cfg.metrics.empty()) {
+            metrics = std::make_unique<MetricsServer>(cfg.metrics, "screensaver_parallel", cfg.width, cfg.height);
+            std::cout << metrics->describe() << "\n";
+        }
+        auto publish = [&](double dt_s, double sim_ms, double ink_ms, double shade_ms, double present_ms,
+                           float t_now, const FrameSlot* fs) {
+            FrameSample s;
+            s.frame_ms = float(dt_s * 1000.0);
+            s.sim_ms = float(sim_ms); s.ink_ms = float(ink_ms);
+            s.shade_ms = float(shade_ms); s.present_ms = float(present_ms);
+            s.drops = int(world.drops.size());
+            s.threads = compute_threads;
+            const CullStats& cs = fs ? fs->cull : world.cull;
+            if (world.cfg.cull_eps > 0.0f) s.culled = cs.invisible;
+            if (metrics->want_scene()) {
+                // Con el pipeline las gotas son del otro hilo: solo lo que trae el slot
+                if (world.cfg.cull_eps > 0.0f) s.px_drops = cs.px_kept;
+                else if (!fs) s.px_drops = drops_pixel_work(world, t_now);
+                if (!cfg.ink_enabled) s.ink_area = 0.0f;
+                else if (!fs) s.ink_area = ink_active_fraction(world.CR, world.CG, world.CB, cfg.width, cfg.height, cfg.ink_strength);
+                else if (cfg.storage == 0) s.ink_area = ink_active_fraction(fs->CR, fs->CG, fs->CB, cfg.width, cfg.height, cfg.ink_strength);
+            }
+            metrics->push(s);
+        };
 
         bool running = true;
         SDL_Event ev;
 
         double fps_accum = 0.0; int fps_frames = 0; double fps_smoothed = 0.0;
+        CullStats cull_acc;   // --cull-eps: se reporta junto con los FPS
         auto update_title = [&](double fps){
             std::ostringstream tt;
             tt<<"Rain Ripples (Parallel)"
               <<" | "<<cfg.width<<"x"<<cfg.height
-              <<" | N="<<cfg.N
+              <<" | N="<<world.drops.size()
               <<" | SpawnRate="<<cfg.spawn_rate
+              <<(pipe ? " | Pipeline" : "")
+              <<(team ? " | Team" : "")
+              <<(backend ? " | " + backend->name() : "")
+              <<(gov ? " | Q=-" + std::to_string(gov->level()) : "")
               <<" | FPS="<<(int)std::round(fps);
             SDL_SetWindowTitle(window, tt.str().c_str());
         };
         update_title(0.0);
 
+        float t_last = 0.0f;   // tiempo simulado del último frame (--checkpoint)
         while (running) {
             while (SDL_PollEvent(&ev)) {
                 if (ev.type == SDL_QUIT) running = false;
                 else if (ev.type == SDL_KEYDOWN && ev.key.keysym.sym == SDLK_ESCAPE) running = false;
+                else if (ev.type == SDL_KEYDOWN && ev.key.keysym.sym == SDLK_b && backend) {
+                    // Siguiente backend del registro (las tres etapas)
+                    const auto& reg = backend_registry();
+                    size_t k = 0;
+                    while (k < reg.size() && backend->name() != reg[k].name) ++k;
+                    engine.set_backend(reg[(k + 1) % reg.size()].name);
+                    backend = &engine.backend();
+                    std::cout << "Backend: " << backend->name() << "\n";
+                }
             }
 
             Uint64 t1 = SDL_GetPerformanceCounter();
@@ -81,43 +261,142 @@ int main(int argc, char** argv) {
             t0 = t1;
             static double accTime = 0.0; accTime += dt;
             float t_now = float(accTime);
+            t_last = t_now;
+
+            if (pipe) {
+                // ---- Frame ya simulado por el hilo del pipeline ----
+                FrameSlot* fs = pipe->acquire();
+                if (!fs) break;
+
+                Uint64 tB = SDL_GetPerformanceCounter();
+                SDL_SetRenderDrawColor(renderer, 8,12,18,255);
+                SDL_RenderClear(renderer);
+                perf.begin(ST_SHADE);
+                if (cfg.storage == 1)
+                    shade_and_present(renderer, pb, fs->packed,
+                                      cfg.slope, cfg.palette,
+                                      cfg.ink_enabled, cfg.ink_strength, cfg.math == 1);
+                else
+                    shade_and_present(renderer, pb, fs->H,
+                                      fs->CR, fs->CG, fs->CB,
+                                      cfg.slope, cfg.palette,
+                                      cfg.ink_enabled, cfg.ink_strength, cfg.math == 1);
+                perf.end(ST_SHADE);
+                Uint64 tS = SDL_GetPerformanceCounter();
+                perf.begin(ST_PRESENT);
+                SDL_RenderPresent(renderer);
+                perf.end(ST_PRESENT);
+                perf.frame_done();
+                Uint64 tC = SDL_GetPerformanceCounter();
+                if (metrics) {
+                    const double k = 1000.0 / double(pf);
+                    publish(dt, fs->sim_ms, -1.0, (tS - tB) * k, (tC - tS) * k, t_now, fs);
+                }
+
+                if (cfg.profile) {
+                    double shade_ms = (tC - tB) * 1000.0 / double(pf);
+                    // latencia: inicio de simulación -> frame presentado
+                    double lat_ms = std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - fs->t_start).count();
+                    std::cout << "sim+ink(pipeline)=" << fs->sim_ms
+                              << " ms, shade+present(pipeline)=" << shade_ms
+                              << " ms, latency=" << lat_ms
+                              << " ms, queue=" << pipe->queued() << "/" << pipe->depth()
+                              << ", " << upload_profile(pb) << "\n";
+                }
+                cull_acc.add(fs->cull);
+                pipe->release(fs);
+            } else if (team) {
+                // ---- Frame completo en una sola región paralela ----
+                SDL_SetRenderDrawColor(renderer, 8,12,18,255);
+                SDL_RenderClear(renderer);
+                shade_into_texture(renderer, pb, [&](uint32_t* px, int pitch) {
+                    perf.begin(ST_TEAM);
+                    team->run(world, t_now, float(dt), px, pitch);
+                    perf.end(ST_TEAM);
+                });
+                Uint64 tP = SDL_GetPerformanceCounter();
+                if (gov) {
+                    const TeamStats& ts = team->stats();
+                    if (gov->update(world, t_now, dt, ts.sim_ms, ts.ink_ms, ts.shade_ms)) std::cout << gov->last_change() << "\n";
+                }
+                perf.begin(ST_PRESENT);
+                SDL_RenderPresent(renderer);
+                perf.end(ST_PRESENT);
+                perf.frame_done();
+                double present_ms = (SDL_GetPerformanceCounter() - tP) * 1000.0 / double(pf);
+                if (metrics) {
+                    // sim = respawn + limpiar H + gotas; tinta y sombreado repartidos por tareas
+                    const TeamStats& ts = team->stats();
+                    publish(dt, ts.sim_ms, ts.ink_ms, ts.shade_ms, present_ms, t_now, nullptr);
+                }
+
+                if (cfg.profile) {
+                    const TeamStats& ts = team->stats();
+                    std::cout << "sim(team)=" << ts.sim_ms << " ms, ink(team)=" << ts.ink_ms
+                              << " ms, shade+present(team)=" << (ts.shade_ms + present_ms)
+                              << " ms, sync=" << ts.fork_join_ms + ts.barrier_ms << " ms (fork/join="
+                              << ts.fork_join_ms << ", barreras=" << ts.barrier_ms << "; 1 región + "
+                              << ts.barriers << " barreras, " << ts.threads << " hilos), " << upload_profile(pb) << "\n";
+                }
+            } else {
+                engine.respawn(t_now);
+
+                // ---- Simulación + inyección de tinta (backend) ----
+                const bool timed = cfg.profile || gov || metrics;
+                Uint64 tA = 0, tI = 0, tB = 0, tS = 0, tC = 0;
+                if (timed) tA = SDL_GetPerformanceCounter();
 
-            world.maybe_respawn(t_now);
-
-            // ---- Simulación + inyección de tinta (PARALLEL) ----
-            Uint64 tA = 0, tB = 0, tC = 0;
-            if (cfg.profile) tA = SDL_GetPerformanceCounter();
-
-            accumulate_heightfield(
-                world.H, world.CR, world.CG, world.CB,
-                cfg.width, cfg.height, world.drops, t_now,
-                cfg.ink_enabled, cfg.ink_gain
-            );
-
-            // Difusión/decay de tinta (PARALLEL)
-            ink_postprocess(world.CR, world.CG, world.CB,
-                            cfg.width, cfg.height,
-                            float(dt), cfg.ink_decay, cfg.ink_blur_mix);
-
-            if (cfg.profile) tB = SDL_GetPerformanceCounter();
-
-            // ---- Render (PARALLEL) ----
-            SDL_SetRenderDrawColor(renderer, 8,12,18,255);
-            SDL_RenderClear(renderer);
-            shade_and_present(renderer, pb, world.H,
-                              world.CR, world.CG, world.CB,
-                              cfg.slope, cfg.palette,
-                              cfg.ink_enabled, cfg.ink_strength);
-            SDL_RenderPresent(renderer);
-
-            if (cfg.profile) {
-                tC = SDL_GetPerformanceCounter();
-                double k = 1000.0 / double(pf);
-                double sim_ms   = (tB - tA) * k;
-                double shade_ms = (tC - tB) * k;
-                std::cout << "sim+ink(parallel)=" << sim_ms << " ms, shade+present(parallel)=" << shade_ms << " ms\n";
+                perf.begin(ST_SIM);
+                engine.accumulate();
+                perf.end(ST_SIM);
+                if (timed) tI = SDL_GetPerformanceCounter();
+
+                // Difusión/decay de tinta
+                perf.begin(ST_INK);
+                engine.ink(float(dt));
+                perf.end(ST_INK);
+
+                if (timed) tB = SDL_GetPerformanceCounter();
+
+                // ---- Render ----
+                SDL_SetRenderDrawColor(renderer, 8,12,18,255);
+                SDL_RenderClear(renderer);
+                perf.begin(ST_SHADE);
+                shade_into_texture(renderer, pb, [&](uint32_t* px, int pitch) { engine.shade(px, pitch); });
+                perf.end(ST_SHADE);
+                if (timed) tS = SDL_GetPerformanceCounter();
+                if (gov) {
+                    double k = 1000.0 / double(pf);
+                    if (gov->update(world, t_now, dt, (tI - tA) * k, (tB - tI) * k, (tS - tB) * k))
+                        std::cout << gov->last_change() << "\n";
+                }
+                perf.begin(ST_PRESENT);
+                SDL_RenderPresent(renderer);
+                perf.end(ST_PRESENT);
+                perf.frame_done();
+                if (timed) tC = SDL_GetPerformanceCounter();
+                if (metrics) {
+                    const double k = 1000.0 / double(pf);
+                    publish(dt, (tI - tA) * k, (tB - tI) * k, (tS - tB) * k, (tC - tS) * k, t_now, nullptr);
+                }
+
+                if (cfg.profile) {
+                    double k = 1000.0 / double(pf);
+                    double sim_ms   = (tB - tA) * k;
+                    double shade_ms = (tC - tB) * k;
+                    const std::string note = backend->note();
+                    const RegionSyncStats rs = region_probe->take();
+                    std::cout << "sim+ink(" << backend->name() << ")=" << sim_ms << " ms, shade+present("
+                              << backend->name() << ")=" << shade_ms << " ms, sync=" << rs.total_ms()
+                              << " ms (fork/join=" << rs.fork_join_ms << ", barreras=" << rs.barrier_ms
+                              << "; " << rs.regions << " regiones), " << upload_profile(pb)
+                              << (note.empty() ? "" : ", " + note) << "\n";
+                }
             }
 
+            if (!pipe) cull_acc.add(world.cull);
+
             // ---- FPS (cada ~1s) ----
             fps_accum += dt; fps_frames++;
             if (fps_accum >= 1.0) {
@@ -125,11 +404,31 @@ int main(int argc, char** argv) {
                 fps_smoothed = (fps_smoothed==0.0) ? fps_inst : (0.8*fps_smoothed + 0.2*fps_inst);
                 update_title(fps_smoothed);
                 std::cout << "FPS: " << (int)std::round(fps_smoothed) << "\n";
+                perf.report(size_t(cfg.width) * size_t(cfg.height));
+                if (world.cfg.cull_eps > 0.0f && cull_acc.frames > 0) {
+                    std::ostringstream cl;
+                    cl << "Culling: eps=" << world.cfg.cull_eps << std::fixed << std::setprecision(1)
+                       << " | trabajo px ahorrado=" << 100.0 * cull_acc.saved() << "% | invisibles/frame="
+                       << double(cull_acc.invisible) / cull_acc.frames << " | respawn=" << cull_acc.respawned;
+                    std::cout << cl.str() << "\n";
+                    cull_acc = CullStats{};
+                }
                 fps_accum = 0.0; fps_frames = 0;
             }
         }
 
-        SDL_DestroyTexture(pb.tex);
+        if (pipe) {
+            pipe->stop();
+            // El World quedó en el último frame que simuló el pipeline, no en el mostrado
+            t_last = pipe->last_t_now();
+        }
+        if (!cfg.checkpoint.empty()) {
+            save_checkpoint(cfg.checkpoint, world, t_last);
+            std::cout << "Checkpoint: " << cfg.checkpoint << " t=" << t_last << " s\n";
+        }
+        const std::string rec = engine.close_recording();
+        if (!rec.empty()) std::cout << rec << "\n";
+        destroy_pixel_buffer(pb);
         SDL_DestroyRenderer(renderer);
         SDL_DestroyWindow(window);
         SDL_Quit();
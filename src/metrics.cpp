@@ -0,0 +1,251 @@
+#include "metrics.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+#ifdef __linux__
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace {
+using clk = std::chrono::steady_clock;
+
+// Límites de los histogramas (s): de 1 ms a 250 ms, con 1/60 y 1/30 explícitos
+constexpr double BUCKET_LE[] = { 0.001, 0.002, 0.004, 0.008, 1.0 / 60.0, 1.0 / 30.0, 0.05, 0.1, 0.25, 1.0 };
+const char* const STAGE_NAMES[] = { "sim", "ink", "shade", "present" };
+
+void write_histogram_samples(std::ostringstream& os, const char* name, const char* labels,
+                             const uint64_t* count, int buckets, uint64_t n, double sum) {
+    uint64_t acc = 0;
+    for (int b = 0; b < buckets; ++b) {
+        acc += count[b];
+        os << name << "_bucket{" << labels << "le=\"" << BUCKET_LE[b] << "\"} " << acc << "\n";
+    }
+    os << name << "_bucket{" << labels << "le=\"+Inf\"} " << n << "\n";
+    const std::string l = labels;
+    const std::string braces = l.empty() ? "" : "{" + l.substr(0, l.size() - 1) + "}";
+    os << name << "_count" << braces << " " << n << "\n";
+    os << name << "_sum" << braces << " " << sum << "\n";
+}
+}
+
+void MetricsServer::Histogram::observe(double s) {
+    int b = 0;
+    while (b < BUCKETS && s > BUCKET_LE[b]) ++b;
+    count[b]++;
+    n++;
+    sum += s;
+}
+
+MetricsServer::MetricsServer(const std::string& path, const std::string& program, int width, int height)
+    : path_(path), program_(program), width_(width), height_(height)
+{
+    static_assert(sizeof(BUCKET_LE) / sizeof(BUCKET_LE[0]) == BUCKETS, "BUCKET_LE");
+#ifdef __linux__
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(addr.sun_path))
+        throw std::runtime_error("--metrics: ruta de socket vacía o demasiado larga (" + path + ")");
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+
+    // Un socket viejo (corrida anterior que no cerró) se reemplaza; otro archivo no
+    struct stat st{};
+    if (lstat(path.c_str(), &st) == 0) {
+        if (!S_ISSOCK(st.st_mode)) throw std::runtime_error("--metrics: " + path + " existe y no es un socket");
+        unlink(path.c_str());
+    }
+    listen_fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listen_fd_ < 0) throw std::runtime_error("--metrics: socket() falló");
+    if (bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(listen_fd_, 8) != 0) {
+        close(listen_fd_);
+        throw std::runtime_error("--metrics: no se pudo escuchar en " + path + " (" + std::strerror(errno) + ")");
+    }
+    if (lstat(path.c_str(), &st) == 0) { sock_dev_ = uint64_t(st.st_dev); sock_ino_ = uint64_t(st.st_ino); }
+#else
+    throw std::runtime_error("--metrics: requiere sockets Unix (Linux)");
+#endif
+    t_start_ = clk::now();
+    next_scene_ = t_start_;
+    th_ = std::thread([this] { run(); });
+}
+
+MetricsServer::~MetricsServer() {
+    stop_.store(true, std::memory_order_relaxed);
+    if (th_.joinable()) th_.join();
+#ifdef __linux__
+    if (listen_fd_ >= 0) {
+        close(listen_fd_);
+        // Otra instancia pudo haber reemplazado el socket en PATH: ese no se toca
+        struct stat st{};
+        if (lstat(path_.c_str(), &st) == 0 && uint64_t(st.st_dev) == sock_dev_ && uint64_t(st.st_ino) == sock_ino_)
+            unlink(path_.c_str());
+    }
+#endif
+}
+
+void MetricsServer::push(const FrameSample& s) {
+    const uint64_t h = head_.load(std::memory_order_relaxed);
+    if (h - tail_.load(std::memory_order_acquire) >= RING) {
+        dropped_.store(dropped_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return;
+    }
+    ring_[h & (RING - 1)] = s;
+    head_.store(h + 1, std::memory_order_release);
+}
+
+bool MetricsServer::want_scene() {
+    const clk::time_point now = clk::now();
+    if (now < next_scene_) return false;
+    next_scene_ = now + std::chrono::seconds(1);
+    return true;
+}
+
+std::string MetricsServer::describe() const {
+    return "Metrics: OpenMetrics en unix:" + path_ + " (curl --unix-socket " + path_ + " http://localhost/metrics)";
+}
+
+void MetricsServer::drain() {
+    const uint64_t t = tail_.load(std::memory_order_relaxed);
+    const uint64_t h = head_.load(std::memory_order_acquire);
+    for (uint64_t k = t; k < h; ++k) {
+        const FrameSample& s = ring_[k & (RING - 1)];
+        frame_.observe(s.frame_ms * 1e-3);
+        const float st[STAGES] = { s.sim_ms, s.ink_ms, s.shade_ms, s.present_ms };
+        for (int i = 0; i < STAGES; ++i)
+            if (st[i] >= 0.0f) stage_[i].observe(st[i] * 1e-3);
+        recent_[frames_ % WINDOW] = s.frame_ms;
+        ++frames_;
+        if (s.px_drops >= 0.0) px_drops_ = s.px_drops;
+        if (s.ink_area >= 0.0f) ink_area_ = s.ink_area;
+        last_ = s;
+    }
+    tail_.store(h, std::memory_order_release);
+}
+
+void MetricsServer::run() {
+#ifdef __linux__
+    while (!stop_.load(std::memory_order_relaxed)) {
+        pollfd p{ listen_fd_, POLLIN, 0 };
+        const int r = poll(&p, 1, 50);
+        drain();
+        if (r <= 0 || !(p.revents & POLLIN)) continue;
+        const int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) continue;
+        serve(fd);
+        close(fd);
+    }
+#endif
+}
+
+void MetricsServer::serve(int fd) const {
+#ifdef __linux__
+    // Un cliente HTTP manda la petición enseguida; uno crudo (socat, nc -U) no manda nada
+    char req[4096];
+    ssize_t n = 0;
+    pollfd p{ fd, POLLIN, 0 };
+    if (poll(&p, 1, 50) > 0) n = recv(fd, req, sizeof(req), 0);
+    const bool http = n >= 4 && std::memcmp(req, "GET ", 4) == 0;
+    const std::string body = exposition();
+    std::string out;
+    if (http) {
+        std::ostringstream hdr;
+        hdr << "HTTP/1.0 200 OK\r\n"
+            << "Content-Type: application/openmetrics-text; version=1.0.0; charset=utf-8\r\n"
+            << "Content-Length: " << body.size() << "\r\n\r\n";
+        out = hdr.str();
+    }
+    out += body;
+    size_t off = 0;
+    while (off < out.size()) {
+        const ssize_t w = send(fd, out.data() + off, out.size() - off, MSG_NOSIGNAL);
+        if (w <= 0) break;
+        off += size_t(w);
+    }
+#else
+    (void)fd;
+#endif
+}
+
+std::string MetricsServer::exposition() const {
+    std::ostringstream os;
+    os << std::setprecision(9);
+    const double uptime = std::chrono::duration<double>(clk::now() - t_start_).count();
+
+    os << "# TYPE ripple_build info\n"
+       << "# HELP ripple_build Programa y resolución del lienzo.\n"
+       << "ripple_build_info{program=\"" << program_ << "\",width=\"" << width_
+       << "\",height=\"" << height_ << "\"} 1\n";
+    os << "# TYPE ripple_uptime_seconds gauge\n# UNIT ripple_uptime_seconds seconds\n"
+       << "ripple_uptime_seconds " << uptime << "\n";
+    os << "# TYPE ripple_frames counter\n# HELP ripple_frames Frames registrados (sin las muestras descartadas).\n"
+       << "ripple_frames_total " << frames_ << "\n";
+
+    os << "# TYPE ripple_frame_seconds histogram\n# UNIT ripple_frame_seconds seconds\n"
+       << "# HELP ripple_frame_seconds Tiempo entre frames presentados.\n";
+    write_histogram_samples(os, "ripple_frame_seconds", "", frame_.count, BUCKETS, frame_.n, frame_.sum);
+
+    // Percentiles sobre los últimos WINDOW frames
+    const size_t nw = size_t(std::min<uint64_t>(frames_, WINDOW));
+    std::vector<float> w(recent_.begin(), recent_.begin() + nw);
+    os << "# TYPE ripple_frame_recent_seconds summary\n# UNIT ripple_frame_recent_seconds seconds\n"
+       << "# HELP ripple_frame_recent_seconds Percentiles del tiempo de frame en los últimos " << WINDOW << " frames.\n";
+    for (double q : { 0.5, 0.9, 0.99 }) {
+        double v = 0.0;
+        if (nw > 0) {
+            const size_t k = std::min(nw - 1, size_t(q * double(nw)));
+            std::nth_element(w.begin(), w.begin() + k, w.end());
+            v = w[k] * 1e-3;
+        }
+        os << "ripple_frame_recent_seconds{quantile=\"" << q << "\"} " << v << "\n";
+    }
+    os << "ripple_frame_recent_seconds_count " << frame_.n << "\n"
+       << "ripple_frame_recent_seconds_sum " << frame_.sum << "\n";
+
+    os << "# TYPE ripple_stage_seconds histogram\n# UNIT ripple_stage_seconds seconds\n"
+       << "# HELP ripple_stage_seconds Tiempo por etapa del frame (solo las que mide el camino activo).\n";
+    for (int i = 0; i < STAGES; ++i) {
+        const std::string labels = std::string("stage=\"") + STAGE_NAMES[i] + "\",";
+        write_histogram_samples(os, "ripple_stage_seconds", labels.c_str(),
+                                stage_[i].count, BUCKETS, stage_[i].n, stage_[i].sum);
+    }
+
+    os << "# TYPE ripple_drops_active gauge\n# HELP ripple_drops_active Gotas activas.\n"
+       << "ripple_drops_active " << last_.drops << "\n";
+    if (last_.culled >= 0)
+        os << "# TYPE ripple_drops_culled gauge\n# HELP ripple_drops_culled Gotas bajo --cull-eps en todo el último frame.\n"
+           << "ripple_drops_culled " << last_.culled << "\n";
+    os << "# TYPE ripple_pixels_evaluated gauge\n# HELP ripple_pixels_evaluated Píxeles evaluados por frame y kernel (gotas: estimación por área de banda).\n";
+    if (px_drops_ >= 0.0) os << "ripple_pixels_evaluated{kernel=\"drops\"} " << px_drops_ << "\n";
+    os << "ripple_pixels_evaluated{kernel=\"shade\"} " << double(width_) * double(height_) << "\n";
+    if (ink_area_ >= 0.0f)
+        os << "# TYPE ripple_ink_active_ratio gauge\n# HELP ripple_ink_active_ratio Fracción del lienzo con tinta visible.\n"
+           << "ripple_ink_active_ratio " << ink_area_ << "\n";
+    os << "# TYPE ripple_threads gauge\n# HELP ripple_threads Hilos de cómputo.\n"
+       << "ripple_threads " << last_.threads << "\n";
+    os << "# TYPE ripple_metrics_dropped_samples counter\n"
+       << "# HELP ripple_metrics_dropped_samples Muestras descartadas con el anillo lleno.\n"
+       << "ripple_metrics_dropped_samples_total " << dropped_.load(std::memory_order_relaxed) << "\n";
+    os << "# EOF\n";
+    return os.str();
+}
+
+float ink_active_fraction(const Plane& CR, const Plane& CG, const Plane& CB, int W, int H,
+                          float ink_strength, int stride, float thr) {
+    size_t hit = 0, total = 0;
+    for (int y = stride / 2; y < H; y += stride) {
+        const size_t row = size_t(y) * size_t(plane_pitch(W));
+        for (int x = stride / 2; x < W; x += stride) {
+            const size_t i = row + size_t(x);
+            hit += ink_strength * (CR[i] + CG[i] + CB[i]) > thr;
+            ++total;
+        }
+    }
+    return total > 0 ? float(double(hit) / double(total)) : 0.0f;
+}
@@ -9,18 +9,24 @@ static inline float hash2(int x, int y){
     return float((h ^ (h >> 16u)) & 0x00FFFFFFu) / float(0x01000000);
 }
 
+namespace seq {
+
 void accumulate_heightfield(
-    std::vector<float>& H,
-    std::vector<float>& CR,
-    std::vector<float>& CG,
-    std::vector<float>& CB,
+    Plane& H,
+    Plane& CR,
+    Plane& CG,
+    Plane& CB,
     int W, int Hh,
     const std::vector<Drop>& drops,
     float t_now,
     bool  ink_enabled,
-    float ink_gain)
+    float ink_gain,
+    bool  /*fast_math: la referencia secuencial siempre es exacta*/,
+    float /*cull_eps: ... y sin culling*/,
+    int   canvas_y0)
 {
     std::fill(H.begin(), H.end(), 0.0f);
+    const size_t P = size_t(plane_pitch(W));
 
     for (const auto& d : drops) {
         float tau = t_now - d.t0;
@@ -41,11 +47,12 @@ void accumulate_heightfield(
 
         int xmin = std::max(0, int(std::floor(d.x - rmax - 2)));
         int xmax = std::min(W-1, int(std::ceil (d.x + rmax + 2)));
-        int ymin = std::max(0, int(std::floor(d.y - rmax - 2)));
-        int ymax = std::min(Hh-1, int(std::ceil (d.y + rmax + 2)));
+        int ymin = std::max(0, int(std::floor(d.y - rmax - 2)) - canvas_y0);
+        int ymax = std::min(Hh-1, int(std::ceil (d.y + rmax + 2)) - canvas_y0);
 
         for (int y=ymin; y<=ymax; ++y) {
-            float fy = float(y) + 0.5f;
+            const int yc = y + canvas_y0;   // fila del lienzo (muro MPI)
+            float fy = float(yc) + 0.5f;
             float dy = fy - d.y;
             for (int x=xmin; x<=xmax; ++x) {
                 float fx = float(x) + 0.5f;
@@ -56,7 +63,7 @@ void accumulate_heightfield(
                 float dist = std::sqrt(dist2);
 
                 // micro-jitter al radio
-                dist += (hash2(x,y) - 0.5f) * 0.35f;
+                dist += (hash2(x,yc) - 0.5f) * 0.35f;
 
                 // ---- Derivada de Gauss como perfil principal ----
                 float s     = (dist - ring) / std::max(1e-3f, d.sigma);
@@ -80,8 +87,7 @@ void accumulate_heightfield(
                 // ---- Splash (breve) ----
                 float splash = 0.0f;
                 {
-                    const float tauSplashMax = 0.25f;
-                    if (tau <= tauSplashMax) {
+                    if (tau <= TAU_SPLASH_MAX) {
                         float rho = d.splash_r0;
                         float r2  = (dist2)/(2.0f*rho*rho);
                         float ang = std::atan2(dy, dx);
@@ -90,7 +96,7 @@ void accumulate_heightfield(
                     }
                 }
 
-                size_t idx = size_t(y)*size_t(W) + size_t(x);
+                size_t idx = size_t(y)*P + size_t(x);
                 H[idx] += (main + cap + splash);
 
                 // ---- Tinta: solo la envolvente (sin oscilación) ----
@@ -107,3 +113,5 @@ void accumulate_heightfield(
         }
     }
 }
+
+} // namespace seq
@@ -0,0 +1,195 @@
+#include "numa.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <omp.h>
+#ifdef __linux__
+#include <dirent.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+int NumaTopology::num_cpus() const {
+    int n = 0;
+    for (auto& c : node_cpus) n += int(c.size());
+    return n;
+}
+
+int NumaTopology::node_of(int cpu) const {
+    for (size_t n = 0; n < node_cpus.size(); ++n)
+        if (std::find(node_cpus[n].begin(), node_cpus[n].end(), cpu) != node_cpus[n].end()) return int(n);
+    return -1;
+}
+
+// "0-3,8,10-11" -> {0,1,2,3,8,10,11}
+static std::vector<int> parse_cpulist(const std::string& s) {
+    std::vector<int> out;
+    std::stringstream ss(s);
+    std::string tok;
+    while (std::getline(ss, tok, ',')) {
+        if (tok.empty() || tok == "\n") continue;
+        size_t dash = tok.find('-');
+        try {
+            int a = std::stoi(tok.substr(0, dash));
+            int b = (dash == std::string::npos) ? a : std::stoi(tok.substr(dash + 1));
+            for (int c = a; c <= b; ++c) out.push_back(c);
+        } catch (...) {}
+    }
+    return out;
+}
+
+NumaTopology read_numa_topology() {
+    NumaTopology t;
+#ifdef __linux__
+    if (DIR* dir = opendir("/sys/devices/system/node")) {
+        std::vector<int> ids;
+        while (dirent* e = readdir(dir)) {
+            std::string n = e->d_name;
+            if (n.size() > 4 && n.compare(0, 4, "node") == 0 &&
+                std::all_of(n.begin() + 4, n.end(), ::isdigit))
+                ids.push_back(std::stoi(n.substr(4)));
+        }
+        closedir(dir);
+        std::sort(ids.begin(), ids.end());
+        for (int id : ids) {
+            std::ifstream f("/sys/devices/system/node/node" + std::to_string(id) + "/cpulist");
+            std::string line;
+            if (f && std::getline(f, line)) {
+                auto cpus = parse_cpulist(line);
+                if (!cpus.empty()) t.node_cpus.push_back(cpus);
+            }
+        }
+    }
+    if (t.node_cpus.empty()) {
+        long n = sysconf(_SC_NPROCESSORS_ONLN);
+        std::vector<int> all;
+        for (int c = 0; c < std::max(1L, n); ++c) all.push_back(c);
+        t.node_cpus.push_back(all);
+    }
+#else
+    t.node_cpus.push_back({0});
+#endif
+    return t;
+}
+
+std::string describe_topology(const NumaTopology& topo) {
+    std::ostringstream os;
+    os << "NUMA: " << topo.node_cpus.size() << " nodo(s), " << topo.num_cpus() << " CPUs";
+    for (size_t n = 0; n < topo.node_cpus.size(); ++n) {
+        const auto& c = topo.node_cpus[n];
+        os << " | nodo" << n << ": " << c.size() << " CPUs [" << c.front() << ".." << c.back() << "]";
+    }
+    os << " | hilos OMP=" << omp_get_max_threads();
+    return os.str();
+}
+
+std::string pin_omp_threads(const NumaTopology& topo, int mode) {
+#ifdef __linux__
+    // Orden de CPUs a asignar según el modo
+    std::vector<int> order;
+    if (mode == 2) {
+        size_t maxc = 0;
+        for (auto& c : topo.node_cpus) maxc = std::max(maxc, c.size());
+        for (size_t i = 0; i < maxc; ++i)
+            for (auto& c : topo.node_cpus) if (i < c.size()) order.push_back(c[i]);
+    } else {
+        for (auto& c : topo.node_cpus) order.insert(order.end(), c.begin(), c.end());
+    }
+    if (order.empty()) return "pin: sin CPUs";
+
+    const int T = omp_get_max_threads();
+    std::vector<int> cpu_of(size_t(T), -1);
+    #pragma omp parallel
+    {
+        int t = omp_get_thread_num();
+        int cpu = order[size_t(t) % order.size()];
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        if (sched_setaffinity(0, sizeof(set), &set) == 0) cpu_of[size_t(t)] = cpu;
+    }
+
+    std::ostringstream os;
+    os << "pin(" << (mode == 2 ? "spread" : "compact") << "):";
+    for (int t = 0; t < T; ++t) {
+        os << " " << t << "->";
+        if (cpu_of[size_t(t)] < 0) os << "x";
+        else os << cpu_of[size_t(t)] << "(n" << topo.node_of(cpu_of[size_t(t)]) << ")";
+    }
+    return os.str();
+#else
+    (void)topo; (void)mode;
+    return "pin: solo soportado en Linux";
+#endif
+}
+
+void first_touch_rows(Plane& plane, int W, int H) {
+    if (plane.empty() || FrameArena::global().owns(plane.data())) return;
+#ifdef __linux__
+    const uintptr_t page = uintptr_t(sysconf(_SC_PAGESIZE));
+    uintptr_t b = reinterpret_cast<uintptr_t>(plane.data());
+    uintptr_t e = b + plane.size() * sizeof(float);
+    b = (b + page - 1) & ~(page - 1);
+    e &= ~(page - 1);
+    // Páginas anónimas: tras DONTNEED se leen como ceros y el próximo toque las ubica
+    if (e > b) madvise(reinterpret_cast<void*>(b), e - b, MADV_DONTNEED);
+#endif
+    float* p = plane.data();
+    const size_t P = size_t(plane_pitch(W));
+    #pragma omp parallel for schedule(static)
+    for (int y = 0; y < H; ++y)
+        std::fill_n(p + size_t(y)*P, P, 0.0f);
+}
+
+std::string describe_placement(const char* name, const Plane& plane, int W, int H,
+                               const NumaTopology& topo) {
+    std::ostringstream os;
+    os << "Ubicación " << name << ": ";
+#ifdef __linux__
+    if (plane.empty()) return os.str() + "plano vacío";
+    const int T = omp_get_max_threads();
+    std::vector<int> lo(size_t(T), -1), hi(size_t(T), -1), cpu(size_t(T), -1);
+    // Mismo reparto que los kernels: el bloque de cada hilo sale del propio for
+    #pragma omp parallel
+    {
+        const int t = omp_get_thread_num();
+        #pragma omp for schedule(static)
+        for (int y = 0; y < H; ++y) {
+            if (lo[size_t(t)] < 0) lo[size_t(t)] = y;
+            hi[size_t(t)] = y;
+        }
+        cpu[size_t(t)] = sched_getcpu();
+    }
+    std::vector<void*> pages;
+    std::vector<int> row_of;
+    for (int t = 0; t < T; ++t) {
+        if (lo[size_t(t)] < 0) continue;
+        const int y = (lo[size_t(t)] + hi[size_t(t)]) / 2;
+        pages.push_back(const_cast<float*>(plane.data() + size_t(y) * size_t(plane_pitch(W)) + size_t(W / 2)));
+        row_of.push_back(t);
+    }
+    std::vector<int> status(pages.size(), -1);
+    // nodes = nullptr: solo consulta, no mueve nada
+    if (syscall(SYS_move_pages, 0, pages.size(), pages.data(), nullptr, status.data(), 0) != 0)
+        return os.str() + "move_pages no disponible (kernel sin NUMA o sin permiso)";
+    int match = 0;
+    std::ostringstream rows;
+    for (size_t i = 0; i < pages.size(); ++i) {
+        const int t = row_of[i];
+        const int want = topo.node_of(cpu[size_t(t)]);
+        if (status[i] >= 0 && status[i] == want) match++;
+        rows << " | t" << t << " y=" << (lo[size_t(t)] + hi[size_t(t)]) / 2 << " ";
+        if (status[i] >= 0) rows << "n" << status[i];
+        else rows << "err" << -status[i];
+        rows << "/n" << want;
+    }
+    os << match << "/" << pages.size() << " filas en el nodo de su hilo" << rows.str();
+#else
+    (void)plane; (void)W; (void)H; (void)topo;
+    os << "solo soportado en Linux";
+#endif
+    return os.str();
+}
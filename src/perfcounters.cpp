@@ -0,0 +1,191 @@
+#include "perfcounters.hpp"
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+static const char* kEventNames[PC_COUNT] = {"cycles", "instr", "LLC-miss", "br-miss"};
+
+PerfCounters::PerfCounters(std::vector<std::string> stage_names)
+: names_(std::move(stage_names)) {}
+
+PerfCounters::~PerfCounters() {
+#ifdef __linux__
+    for (auto& g : groups_)
+        for (int e = 0; e < PC_COUNT; ++e)
+            if (g.fd[e] >= 0) close(g.fd[e]);
+#endif
+}
+
+#ifdef __linux__
+static int perf_open(uint32_t type, uint64_t config, int group_fd) {
+    perf_event_attr pa;
+    std::memset(&pa, 0, sizeof(pa));
+    pa.size = sizeof(pa);
+    pa.type = type;
+    pa.config = config;
+    pa.read_format = PERF_FORMAT_GROUP;
+    pa.exclude_kernel = 1;   // permitido con perf_event_paranoid <= 2
+    pa.exclude_hv = 1;
+    // pid=0, cpu=-1: cuenta el hilo que llama, en cualquier CPU
+    return int(syscall(SYS_perf_event_open, &pa, 0, -1, group_fd, 0));
+}
+#endif
+
+bool PerfCounters::open(int threads) {
+#ifdef __linux__
+    if (threads < 1) threads = 1;
+    groups_.assign(size_t(threads), Group{});
+    std::vector<int> err(size_t(threads), 0);
+
+    auto open_here = [&](int t) {
+        static const uint32_t type[PC_COUNT] = {
+            PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE };
+        static const uint64_t cfg[PC_COUNT] = {
+            PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+            PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES };
+        Group& g = groups_[size_t(t)];
+        int leader = -1;
+        for (int e = 0; e < PC_COUNT; ++e) {
+            int fd = perf_open(type[e], cfg[e], leader);
+            if (fd < 0) { if (!err[size_t(t)]) err[size_t(t)] = errno; continue; }
+            if (leader < 0) leader = fd;
+            g.fd[e] = fd;
+            g.slot[e] = g.n++;
+        }
+    };
+
+#ifdef _OPENMP
+    if (threads > 1) {
+        #pragma omp parallel num_threads(threads)
+        {
+            int t = omp_get_thread_num();
+            if (t < threads) open_here(t);
+        }
+    } else
+#endif
+    {
+        groups_.resize(1);
+        open_here(0);
+    }
+
+    int opened = 0;
+    for (auto& g : groups_) if (g.n > 0) opened++;
+    if (opened == 0) {
+        int e = err.empty() ? 0 : err[0];
+        status_ = std::string("perfcounters: perf_event_open no disponible (")
+                + (e ? std::strerror(e) : "desconocido") + "), se continúa sin contadores";
+        groups_.clear();
+        return enabled_ = false;
+    }
+
+    std::ostringstream st;
+    st << "perfcounters: " << opened << "/" << groups_.size() << " hilos";
+    for (int e = 0; e < PC_COUNT; ++e)
+        if (groups_[0].fd[e] < 0) st << ", sin " << kEventNames[e];
+    status_ = st.str();
+
+    size_t n = names_.size() * groups_.size();
+    start_.assign(n, PerfSample{});
+    accum_.assign(n, PerfSample{});
+    return enabled_ = true;
+#else
+    (void)threads;
+    status_ = "perfcounters: perf_event_open solo existe en Linux, se continúa sin contadores";
+    return enabled_ = false;
+#endif
+}
+
+bool PerfCounters::read_group(const Group& g, PerfSample& out) const {
+#ifdef __linux__
+    int leader = -1;
+    for (int e = 0; e < PC_COUNT && leader < 0; ++e) leader = g.fd[e];
+    if (leader < 0) return false;
+    uint64_t buf[1 + PC_COUNT] = {};
+    if (::read(leader, buf, sizeof(buf)) < ssize_t(sizeof(uint64_t))) return false;
+    for (int e = 0; e < PC_COUNT; ++e) {
+        out.ok[e] = (g.slot[e] >= 0 && uint64_t(g.slot[e]) < buf[0]);
+        out.v[e]  = out.ok[e] ? buf[1 + g.slot[e]] : 0;
+    }
+    return true;
+#else
+    (void)g; (void)out;
+    return false;
+#endif
+}
+
+void PerfCounters::begin(int stage) {
+    if (!enabled_) return;
+    const size_t T = groups_.size();
+    for (size_t t = 0; t < T; ++t)
+        read_group(groups_[t], start_[size_t(stage)*T + t]);
+}
+
+void PerfCounters::end(int stage) {
+    if (!enabled_) return;
+    const size_t T = groups_.size();
+    for (size_t t = 0; t < T; ++t) {
+        PerfSample now;
+        if (!read_group(groups_[t], now)) continue;
+        const PerfSample& s0 = start_[size_t(stage)*T + t];
+        PerfSample& acc = accum_[size_t(stage)*T + t];
+        for (int e = 0; e < PC_COUNT; ++e) {
+            acc.ok[e] = now.ok[e];
+            if (now.ok[e] && now.v[e] >= s0.v[e]) acc.v[e] += now.v[e] - s0.v[e];
+        }
+    }
+}
+
+void PerfCounters::report(size_t pixels_per_frame) {
+    if (!enabled_ || frames_ == 0) return;
+    const size_t T = groups_.size();
+    const double fr = double(frames_);
+
+    for (size_t s = 0; s < names_.size(); ++s) {
+        PerfSample tot;
+        for (size_t t = 0; t < T; ++t)
+            for (int e = 0; e < PC_COUNT; ++e) {
+                const PerfSample& a = accum_[s*T + t];
+                tot.v[e] += a.v[e];
+                tot.ok[e] = tot.ok[e] || a.ok[e];
+            }
+
+        std::ostringstream os;
+        os << std::fixed << std::setprecision(2);
+        os << "perf[" << names_[s] << "]";
+        if (tot.ok[PC_CYCLES]) os << " cycles=" << double(tot.v[PC_CYCLES])/fr/1e6 << "M";
+        if (tot.ok[PC_INSTR])  os << " instr="  << double(tot.v[PC_INSTR])/fr/1e6 << "M";
+        if (tot.ok[PC_CYCLES] && tot.ok[PC_INSTR] && tot.v[PC_CYCLES] > 0)
+            os << " IPC=" << double(tot.v[PC_INSTR]) / double(tot.v[PC_CYCLES]);
+        if (tot.ok[PC_LLC_MISS]) {
+            os << " LLC-miss=" << double(tot.v[PC_LLC_MISS])/fr/1e3 << "k";
+            // cada fallo de LLC ~ una línea de 64 B traída de DRAM
+            if (pixels_per_frame > 0)
+                os << " B/px=" << 64.0 * double(tot.v[PC_LLC_MISS]) / fr / double(pixels_per_frame);
+        }
+        if (tot.ok[PC_BR_MISS]) os << " br-miss=" << double(tot.v[PC_BR_MISS])/fr/1e3 << "k";
+
+        if (T > 1) {
+            os << " IPC/hilo=[";
+            for (size_t t = 0; t < T; ++t) {
+                const PerfSample& a = accum_[s*T + t];
+                double ipc = (a.v[PC_CYCLES] > 0) ? double(a.v[PC_INSTR]) / double(a.v[PC_CYCLES]) : 0.0;
+                os << (t ? " " : "") << ipc;
+            }
+            os << "]";
+        }
+        std::cout << os.str() << "\n";
+    }
+
+    std::fill(accum_.begin(), accum_.end(), PerfSample{});
+    frames_ = 0;
+}
@@ -0,0 +1,132 @@
+#include "pipeline.hpp"
+#include <algorithm>
+#include "model.hpp"
+#include "ink.hpp"
+#include "numa.hpp"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+FramePipeline::FramePipeline(World& world, int depth, int sim_threads)
+: world_(world), depth_(std::max(1, depth)), sim_threads_(std::max(1, sim_threads)) {
+    // depth frames en vuelo (simulándose o en cola) + 1 en pantalla
+    slots_.resize(size_t(depth_) + 1);
+    size_t SZ = plane_size(world_.cfg.width, world_.cfg.height);
+    for (auto& s : slots_) {
+        if (world_.cfg.storage == 1) s.packed.resize(SZ);
+        else {
+            s.resize(SZ);
+            for (auto* p : {&s.H, &s.CR, &s.CG, &s.CB}) first_touch_rows(*p, world_.cfg.width, world_.cfg.height);
+        }
+        free_.push_back(&s);
+    }
+}
+
+FramePipeline::~FramePipeline() { stop(); }
+
+void FramePipeline::start() {
+    stop_ = false;
+    th_ = std::thread(&FramePipeline::sim_loop, this);
+}
+
+void FramePipeline::stop() {
+    {
+        std::lock_guard<std::mutex> lk(m_);
+        stop_ = true;
+    }
+    cv_free_.notify_all();
+    cv_ready_.notify_all();
+    if (th_.joinable()) th_.join();
+}
+
+FrameSlot* FramePipeline::acquire() {
+    std::unique_lock<std::mutex> lk(m_);
+    cv_ready_.wait(lk, [&]{ return stop_ || !ready_.empty(); });
+    if (ready_.empty()) return nullptr;
+    FrameSlot* s = ready_.front(); ready_.pop_front();
+    return s;
+}
+
+void FramePipeline::release(FrameSlot* s) {
+    {
+        std::lock_guard<std::mutex> lk(m_);
+        free_.push_back(s);
+    }
+    cv_free_.notify_one();
+}
+
+int FramePipeline::queued() {
+    std::lock_guard<std::mutex> lk(m_);
+    return int(ready_.size());
+}
+
+float FramePipeline::last_t_now() {
+    std::lock_guard<std::mutex> lk(m_);
+    return t_sim_;
+}
+
+void FramePipeline::sim_loop() {
+#ifdef _OPENMP
+    // ICV por hilo: el equipo de este hilo no pisa al del render
+    omp_set_num_threads(sim_threads_);
+#endif
+    using clock = std::chrono::steady_clock;
+    const AppConfig& cfg = world_.cfg;
+    auto t_prev = clock::now();
+    double accTime = 0.0;
+    uint64_t seq = 0;
+
+    for (;;) {
+        FrameSlot* s = nullptr;
+        {
+            std::unique_lock<std::mutex> lk(m_);
+            cv_free_.wait(lk, [&]{ return stop_ || !free_.empty(); });
+            if (stop_) return;
+            s = free_.front(); free_.pop_front();
+        }
+
+        // El reloj avanza también mientras se espera un slot libre
+        auto t1 = clock::now();
+        double dt = std::chrono::duration<double>(t1 - t_prev).count();
+        t_prev = t1;
+        accTime += dt;
+        float t_now = float(accTime);
+
+        // Compacto: se simula en float sobre el World y se empaqueta en el slot
+        const bool compact = cfg.storage == 1;
+        world_.maybe_respawn(t_now);
+        accumulate_heightfield(
+            compact ? world_.H : s->H, world_.CR, world_.CG, world_.CB,
+            cfg.width, cfg.height, world_.drops, t_now,
+            cfg.ink_enabled, cfg.ink_gain, cfg.math == 1, cfg.cull_eps
+        );
+        // La tinta es estado persistente del World; el slot guarda su foto. En compacto
+        // la última pasada de la tinta escribe el frame empaquetado (sin releer los floats).
+        if (compact) {
+            ink_postprocess_packed(world_.CR, world_.CG, world_.CB, world_.H,
+                                   cfg.width, cfg.height,
+                                   float(dt), cfg.ink_decay, cfg.ink_blur_mix, s->packed);
+        } else {
+            ink_postprocess(world_.CR, world_.CG, world_.CB,
+                            cfg.width, cfg.height,
+                            float(dt), cfg.ink_decay, cfg.ink_blur_mix);
+            std::copy(world_.CR.begin(), world_.CR.end(), s->CR.begin());
+            std::copy(world_.CG.begin(), world_.CG.end(), s->CG.begin());
+            std::copy(world_.CB.begin(), world_.CB.end(), s->CB.begin());
+        }
+
+        s->t_now  = t_now;
+        s->dt     = float(dt);
+        s->seq    = seq++;
+        s->t_start= t1;
+        s->sim_ms = std::chrono::duration<double, std::milli>(clock::now() - t1).count();
+        s->cull   = world_.cull;
+
+        {
+            std::lock_guard<std::mutex> lk(m_);
+            ready_.push_back(s);
+            t_sim_ = t_now;
+        }
+        cv_ready_.notify_one();
+    }
+}
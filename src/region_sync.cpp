@@ -0,0 +1,41 @@
+#include "region_sync.hpp"
+#include <algorithm>
+
+static thread_local RegionProbe* current_probe = nullptr;
+
+RegionProbe::RegionProbe() : prev_(current_probe) { current_probe = this; }
+RegionProbe::~RegionProbe() { current_probe = prev_; }
+
+RegionSyncStats RegionProbe::take() {
+    RegionSyncStats s = acc_;
+    acc_ = RegionSyncStats{};
+    return s;
+}
+
+RegionTimer::RegionTimer() : probe_(current_probe) {
+    if (!probe_) return;
+    const size_t T = size_t(omp_get_max_threads());
+    start_.assign(T, -1.0);
+    end_.assign(T, -1.0);
+    t_open_ = omp_get_wtime();
+}
+
+void RegionTimer::close() {
+    if (!probe_) return;
+    const double t_close = omp_get_wtime();
+    double last = t_open_, fork = 0.0;
+    int n = 0;
+    for (size_t t = 0; t < start_.size(); ++t) {
+        if (start_[t] < 0.0) continue;   // hilo que no entró (equipo más chico)
+        fork += start_[t] - t_open_;
+        last = std::max(last, end_[t]);
+        n++;
+    }
+    if (n == 0) return;
+    double wait = 0.0;
+    for (size_t t = 0; t < start_.size(); ++t)
+        if (start_[t] >= 0.0) wait += last - end_[t];
+    probe_->acc_.fork_join_ms += 1000.0 * (fork / n + (t_close - last));
+    probe_->acc_.barrier_ms   += 1000.0 * wait / n;
+    probe_->acc_.regions++;
+}
@@ -1,2 +1,156 @@
 #include "render_sdl.hpp"
-// Helpers de SDL centralizados en shading.cpp (create_pixel_buffer + present).
+#include <condition_variable>
+#include <cstring>
+#include <iomanip>
+#include <mutex>
+#include <new>
+#include <sstream>
+#include <thread>
+// Helpers de SDL comunes a todos los backends (el sombreado vive en shading*.cpp)
+
+// Hilo de subida (--upload thread): copia el staging a la textura ya bloqueada.
+// Las llamadas al renderer (lock/unlock/copy/present) siguen en el hilo principal:
+// SDL_Renderer no es thread-safe; aquí solo se mueven bytes.
+class UploadThread {
+public:
+    UploadThread() : th_([this] { run(); }) {}
+    ~UploadThread() {
+        {
+            std::lock_guard<std::mutex> lk(m_);
+            quit_ = true;
+        }
+        cv_.notify_all();
+        th_.join();
+    }
+
+    void post(const uint32_t* src, int src_pitch, void* dst, int dst_pitch, int row_bytes, int rows) {
+        {
+            std::lock_guard<std::mutex> lk(m_);
+            src_ = src; src_pitch_ = src_pitch;
+            dst_ = static_cast<unsigned char*>(dst); dst_pitch_ = dst_pitch;
+            row_bytes_ = row_bytes; rows_ = rows;
+            busy_ = true;
+        }
+        cv_.notify_all();
+    }
+
+    void wait() {
+        std::unique_lock<std::mutex> lk(m_);
+        cv_.wait(lk, [this] { return !busy_; });
+    }
+
+private:
+    void run() {
+        std::unique_lock<std::mutex> lk(m_);
+        for (;;) {
+            cv_.wait(lk, [this] { return busy_ || quit_; });
+            if (busy_) {
+                const unsigned char* s = reinterpret_cast<const unsigned char*>(src_);
+                for (int y = 0; y < rows_; ++y)
+                    std::memcpy(dst_ + size_t(y) * dst_pitch_, s + size_t(y) * src_pitch_, size_t(row_bytes_));
+                busy_ = false;
+                cv_.notify_all();
+            } else if (quit_) {
+                return;
+            }
+        }
+    }
+
+    std::mutex m_;
+    std::condition_variable cv_;
+    const uint32_t* src_ = nullptr;
+    unsigned char* dst_ = nullptr;
+    int src_pitch_ = 0, dst_pitch_ = 0, row_bytes_ = 0, rows_ = 0;
+    bool busy_ = false, quit_ = false;
+    std::thread th_;   // último: arranca con el resto ya construido
+};
+
+bool create_pixel_buffer(SDL_Renderer* r, int w, int h, PixelBuffer& out, int textures, int upload) {
+    out.w = w; out.h = h;
+    out.textures = textures < 1 ? 1 : (textures > 3 ? 3 : textures);
+    out.upload = upload;
+    for (int k = 0; k < out.textures; ++k) {
+        out.ring[k] = SDL_CreateTexture(r, out.format, SDL_TEXTUREACCESS_STREAMING, w, h);
+        if (!out.ring[k]) { destroy_pixel_buffer(out); return false; }
+    }
+    if (upload != UPLOAD_LOCK) {
+        out.staging_pitch = (w * int(sizeof(uint32_t)) + 63) & ~63;
+        const size_t bytes = size_t(out.staging_pitch) * size_t(h);
+        for (int k = 0; k < (upload == UPLOAD_THREAD ? 2 : 1); ++k)
+            out.staging[k] = static_cast<uint32_t*>(::operator new(bytes, std::align_val_t(64)));
+    }
+    if (upload == UPLOAD_THREAD) out.uploader = new UploadThread();
+    return true;
+}
+
+void destroy_pixel_buffer(PixelBuffer& pb) {
+    if (pb.uploader) {
+        pb.uploader->wait();
+        delete pb.uploader;
+        pb.uploader = nullptr;
+    }
+    if (pb.inflight) { SDL_UnlockTexture(pb.inflight); pb.inflight = nullptr; }
+    for (SDL_Texture*& t : pb.ring) {
+        if (t) SDL_DestroyTexture(t);
+        t = nullptr;
+    }
+    for (uint32_t*& s : pb.staging) {
+        if (s) ::operator delete(s, std::align_val_t(64));
+        s = nullptr;
+    }
+    pb.tex = nullptr;
+}
+
+bool lock_next_texture(PixelBuffer& pb, SDL_Texture*& t, void** pixels, int* pitch) {
+    t = pb.ring[pb.next];
+    pb.next = (pb.next + 1) % pb.textures;
+    const Uint64 t0 = SDL_GetPerformanceCounter();
+    const bool ok = SDL_LockTexture(t, nullptr, pixels, pitch) == 0;
+    pb.lock_ticks += SDL_GetPerformanceCounter() - t0;
+    return ok;
+}
+
+void present_staging(SDL_Renderer* renderer, PixelBuffer& pb) {
+    const uint32_t* src = pb.staging[pb.staging_cur];
+    if (pb.upload == UPLOAD_UPDATE) {
+        SDL_Texture* t = pb.ring[pb.next];
+        pb.next = (pb.next + 1) % pb.textures;
+        const Uint64 t0 = SDL_GetPerformanceCounter();
+        const bool ok = SDL_UpdateTexture(t, nullptr, src, pb.staging_pitch) == 0;
+        pb.update_ticks += SDL_GetPerformanceCounter() - t0;
+        if (ok) pb.tex = t;
+    } else {
+        // El frame anterior ya debería estar copiado (corrió durante el present)
+        if (pb.inflight) {
+            const Uint64 t0 = SDL_GetPerformanceCounter();
+            pb.uploader->wait();
+            pb.wait_ticks += SDL_GetPerformanceCounter() - t0;
+            SDL_UnlockTexture(pb.inflight);
+            pb.tex = pb.inflight;
+            pb.inflight = nullptr;
+        }
+        SDL_Texture* t=nullptr; void* pixels=nullptr; int pitch=0;
+        if (lock_next_texture(pb, t, &pixels, &pitch)) {
+            pb.uploader->post(src, pb.staging_pitch, pixels, pitch, pb.w * int(sizeof(uint32_t)), pb.h);
+            pb.inflight = t;
+            pb.staging_cur ^= 1;   // el siguiente frame se sombrea en el otro staging
+        }
+    }
+    if (pb.tex) {
+        SDL_RenderCopy(renderer, pb.tex, nullptr, nullptr);
+    } else {
+        SDL_SetRenderDrawColor(renderer, 10,14,22,255);
+        SDL_RenderClear(renderer);
+    }
+}
+
+std::string upload_profile(PixelBuffer& pb) {
+    const double k = 1000.0 / double(SDL_GetPerformanceFrequency()) / double(pb.stat_frames > 0 ? pb.stat_frames : 1);
+    std::ostringstream os;
+    os << "lock=" << std::fixed << std::setprecision(3) << double(pb.lock_ticks) * k << " ms";
+    if (pb.upload == UPLOAD_UPDATE) os << ", update=" << double(pb.update_ticks) * k << " ms";
+    if (pb.upload == UPLOAD_THREAD) os << ", espera-copia=" << double(pb.wait_ticks) * k << " ms";
+    pb.lock_ticks = pb.update_ticks = pb.wait_ticks = 0;
+    pb.stat_frames = 0;
+    return os.str();
+}
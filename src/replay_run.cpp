@@ -0,0 +1,165 @@
+#include "drop_log.hpp"
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <omp.h>
+#include "arena.hpp"
+#include "backend.hpp"
+#include "numa.hpp"
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+using clk = std::chrono::steady_clock;
+
+inline double ms_between(clk::time_point a, clk::time_point b) {
+    return std::chrono::duration<double, std::milli>(b - a).count();
+}
+
+// Grabación mapeada en memoria (solo lectura, lectura secuencial)
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+#ifdef __linux__
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("--replay: no se pudo abrir " + path);
+        struct stat st{};
+        if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+            close(fd);
+            throw std::runtime_error("--replay: archivo vacío " + path);
+        }
+        size_ = size_t(st.st_size);
+        void* p = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (p == MAP_FAILED) throw std::runtime_error("--replay: mmap falló para " + path);
+        madvise(p, size_, MADV_SEQUENTIAL);
+        data_ = static_cast<const unsigned char*>(p);
+#else
+        (void)path;
+        throw std::runtime_error("--replay: requiere mmap (Linux)");
+#endif
+    }
+    ~MappedFile() {
+#ifdef __linux__
+        if (data_) munmap(const_cast<unsigned char*>(data_), size_);
+#endif
+    }
+    const unsigned char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const unsigned char* data_ = nullptr;
+    size_t size_ = 0;
+};
+}
+
+int run_replay(const AppConfig& cfg_in) {
+    MappedFile log(cfg_in.replay);
+    const unsigned char* p = log.data();
+    const unsigned char* end = p + log.size();
+
+    DropLogHeader h{};
+    if (log.size() < sizeof(h)) throw std::runtime_error("--replay: archivo truncado");
+    std::memcpy(&h, p, sizeof(h));
+    p += sizeof(h);
+    if (std::memcmp(h.magic, DROP_LOG_MAGIC, sizeof(h.magic)) != 0 || h.version != DROP_LOG_VERSION)
+        throw std::runtime_error("--replay: " + cfg_in.replay + " no es una grabación de gotas");
+    if (h.drop_bytes != sizeof(Drop))
+        throw std::runtime_error("--replay: grabación con otro layout de Drop (" + std::to_string(h.drop_bytes) + " B)");
+
+    // Escena de la grabación; backend, hilos y --math son del que reproduce
+    AppConfig cfg = cfg_in;
+    cfg.width = h.width; cfg.height = h.height; cfg.N = h.N; cfg.palette = h.palette;
+    cfg.ink_enabled = h.ink_enabled != 0;
+    cfg.slope = h.slope; cfg.spawn_rate = h.spawn_rate;
+    cfg.ink_gain = h.ink_gain; cfg.ink_decay = h.ink_decay;
+    cfg.ink_blur_mix = h.ink_blur_mix; cfg.ink_strength = h.ink_strength;
+    cfg.seed = 0;          // sin random_device: las gotas salen de la grabación
+    cfg.record.clear();
+    validate_scene(cfg, "--replay");
+
+    const int W = cfg.width, Hh = cfg.height;
+    FrameArena::global().reserve(W, Hh, 4 + 3 + 3);
+    World world(cfg);
+    for (auto* pl : {&world.H, &world.CR, &world.CG, &world.CB})
+        first_touch_rows(*pl, W, Hh);
+    std::unique_ptr<ComputeBackend> be = make_backend(cfg.backend, cfg);
+    std::vector<uint32_t> px(size_t(W) * size_t(Hh));
+    const int pitch = W * int(sizeof(uint32_t));
+
+    std::cout << "Replay: " << cfg_in.replay << " " << W << "x" << Hh << " N=" << h.N
+              << " semilla=" << h.seed << " (" << std::fixed << std::setprecision(1)
+              << double(log.size()) / double(1 << 20) << " MiB) | backend=" << be->name()
+              << ", hilos=" << omp_get_max_threads() << "\n";
+
+    double ev_ms = 0.0, sim_ms = 0.0, ink_ms = 0.0, shade_ms = 0.0;
+    uint64_t frames = 0, events = 0;
+    float t_last = 0.0f;
+    bool have_end = false;
+    DropLogEnd fin{};
+    const clk::time_point t_start = clk::now();
+    while (size_t(end - p) >= sizeof(uint32_t)) {
+        uint32_t tag;
+        std::memcpy(&tag, p, sizeof(tag));
+        if (tag == DROP_LOG_END) {
+            if (size_t(end - p) < sizeof(fin)) break;
+            std::memcpy(&fin, p, sizeof(fin));
+            have_end = true;
+            break;
+        }
+        if (tag != DROP_LOG_FRAME) throw std::runtime_error("--replay: registro desconocido en el frame " + std::to_string(frames));
+        DropLogFrame fr;
+        if (size_t(end - p) < sizeof(fr)) break;
+        std::memcpy(&fr, p, sizeof(fr));
+        const size_t ev_bytes = size_t(fr.n_events) * sizeof(DropLogEvent);
+        if (size_t(end - p) - sizeof(fr) < ev_bytes) break;          // frame cortado
+        // Registros de 4 B alineados sobre un mapeo alineado a página: los eventos se
+        // leen en el lugar
+        const DropLogEvent* ev = reinterpret_cast<const DropLogEvent*>(p + sizeof(fr));
+        p += sizeof(fr) + ev_bytes;
+
+        const clk::time_point t0 = clk::now();
+        world.drops.resize(fr.n_drops);
+        for (uint32_t k = 0; k < fr.n_events; ++k) {
+            if (ev[k].id >= fr.n_drops) throw std::runtime_error("--replay: evento fuera de rango");
+            world.drops[ev[k].id] = ev[k].d;
+        }
+        world.cfg.ink_blur_mix = fr.ink_blur_mix;
+        world.cfg.cull_eps = fr.cull_eps;
+        const clk::time_point t1 = clk::now();
+        be->accumulate(world, fr.t_now);
+        const clk::time_point t2 = clk::now();
+        be->ink(world, fr.dt);
+        const clk::time_point t3 = clk::now();
+        be->shade(world, px.data(), pitch);
+        const clk::time_point t4 = clk::now();
+
+        ev_ms += ms_between(t0, t1); sim_ms += ms_between(t1, t2);
+        ink_ms += ms_between(t2, t3); shade_ms += ms_between(t3, t4);
+        events += fr.n_events;
+        t_last = fr.t_now;
+        ++frames;
+    }
+    const double total_s = ms_between(t_start, clk::now()) * 1e-3;
+
+    const double n = frames > 0 ? double(frames) : 1.0;
+    const uint64_t scene = drops_hash(world.drops);
+    std::cout << std::fixed << std::setprecision(2)
+              << "Replay: " << frames << " frames (" << t_last << " s simulados), " << events << " eventos en "
+              << total_s << " s = " << frames / total_s << " fps\n"
+              << "  por frame: eventos=" << ev_ms / n << " ms, gotas=" << sim_ms / n << " ms, tinta="
+              << ink_ms / n << " ms, sombreado=" << shade_ms / n << " ms\n"
+              << "  escena final=" << std::hex << scene << std::dec;
+    if (!have_end) std::cout << " (grabación sin cierre: se reprodujo hasta el último frame completo)\n";
+    else if (fin.scene == 0) std::cout << " (la grabada no se conoce)\n";
+    else if (fin.scene == scene && fin.frames == frames) std::cout << " = grabada\n";
+    else std::cout << " != grabada " << std::hex << fin.scene << std::dec << " (" << fin.frames << " frames)\n";
+
+    return have_end && fin.scene != 0 && (fin.scene != scene || fin.frames != frames) ? 1 : 0;
+}
@@ -0,0 +1,79 @@
+#include "ripple.hpp"
+#include <stdexcept>
+#include "numa.hpp"
+
+static AppConfig with_restored_scene(AppConfig cfg) {
+    if (!cfg.restore.empty()) load_checkpoint_scene(cfg.restore, cfg);
+    return cfg;
+}
+
+RippleEngine::RippleEngine(const AppConfig& cfg)
+: world_(with_restored_scene(cfg))
+{
+    // Primer toque por filas con el mismo reparto que los kernels
+    for (auto* p : {&world_.H, &world_.CR, &world_.CG, &world_.CB})
+        first_touch_rows(*p, world_.cfg.width, world_.cfg.height);
+    if (!cfg.restore.empty()) {
+        restore_info_ = restore_checkpoint(cfg.restore, world_, 0.0f).describe(cfg.restore);
+        return;
+    }
+    if (!cfg.record.empty()) {
+        recorder_ = std::make_unique<DropRecorder>(cfg.record, world_);
+        world_.recorder = recorder_.get();
+    }
+    world_.init(0.0f);
+}
+
+RippleEngine::~RippleEngine() {
+    try { close_recording(); } catch (...) {}
+}
+
+std::string RippleEngine::close_recording() {
+    if (!recorder_) return "";
+    world_.recorder = nullptr;
+    std::unique_ptr<DropRecorder> rec = std::move(recorder_);
+    rec->close(world_);
+    return rec->summary();
+}
+
+void RippleEngine::checkpoint(const std::string& path) const {
+    save_checkpoint(path, world_, t_);
+}
+
+void RippleEngine::set_backend(const std::string& spec) {
+    backend_ = make_backend(spec, world_.cfg);
+}
+
+ComputeBackend& RippleEngine::backend() {
+    if (!backend_) set_backend(world_.cfg.backend);
+    return *backend_;
+}
+
+void RippleEngine::step(float dt) {
+    step_at(t_ + dt, dt);
+}
+
+void RippleEngine::step_at(float t_now, float dt) {
+    respawn(t_now);
+    accumulate();
+    ink(dt);
+}
+
+void RippleEngine::respawn(float t_now) {
+    t_ = t_now;
+    world_.maybe_respawn(t_now);
+}
+
+void RippleEngine::accumulate() {
+    backend().accumulate(world_, t_);
+}
+
+void RippleEngine::ink(float dt) {
+    backend().ink(world_, dt);
+}
+
+void RippleEngine::shade(uint32_t* pixels, int pitch) {
+    if (!pixels || pitch < width() * int(sizeof(uint32_t)))
+        throw std::runtime_error("shade: buffer nulo o pitch < 4*width");
+    backend().shade(world_, pixels, pitch);
+}
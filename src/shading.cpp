@@ -2,12 +2,12 @@
 #include <algorithm>
 #include <cmath>
 
-static inline Uint32 pack_ARGB(Uint8 a, Uint8 R, Uint8 G, Uint8 B) {
-    return (Uint32(a)<<24) | (Uint32(R)<<16) | (Uint32(G)<<8) | Uint32(B);
+static inline uint32_t pack_ARGB(uint8_t a, uint8_t R, uint8_t G, uint8_t B) {
+    return (uint32_t(a)<<24) | (uint32_t(R)<<16) | (uint32_t(G)<<8) | uint32_t(B);
 }
-static inline Uint8 to_byte(float x){
+static inline uint8_t to_byte(float x){
     int v = int(std::round(255.0f * std::clamp(x, 0.0f, 1.0f)));
-    return (Uint8)v;
+    return (uint8_t)v;
 }
 static inline float saturate(float x){ return std::clamp(x, 0.0f, 1.0f); }
 
@@ -74,31 +74,18 @@ static inline Vec3 sample_underwater(Vec3 dir){
 
 static inline float gamma_encode(float x){ return std::pow(saturate(x), 1.0f/2.2f); }
 
-bool create_pixel_buffer(SDL_Renderer* r, int w, int h, PixelBuffer& out) {
-    out.w = w; out.h = h;
-    out.tex = SDL_CreateTexture(r, out.format, SDL_TEXTUREACCESS_STREAMING, w, h);
-    return out.tex != nullptr;
-}
+namespace seq {
 
-void shade_and_present(SDL_Renderer* renderer, PixelBuffer& pb,
-                       const std::vector<float>& H,
-                       const std::vector<float>& CR,
-                       const std::vector<float>& CG,
-                       const std::vector<float>& CB,
-                       float slopeScale,
-                       int palette_mode,
-                       bool ink_enabled,
-                       float ink_strength)
+// Fila y de la referencia secuencial (lee siempre los planos float; ignora el
+// frame compacto y --math fast)
+void shade_row(const ShadeInputs& in, int y, uint32_t* row)
 {
-    void* pixels=nullptr; int pitch=0;
-    if (SDL_LockTexture(pb.tex, nullptr, &pixels, &pitch) != 0) {
-        SDL_SetRenderDrawColor(renderer, 10,14,22,255);
-        SDL_RenderClear(renderer);
-        return;
-    }
-
-    const int W=pb.w, Hh=pb.h;
-    Uint8* base = static_cast<Uint8*>(pixels);
+    const int W=in.W, Hh=in.Hh;
+    const size_t P = size_t(plane_pitch(W));
+    // Viñeta en coordenadas del lienzo (franja del muro MPI)
+    const int vy = y + in.canvas_y0, vH = in.canvas_h > 0 ? in.canvas_h : Hh;
+    const float slopeScale = in.slopeScale;
+    const int palette_mode = in.palette_mode;
 
     Vec3 L = norm(v3(-0.4f, -0.7f, 0.6f));
     Vec3 V = v3(0.0f, 0.0f, 1.0f);
@@ -113,95 +100,98 @@ void shade_and_present(SDL_Renderer* renderer, PixelBuffer& pb,
     auto Hidx = [&](int x,int y)->float {
         x = std::clamp(x, 0, W-1);
         y = std::clamp(y, 0, Hh-1);
-        return H[size_t(y)*size_t(W) + size_t(x)];
+        return in.H[size_t(y)*P + size_t(x)];
     };
-    auto Cidx = [&](const std::vector<float>& C,int x,int y)->float{
+    auto Cidx = [&](const float* C,int x,int y)->float{
         x = std::clamp(x, 0, W-1);
         y = std::clamp(y, 0, Hh-1);
-        return C[size_t(y)*size_t(W) + size_t(x)];
+        return C[size_t(y)*P + size_t(x)];
     };
 
-    for (int y=0; y<Hh; ++y) {
-        Uint32* row = reinterpret_cast<Uint32*>(base + y*size_t(pitch));
-        for (int x=0; x<W; ++x) {
-            float hC = Hidx(x,y);
-            float dhdx = 0.5f * (Hidx(x+1,y) - Hidx(x-1,y));
-            float dhdy = 0.5f * (Hidx(x,y+1) - Hidx(x,y-1));
-            float slopeMag = std::sqrt(dhdx*dhdx + dhdy*dhdy);
-            Vec3 N = norm(v3(-slopeScale*dhdx, -slopeScale*dhdy, 1.0f));
-
-            float ndotl = std::max(0.0f, dot(N, L));
-            float ndoth = std::max(0.0f, dot(N, Hhvec));
-            float spec  = std::pow(ndoth, shininess);
-
-            // Agua base (real) con absorción
-            float thickness = std::abs(hC);
-            Vec3 baseWater  = v3(0.04f, 0.10f, 0.16f);
-            Vec3 trans = v3(std::exp(-absorption.x*thickness),
-                            std::exp(-absorption.y*thickness),
-                            std::exp(-absorption.z*thickness));
-            Vec3 diffuseWater = v3(baseWater.x*trans.x, baseWater.y*trans.y, baseWater.z*trans.z);
-
-            if (palette_mode == 0 || palette_mode == 1) {
-                float t = 0.5f + 0.5f * std::tanh(0.75f * hC);
-                diffuseWater = (palette_mode==0) ? ramp_aqua(t) : ramp_mix(t);
-            }
-
-            // ---- Tinta (tiñe el difuso) ----
-            if (ink_enabled) {
-                float r = Cidx(CR,x,y), g = Cidx(CG,x,y), b = Cidx(CB,x,y);
-                float sum = std::max(1e-6f, r+g+b);
-                float s   = saturate(ink_strength * sum);
-                Vec3 ink = v3(r/sum, g/sum, b/sum);
-                diffuseWater = add( mul(diffuseWater, (1.0f - s)),
-                                    mul(ink, s) );
-            }
-
-            // Fresnel + reflexión + refracción
-            float cosNV = std::max(0.0f, dot(N, V));
-            float F0 = 0.02f;
-            float Fresnel = F0 + (1.0f - F0)*std::pow(1.0f - cosNV, 5.0f);
-
-            Vec3 I = mul(V, -1.0f);
-            Vec3 R = reflect(I, N);
-            Vec3 envRefl = sample_env(R);
-
-            Vec3 T; bool ok = refract(I, N, 1.0f/1.33f, T);
-            Vec3 envRefr = ok ? sample_underwater(T) : diffuseWater;
-
-            Vec3 ambient = mul(diffuseWater, ambientK);
-            Vec3 diffuse = mul(diffuseWater, diffK * ndotl);
-            Vec3 specC   = v3(0.96f, 0.98f, 1.00f);
-            Vec3 local   = add(ambient, add(diffuse, mul(specC, specK * spec)));
-
-            // Mezcla Fresnel
-            Vec3 colorLR = add( mul(envRefr, 1.0f - Fresnel),
-                                mul(envRefl, Fresnel) );
-            Vec3 color = add(local, colorLR);
-
-            // Rim highlight sutil en crestas (depende de la pendiente)
-            float rim = saturate((slopeMag * slopeScale - 0.25f) * 1.6f);
-            color = add(color, mul(v3(1.0f,1.0f,1.0f), 0.07f * rim));
-
-            // Vignette
-            float ux = (x + 0.5f) / float(W);
-            float uy = (y + 0.5f) / float(Hh);
-            float dx = ux - 0.5f, dy = uy - 0.5f;
-            float r2 = dx*dx + dy*dy;
-            float vign = 1.0f - 0.15f * std::pow(std::min(1.0f, r2*3.2f), 1.2f);
-            color = mul(color, vign);
-
-            // Micro modulación
-            float micro = 0.02f * std::tanh(0.8f * hC);
-            color = add(color, v3(micro, micro, micro));
-
-            Uint8 R8 = to_byte(gamma_encode(color.x));
-            Uint8 G8 = to_byte(gamma_encode(color.y));
-            Uint8 B8 = to_byte(gamma_encode(color.z));
-            row[x] = pack_ARGB(255, R8, G8, B8);
+    for (int x=0; x<W; ++x) {
+        float hC = Hidx(x,y);
+        float dhdx = 0.5f * (Hidx(x+1,y) - Hidx(x-1,y));
+        float dhdy = 0.5f * (Hidx(x,y+1) - Hidx(x,y-1));
+        float slopeMag = std::sqrt(dhdx*dhdx + dhdy*dhdy);
+        Vec3 N = norm(v3(-slopeScale*dhdx, -slopeScale*dhdy, 1.0f));
+
+        float ndotl = std::max(0.0f, dot(N, L));
+        float ndoth = std::max(0.0f, dot(N, Hhvec));
+        float spec  = std::pow(ndoth, shininess);
+
+        // Agua base (real) con absorción
+        float thickness = std::abs(hC);
+        Vec3 baseWater  = v3(0.04f, 0.10f, 0.16f);
+        Vec3 trans = v3(std::exp(-absorption.x*thickness),
+                        std::exp(-absorption.y*thickness),
+                        std::exp(-absorption.z*thickness));
+        Vec3 diffuseWater = v3(baseWater.x*trans.x, baseWater.y*trans.y, baseWater.z*trans.z);
+
+        if (palette_mode == 0 || palette_mode == 1) {
+            float t = 0.5f + 0.5f * std::tanh(0.75f * hC);
+            diffuseWater = (palette_mode==0) ? ramp_aqua(t) : ramp_mix(t);
+        }
+
+        // ---- Tinta (tiñe el difuso) ----
+        if (in.ink_enabled) {
+            float r = Cidx(in.CR,x,y), g = Cidx(in.CG,x,y), b = Cidx(in.CB,x,y);
+            float sum = std::max(1e-6f, r+g+b);
+            float s   = saturate(in.ink_strength * sum);
+            Vec3 ink = v3(r/sum, g/sum, b/sum);
+            diffuseWater = add( mul(diffuseWater, (1.0f - s)),
+                                mul(ink, s) );
         }
+
+        // Fresnel + reflexión + refracción
+        float cosNV = std::max(0.0f, dot(N, V));
+        float F0 = 0.02f;
+        float Fresnel = F0 + (1.0f - F0)*std::pow(1.0f - cosNV, 5.0f);
+
+        Vec3 I = mul(V, -1.0f);
+        Vec3 R = reflect(I, N);
+        Vec3 envRefl = sample_env(R);
+
+        Vec3 T; bool ok = refract(I, N, 1.0f/1.33f, T);
+        Vec3 envRefr = ok ? sample_underwater(T) : diffuseWater;
+
+        Vec3 ambient = mul(diffuseWater, ambientK);
+        Vec3 diffuse = mul(diffuseWater, diffK * ndotl);
+        Vec3 specC   = v3(0.96f, 0.98f, 1.00f);
+        Vec3 local   = add(ambient, add(diffuse, mul(specC, specK * spec)));
+
+        // Mezcla Fresnel
+        Vec3 colorLR = add( mul(envRefr, 1.0f - Fresnel),
+                            mul(envRefl, Fresnel) );
+        Vec3 color = add(local, colorLR);
+
+        // Rim highlight sutil en crestas (depende de la pendiente)
+        float rim = saturate((slopeMag * slopeScale - 0.25f) * 1.6f);
+        color = add(color, mul(v3(1.0f,1.0f,1.0f), 0.07f * rim));
+
+        // Vignette
+        float ux = (x + 0.5f) / float(W);
+        float uy = (vy + 0.5f) / float(vH);
+        float dx = ux - 0.5f, dy = uy - 0.5f;
+        float r2 = dx*dx + dy*dy;
+        float vign = 1.0f - 0.15f * std::pow(std::min(1.0f, r2*3.2f), 1.2f);
+        color = mul(color, vign);
+
+        // Micro modulación
+        float micro = 0.02f * std::tanh(0.8f * hC);
+        color = add(color, v3(micro, micro, micro));
+
+        uint8_t R8 = to_byte(gamma_encode(color.x));
+        uint8_t G8 = to_byte(gamma_encode(color.y));
+        uint8_t B8 = to_byte(gamma_encode(color.z));
+        row[x] = pack_ARGB(255, R8, G8, B8);
     }
+}
 
-    SDL_UnlockTexture(pb.tex);
-    SDL_RenderCopy(renderer, pb.tex, nullptr, nullptr);
+void shade_frame(const ShadeInputs& in, uint32_t* pixels, int pitch)
+{
+    uint8_t* base = reinterpret_cast<uint8_t*>(pixels);
+    for (int y=0; y<in.Hh; ++y)
+        seq::shade_row(in, y, reinterpret_cast<uint32_t*>(base + y*size_t(pitch)));
 }
+
+} // namespace seq
@@ -1,14 +1,17 @@
 #include "shading.hpp"
+#include "cpu_dispatch.hpp"
+#include "fast_math.hpp"
+#include "region_sync.hpp"
 #include <algorithm>
 #include <cmath>
 #include <omp.h>
 
-static inline Uint32 pack_ARGB(Uint8 a, Uint8 R, Uint8 G, Uint8 B) {
-    return (Uint32(a)<<24) | (Uint32(R)<<16) | (Uint32(G)<<8) | Uint32(B);
+static inline uint32_t pack_ARGB(uint8_t a, uint8_t R, uint8_t G, uint8_t B) {
+    return (uint32_t(a)<<24) | (uint32_t(R)<<16) | (uint32_t(G)<<8) | uint32_t(B);
 }
-static inline Uint8 to_byte(float x){
+static inline uint8_t to_byte(float x){
     int v = int(std::round(255.0f * std::clamp(x, 0.0f, 1.0f)));
-    return (Uint8)v;
+    return (uint8_t)v;
 }
 static inline float saturate(float x){ return std::clamp(x, 0.0f, 1.0f); }
 
@@ -73,33 +76,33 @@ static inline Vec3 sample_underwater(Vec3 dir){
     return add( mul(deep, 1.0f - v), mul(green, v) );
 }
 
-static inline float gamma_encode(float x){ return std::pow(saturate(x), 1.0f/2.2f); }
+template <class M>
+static inline float gamma_encode(float x){ return M::pow(saturate(x), 1.0f/2.2f); }
 
-bool create_pixel_buffer(SDL_Renderer* r, int w, int h, PixelBuffer& out) {
-    out.w = w; out.h = h;
-    out.tex = SDL_CreateTexture(r, out.format, SDL_TEXTUREACCESS_STREAMING, w, h);
-    return out.tex != nullptr;
-}
+// Lectura de H y tinta según el almacenamiento (float o compacto fp16/unorm16)
+struct F32Src {
+    const float *H, *CR, *CG, *CB;
+    float h(size_t i) const { return H[i]; }
+    float r(size_t i) const { return CR[i]; }
+    float g(size_t i) const { return CG[i]; }
+    float b(size_t i) const { return CB[i]; }
+};
+struct Compact16Src {
+    const uint16_t *H, *CR, *CG, *CB;
+    float h(size_t i) const { return f16_to_f32(H[i]); }
+    float r(size_t i) const { return from_unorm16(CR[i]); }
+    float g(size_t i) const { return from_unorm16(CG[i]); }
+    float b(size_t i) const { return from_unorm16(CB[i]); }
+};
 
-void shade_and_present(SDL_Renderer* renderer, PixelBuffer& pb,
-                       const std::vector<float>& H,
-                       const std::vector<float>& CR,
-                       const std::vector<float>& CG,
-                       const std::vector<float>& CB,
-                       float slopeScale,
-                       int palette_mode,
-                       bool ink_enabled,
-                       float ink_strength)
+// Palette (0=aqua, 1=mix, 2=real) e Ink fijos en compilación: sin ramas por píxel
+template <int Palette, bool Ink, class M, class Src>
+static void shade_span_impl(const ShadeInputs& in, const Src& src, int y, int x0, int x1, uint32_t* row)
 {
-    void* pixels=nullptr; int pitch=0;
-    if (SDL_LockTexture(pb.tex, nullptr, &pixels, &pitch) != 0) {
-        SDL_SetRenderDrawColor(renderer, 10,14,22,255);
-        SDL_RenderClear(renderer);
-        return;
-    }
-
-    const int W=pb.w, Hh=pb.h;
-    Uint8* base = static_cast<Uint8*>(pixels);
+    const int W=in.W, Hh=in.Hh;
+    const size_t P = size_t(plane_pitch(W));
+    // Viñeta en coordenadas del lienzo (franja del muro MPI)
+    const int vy = y + in.canvas_y0, vH = in.canvas_h > 0 ? in.canvas_h : Hh;
 
     Vec3 L = norm(v3(-0.4f, -0.7f, 0.6f));
     Vec3 V = v3(0.0f, 0.0f, 1.0f);
@@ -114,97 +117,140 @@ void shade_and_present(SDL_Renderer* renderer, PixelBuffer& pb,
     auto Hidx = [&](int x,int y)->float {
         x = std::clamp(x, 0, W-1);
         y = std::clamp(y, 0, Hh-1);
-        return H[size_t(y)*size_t(W) + size_t(x)];
-    };
-    auto Cidx = [&](const std::vector<float>& C,int x,int y)->float{
-        x = std::clamp(x, 0, W-1);
-        y = std::clamp(y, 0, Hh-1);
-        return C[size_t(y)*size_t(W) + size_t(x)];
+        return src.h(size_t(y)*P + size_t(x));
     };
 
-    #pragma omp parallel for collapse(2)
-    for (int y=0; y<Hh; ++y) {
-        for (int x=0; x<W; ++x) {
-            float hC = Hidx(x,y);
-            float dhdx = 0.5f * (Hidx(x+1,y) - Hidx(x-1,y));
-            float dhdy = 0.5f * (Hidx(x,y+1) - Hidx(x,y-1));
-            float slopeMag = std::sqrt(dhdx*dhdx + dhdy*dhdy);
-            Vec3 N = norm(v3(-slopeScale*dhdx, -slopeScale*dhdy, 1.0f));
-
-            float ndotl = std::max(0.0f, dot(N, L));
-            float ndoth = std::max(0.0f, dot(N, Hhvec));
-            float spec  = std::pow(ndoth, shininess);
-
-            // Agua base (real) con absorción
-            float thickness = std::abs(hC);
-            Vec3 baseWater  = v3(0.04f, 0.10f, 0.16f);
-            Vec3 trans = v3(std::exp(-absorption.x*thickness),
-                            std::exp(-absorption.y*thickness),
-                            std::exp(-absorption.z*thickness));
-            Vec3 diffuseWater = v3(baseWater.x*trans.x, baseWater.y*trans.y, baseWater.z*trans.z);
-
-            if (palette_mode == 0 || palette_mode == 1) {
-                float t = 0.5f + 0.5f * std::tanh(0.75f * hC);
-                diffuseWater = (palette_mode==0) ? ramp_aqua(t) : ramp_mix(t);
-            }
-
-            // ---- Tinta (tiñe el difuso) ----
-            if (ink_enabled) {
-                float r = Cidx(CR,x,y), g = Cidx(CG,x,y), b = Cidx(CB,x,y);
-                float sum = std::max(1e-6f, r+g+b);
-                float s   = saturate(ink_strength * sum);
-                Vec3 ink = v3(r/sum, g/sum, b/sum);
-                diffuseWater = add( mul(diffuseWater, (1.0f - s)),
-                                    mul(ink, s) );
-            }
-
-            // Fresnel + reflexión + refracción
-            float cosNV = std::max(0.0f, dot(N, V));
-            float F0 = 0.02f;
-            float Fresnel = F0 + (1.0f - F0)*std::pow(1.0f - cosNV, 5.0f);
-
-            Vec3 I = mul(V, -1.0f);
-            Vec3 R = reflect(I, N);
-            Vec3 envRefl = sample_env(R);
-
-            Vec3 T; bool ok = refract(I, N, 1.0f/1.33f, T);
-            Vec3 envRefr = ok ? sample_underwater(T) : diffuseWater;
-
-            Vec3 ambient = mul(diffuseWater, ambientK);
-            Vec3 diffuse = mul(diffuseWater, diffK * ndotl);
-            Vec3 specC   = v3(0.96f, 0.98f, 1.00f);
-            Vec3 local   = add(ambient, add(diffuse, mul(specC, specK * spec)));
-
-            // Mezcla Fresnel
-            Vec3 colorLR = add( mul(envRefr, 1.0f - Fresnel),
-                                mul(envRefl, Fresnel) );
-            Vec3 color = add(local, colorLR);
-
-            // Rim highlight sutil en crestas (depende de la pendiente)
-            float rim = saturate((slopeMag * slopeScale - 0.25f) * 1.6f);
-            color = add(color, mul(v3(1.0f,1.0f,1.0f), 0.07f * rim));
-
-            // Vignette
-            float ux = (x + 0.5f) / float(W);
-            float uy = (y + 0.5f) / float(Hh);
-            float dx = ux - 0.5f, dy = uy - 0.5f;
-            float r2 = dx*dx + dy*dy;
-            float vign = 1.0f - 0.15f * std::pow(std::min(1.0f, r2*3.2f), 1.2f);
-            color = mul(color, vign);
-
-            // Micro modulación
-            float micro = 0.02f * std::tanh(0.8f * hC);
-            color = add(color, v3(micro, micro, micro));
-
-            Uint8 R8 = to_byte(gamma_encode(color.x));
-            Uint8 G8 = to_byte(gamma_encode(color.y));
-            Uint8 B8 = to_byte(gamma_encode(color.z));
-            
-            Uint32* row = reinterpret_cast<Uint32*>(base + y*size_t(pitch));
-            row[x] = pack_ARGB(255, R8, G8, B8);
+    for (int x=x0; x<x1; ++x) {
+        float hC = Hidx(x,y);
+        float dhdx = 0.5f * (Hidx(x+1,y) - Hidx(x-1,y));
+        float dhdy = 0.5f * (Hidx(x,y+1) - Hidx(x,y-1));
+        float slopeMag = std::sqrt(dhdx*dhdx + dhdy*dhdy);
+        Vec3 N = norm(v3(-in.slopeScale*dhdx, -in.slopeScale*dhdy, 1.0f));
+
+        float ndotl = std::max(0.0f, dot(N, L));
+        float ndoth = std::max(0.0f, dot(N, Hhvec));
+        float spec;
+        if constexpr (M::fast) spec = fm::powi<90>(ndoth);   // shininess
+        else spec = std::pow(ndoth, shininess);
+
+        // Agua base (real) con absorción
+        float thickness = std::abs(hC);
+        Vec3 baseWater  = v3(0.04f, 0.10f, 0.16f);
+        Vec3 trans = v3(M::exp(-absorption.x*thickness),
+                        M::exp(-absorption.y*thickness),
+                        M::exp(-absorption.z*thickness));
+        Vec3 diffuseWater = v3(baseWater.x*trans.x, baseWater.y*trans.y, baseWater.z*trans.z);
+
+        if constexpr (Palette == 0 || Palette == 1) {
+            float t = 0.5f + 0.5f * M::tanh(0.75f * hC);
+            diffuseWater = (Palette==0) ? ramp_aqua(t) : ramp_mix(t);
         }
+
+        // ---- Tinta (tiñe el difuso) ----
+        if constexpr (Ink) {
+            size_t ci = size_t(y)*P + size_t(x);
+            float r = src.r(ci), g = src.g(ci), b = src.b(ci);
+            float sum = std::max(1e-6f, r+g+b);
+            float s   = saturate(in.ink_strength * sum);
+            Vec3 ink = v3(r/sum, g/sum, b/sum);
+            diffuseWater = add( mul(diffuseWater, (1.0f - s)),
+                                mul(ink, s) );
+        }
+
+        // Fresnel + reflexión + refracción
+        float cosNV = std::max(0.0f, dot(N, V));
+        float F0 = 0.02f;
+        float Fresnel;
+        if constexpr (M::fast) Fresnel = F0 + (1.0f - F0)*fm::powi<5>(1.0f - cosNV);
+        else Fresnel = F0 + (1.0f - F0)*std::pow(1.0f - cosNV, 5.0f);
+
+        Vec3 I = mul(V, -1.0f);
+        Vec3 R = reflect(I, N);
+        Vec3 envRefl = sample_env(R);
+
+        Vec3 T; bool ok = refract(I, N, 1.0f/1.33f, T);
+        Vec3 envRefr = ok ? sample_underwater(T) : diffuseWater;
+
+        Vec3 ambient = mul(diffuseWater, ambientK);
+        Vec3 diffuse = mul(diffuseWater, diffK * ndotl);
+        Vec3 specC   = v3(0.96f, 0.98f, 1.00f);
+        Vec3 local   = add(ambient, add(diffuse, mul(specC, specK * spec)));
+
+        // Mezcla Fresnel
+        Vec3 colorLR = add( mul(envRefr, 1.0f - Fresnel),
+                            mul(envRefl, Fresnel) );
+        Vec3 color = add(local, colorLR);
+
+        // Rim highlight sutil en crestas (depende de la pendiente)
+        float rim = saturate((slopeMag * in.slopeScale - 0.25f) * 1.6f);
+        color = add(color, mul(v3(1.0f,1.0f,1.0f), 0.07f * rim));
+
+        // Vignette
+        float ux = (x + 0.5f) / float(W);
+        float uy = (vy + 0.5f) / float(vH);
+        float dx = ux - 0.5f, dy = uy - 0.5f;
+        float r2 = dx*dx + dy*dy;
+        float vign = 1.0f - 0.15f * M::pow(std::min(1.0f, r2*3.2f), 1.2f);
+        color = mul(color, vign);
+
+        // Micro modulación
+        float micro = 0.02f * M::tanh(0.8f * hC);
+        color = add(color, v3(micro, micro, micro));
+
+        uint8_t R8 = to_byte(gamma_encode<M>(color.x));
+        uint8_t G8 = to_byte(gamma_encode<M>(color.y));
+        uint8_t B8 = to_byte(gamma_encode<M>(color.z));
+        row[x] = pack_ARGB(255, R8, G8, B8);
     }
+}
+
+// Una instanciación por (paleta, tinta)
+template <class M, class Src>
+static void shade_span_dispatch(const ShadeInputs& in, const Src& src, int y, int x0, int x1, uint32_t* row)
+{
+    switch (in.palette_mode * 2 + (in.ink_enabled ? 1 : 0)) {
+        case 0:  shade_span_impl<0, false, M>(in, src, y, x0, x1, row); break;
+        case 1:  shade_span_impl<0, true,  M>(in, src, y, x0, x1, row); break;
+        case 2:  shade_span_impl<1, false, M>(in, src, y, x0, x1, row); break;
+        case 3:  shade_span_impl<1, true,  M>(in, src, y, x0, x1, row); break;
+        case 4:  shade_span_impl<2, false, M>(in, src, y, x0, x1, row); break;
+        default: shade_span_impl<2, true,  M>(in, src, y, x0, x1, row); break;
+    }
+}
+
+template <class Src>
+static void shade_span_math(const ShadeInputs& in, const Src& src, int y, int x0, int x1, uint32_t* row)
+{
+    if (in.fast_math) shade_span_dispatch<FastMath >(in, src, y, x0, x1, row);
+    else              shade_span_dispatch<ExactMath>(in, src, y, x0, x1, row);
+}
 
-    SDL_UnlockTexture(pb.tex);
-    SDL_RenderCopy(renderer, pb.tex, nullptr, nullptr);
+// Sombrea los píxeles [x0, x1) de la fila y (sin paralelismo propio): la usan
+// shade_frame y los motores que reparten el trabajo por su cuenta.
+// La variante (almacenamiento, matemática, paleta, tinta) se elige una vez por tramo.
+RIPPLE_MULTIVERSION
+void shade_span(const ShadeInputs& in, int y, int x0, int x1, uint32_t* row)
+{
+    if (in.H16) shade_span_math(in, Compact16Src{in.H16, in.CR16, in.CG16, in.CB16}, y, x0, x1, row);
+    else        shade_span_math(in, F32Src{in.H, in.CR, in.CG, in.CB}, y, x0, x1, row);
+}
+
+void shade_row(const ShadeInputs& in, int y, uint32_t* row) {
+    shade_span(in, y, 0, in.W, row);
+}
+
+void shade_frame(const ShadeInputs& in, uint32_t* pixels, int pitch)
+{
+    uint8_t* base = reinterpret_cast<uint8_t*>(pixels);
+
+    RegionTimer rt;
+    #pragma omp parallel
+    {
+        rt.enter();
+        #pragma omp for nowait
+        for (int y=0; y<in.Hh; ++y)
+            shade_row(in, y, reinterpret_cast<uint32_t*>(base + y*size_t(pitch)));
+        rt.leave();
+    }
+    rt.close();
 }
@@ -0,0 +1,161 @@
+#include "shm_ring.hpp"
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define RIPPLE_HAVE_SHM 1
+#endif
+
+namespace {
+constexpr size_t PAGE = 4096;
+inline size_t align_up(size_t v, size_t a) { return (v + a - 1) & ~(a - 1); }
+
+// shm_open exige "/nombre" sin más barras
+std::string shm_path(const std::string& name) {
+    std::string p = name.empty() || name[0] != '/' ? "/" + name : name;
+    if (p.size() < 2 || p.find('/', 1) != std::string::npos)
+        throw std::runtime_error("--shm: nombre inválido '" + name + "' (sin '/', p. ej. ripple)");
+    return p;
+}
+
+std::string sys_error(const std::string& what) {
+    return what + ": " + std::strerror(errno);
+}
+}
+
+ShmRingWriter::ShmRingWriter(const std::string& name, int W, int H, int slots)
+: name_(shm_path(name))
+{
+#ifdef RIPPLE_HAVE_SHM
+    const size_t stride = align_up(size_t(W) * sizeof(uint32_t), 64);
+    const size_t slot_bytes = PAGE + align_up(stride * size_t(H), PAGE);
+    size_ = PAGE + slot_bytes * size_t(slots);
+
+    int fd = shm_open(name_.c_str(), O_CREAT | O_RDWR, 0600);
+    if (fd < 0) throw std::runtime_error(sys_error("shm_open " + name_));
+    if (ftruncate(fd, off_t(size_)) != 0) {
+        const std::string err = sys_error("ftruncate " + name_);
+        close(fd); shm_unlink(name_.c_str());
+        throw std::runtime_error(err);
+    }
+    void* p = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) {
+        const std::string err = sys_error("mmap " + name_);
+        shm_unlink(name_.c_str());
+        throw std::runtime_error(err);
+    }
+    base_ = static_cast<unsigned char*>(p);
+
+    // Un segmento reutilizado puede traer datos viejos: encabezados desde cero
+    std::memset(base_, 0, PAGE);
+    for (int s = 0; s < slots; ++s) std::memset(base_ + PAGE + slot_bytes * size_t(s), 0, PAGE);
+
+    hdr_ = new (base_) ShmRingHeader{};
+    std::memcpy(hdr_->magic, SHM_RING_MAGIC, sizeof(hdr_->magic));
+    hdr_->version = SHM_RING_VERSION;
+    hdr_->format = SHM_FORMAT_ARGB8888;
+    hdr_->width = uint32_t(W); hdr_->height = uint32_t(H);
+    hdr_->stride = uint32_t(stride);
+    hdr_->slots = uint32_t(slots);
+    hdr_->slot_offset = PAGE;
+    hdr_->slot_bytes = slot_bytes;
+    hdr_->pixel_offset = PAGE;
+    hdr_->writer_pid = int64_t(getpid());
+    for (int s = 0; s < slots; ++s) new (base_ + PAGE + slot_bytes * size_t(s)) ShmSlotHeader{};
+    hdr_->latest.store(0, std::memory_order_release);
+#else
+    (void)W; (void)H; (void)slots;
+    throw std::runtime_error("--shm: memoria compartida POSIX no disponible en esta plataforma");
+#endif
+}
+
+ShmRingWriter::~ShmRingWriter() {
+#ifdef RIPPLE_HAVE_SHM
+    if (base_) {
+        munmap(base_, size_);
+        shm_unlink(name_.c_str());
+    }
+#endif
+}
+
+ShmSlotHeader* ShmRingWriter::slot(uint64_t f) const {
+    const uint64_t s = (f - 1) % hdr_->slots;
+    return reinterpret_cast<ShmSlotHeader*>(base_ + hdr_->slot_offset + s * hdr_->slot_bytes);
+}
+
+uint32_t* ShmRingWriter::begin_frame(int& pitch) {
+    ShmSlotHeader* sl = slot(++frame_);
+    sl->lock.store(2 * frame_ - 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);    // impar visible antes que los píxeles
+    pitch = int(hdr_->stride);
+    return reinterpret_cast<uint32_t*>(reinterpret_cast<unsigned char*>(sl) + hdr_->pixel_offset);
+}
+
+void ShmRingWriter::publish(float t_sim) {
+    ShmSlotHeader* sl = slot(frame_);
+    sl->frame = frame_;
+    sl->t_ns = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch()).count());
+    sl->t_sim = t_sim;
+    sl->width = hdr_->width; sl->height = hdr_->height; sl->stride = hdr_->stride;
+    sl->lock.store(2 * frame_, std::memory_order_release);
+    hdr_->latest.store(frame_, std::memory_order_release);
+}
+
+ShmRingReader::ShmRingReader(const std::string& name) {
+#ifdef RIPPLE_HAVE_SHM
+    const std::string path = shm_path(name);
+    int fd = shm_open(path.c_str(), O_RDONLY, 0);
+    if (fd < 0) throw std::runtime_error(sys_error("shm_open " + path));
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(ShmRingHeader)) {
+        close(fd);
+        throw std::runtime_error("shm " + path + ": segmento vacío o ilegible");
+    }
+    size_ = size_t(st.st_size);
+    void* p = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) throw std::runtime_error(sys_error("mmap " + path));
+    base_ = static_cast<const unsigned char*>(p);
+    hdr_ = reinterpret_cast<const ShmRingHeader*>(base_);
+    if (std::memcmp(hdr_->magic, SHM_RING_MAGIC, sizeof(hdr_->magic)) != 0 || hdr_->version != SHM_RING_VERSION
+        || hdr_->slots == 0 || hdr_->slot_offset + hdr_->slot_bytes * hdr_->slots > size_) {
+        munmap(const_cast<unsigned char*>(base_), size_);
+        throw std::runtime_error("shm " + path + ": no es un anillo de frames compatible");
+    }
+#else
+    (void)name;
+    throw std::runtime_error("memoria compartida POSIX no disponible en esta plataforma");
+#endif
+}
+
+ShmRingReader::~ShmRingReader() {
+#ifdef RIPPLE_HAVE_SHM
+    if (base_) munmap(const_cast<unsigned char*>(base_), size_);
+#endif
+}
+
+bool ShmRingReader::latest(ShmFrameView& out, uint64_t after) const {
+    const uint64_t f = hdr_->latest.load(std::memory_order_acquire);
+    if (f == 0 || f <= after) return false;
+    const unsigned char* sp = base_ + hdr_->slot_offset + ((f - 1) % hdr_->slots) * hdr_->slot_bytes;
+    const ShmSlotHeader* sl = reinterpret_cast<const ShmSlotHeader*>(sp);
+    if (sl->lock.load(std::memory_order_acquire) != 2 * f) return false;   // ya reescrito
+    out.pixels = reinterpret_cast<const uint32_t*>(sp + hdr_->pixel_offset);
+    out.width = int(sl->width); out.height = int(sl->height); out.pitch = int(sl->stride);
+    out.frame = f; out.t_ns = sl->t_ns; out.t_sim = sl->t_sim;
+    out.slot = sl;
+    return still_valid(out);
+}
+
+bool ShmRingReader::still_valid(const ShmFrameView& v) const {
+    std::atomic_thread_fence(std::memory_order_acquire);   // lecturas de píxeles antes que el lock
+    return v.slot && v.slot->lock.load(std::memory_order_relaxed) == 2 * v.frame;
+}
@@ -0,0 +1,85 @@
+#include "shm_ring.hpp"
+#include <chrono>
+#include <csignal>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <omp.h>
+#include "arena.hpp"
+#include "ripple.hpp"
+
+namespace {
+using clk = std::chrono::steady_clock;
+
+volatile std::sig_atomic_t g_stop = 0;
+extern "C" void on_stop_signal(int) { g_stop = 1; }
+
+inline double ms_between(clk::time_point a, clk::time_point b) {
+    return std::chrono::duration<double, std::milli>(b - a).count();
+}
+}
+
+int run_shm(const AppConfig& cfg) {
+    const int W = cfg.width, Hh = cfg.height;
+    FrameArena::global().reserve(W, Hh, 4 + 3 + 3);
+    RippleEngine eng(cfg);
+    if (!eng.restore_info().empty()) std::cout << eng.restore_info() << "\n";
+    ShmRingWriter ring(cfg.shm_name, W, Hh, cfg.shm_slots);
+
+    std::signal(SIGINT, on_stop_signal);
+    std::signal(SIGTERM, on_stop_signal);
+
+    std::cout << "SHM: " << ring.name() << " (/dev/shm), " << W << "x" << Hh << " ARGB8888, "
+              << cfg.shm_slots << " slots, " << std::fixed << std::setprecision(1)
+              << double(ring.bytes()) / double(1 << 20) << " MiB | backend=" << eng.backend().name()
+              << ", hilos=" << omp_get_max_threads() << ", " << cfg.shm_fps << " fps"
+              << (cfg.shm_frames > 0 ? "" : " (Ctrl+C para salir)") << "\n";
+
+    // Tiempo real: el frame k sale en t0 + k/fps; si la simulación no llega se sigue
+    // sin dormir (el tiempo simulado es el de reloj, como en la ventana)
+    const auto period = std::chrono::duration_cast<clk::duration>(std::chrono::duration<double>(1.0 / cfg.shm_fps));
+    const clk::time_point t0 = clk::now();
+    clk::time_point t_prev = t0, t_log = t0;
+    double sim_ms = 0.0, shade_ms = 0.0;
+    uint64_t late = 0, n_log = 0;
+    for (uint64_t k = 1; !g_stop && (cfg.shm_frames == 0 || k <= uint64_t(cfg.shm_frames)); ++k) {
+        const clk::time_point due = t0 + period * k;
+        if (clk::now() < due) std::this_thread::sleep_until(due);
+        else ++late;
+
+        const clk::time_point tA = clk::now();
+        const float t_now = float(std::chrono::duration<double>(tA - t0).count());
+        const float dt = float(std::chrono::duration<double>(tA - t_prev).count());
+        t_prev = tA;
+        eng.step_at(t_now, dt);
+        const clk::time_point tB = clk::now();
+        int pitch = 0;
+        uint32_t* px = ring.begin_frame(pitch);
+        eng.shade(px, pitch);
+        ring.publish(t_now);
+        const clk::time_point tC = clk::now();
+        sim_ms += ms_between(tA, tB); shade_ms += ms_between(tB, tC); ++n_log;
+
+        if (cfg.fpslog || cfg.profile) {
+            const double el = ms_between(t_log, tC);
+            if (el >= 1000.0) {
+                std::cout << std::fixed << std::setprecision(2) << "shm: frame=" << ring.frames()
+                          << " fps=" << n_log * 1000.0 / el << " sim+ink=" << sim_ms / n_log
+                          << " ms shade=" << shade_ms / n_log << " ms late=" << late << "\n";
+                t_log = tC; sim_ms = shade_ms = 0.0; n_log = 0;
+            }
+        }
+    }
+    std::signal(SIGINT, SIG_DFL);
+    std::signal(SIGTERM, SIG_DFL);
+
+    std::cout << "SHM: " << ring.frames() << " frames publicados en " << std::fixed << std::setprecision(2)
+              << ms_between(t0, clk::now()) * 1e-3 << " s (" << late << " tarde); " << ring.name() << " eliminado\n";
+    if (!cfg.checkpoint.empty()) {
+        eng.checkpoint(cfg.checkpoint);
+        std::cout << "Checkpoint: " << cfg.checkpoint << " t=" << eng.time() << " s\n";
+    }
+    const std::string rec = eng.close_recording();
+    if (!rec.empty()) std::cout << rec << "\n";
+    return 0;
+}
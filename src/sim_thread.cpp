@@ -0,0 +1,74 @@
+#include "sim_thread.hpp"
+#include <algorithm>
+#include "model.hpp"
+#include "ink.hpp"
+
+SimThread::SimThread(World& world)
+: world_(world), hz_(world.cfg.sim_hz) {   // parse_args: 1..1000 (puede ser fraccionario)
+    size_t SZ = plane_size(world_.cfg.width, world_.cfg.height);
+    for (int i = 0; i < 3; ++i) tb_.at(i).resize(SZ);
+}
+
+SimThread::~SimThread() { stop(); }
+
+void SimThread::start() {
+    stop_.store(false);
+    th_ = std::thread(&SimThread::loop, this);
+}
+
+void SimThread::stop() {
+    stop_.store(true);
+    if (th_.joinable()) th_.join();
+}
+
+void SimThread::loop() {
+    using clock = std::chrono::steady_clock;
+    const AppConfig& cfg = world_.cfg;
+    const double dt = 1.0 / double(hz_);
+    const auto period = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(dt));
+    // Si el atraso supera esto se re-sincroniza el reloj en vez de intentar recuperar
+    const auto max_lag = period * 5;
+
+    auto deadline = clock::now();
+    uint64_t step = 0;
+
+    while (!stop_.load(std::memory_order_relaxed)) {
+        auto t1 = clock::now();
+        // Tiempo de simulación exacto: no depende del reloj de pared
+        float t_now = float(double(step) * dt);
+
+        FrameSlot& s = tb_.write_buffer();
+        world_.maybe_respawn(t_now);
+        seq::accumulate_heightfield(
+            s.H, world_.CR, world_.CG, world_.CB,
+            cfg.width, cfg.height, world_.drops, t_now,
+            cfg.ink_enabled, cfg.ink_gain
+        );
+        seq::ink_postprocess(world_.CR, world_.CG, world_.CB,
+                             cfg.width, cfg.height,
+                             float(dt), cfg.ink_decay, cfg.ink_blur_mix);
+        t_sim_.store(t_now, std::memory_order_release);   // gotas y tinta del World ya en t_now
+        std::copy(world_.CR.begin(), world_.CR.end(), s.CR.begin());
+        std::copy(world_.CG.begin(), world_.CG.end(), s.CG.begin());
+        std::copy(world_.CB.begin(), world_.CB.end(), s.CB.begin());
+
+        s.t_now   = t_now;
+        s.dt      = float(dt);
+        s.seq     = step;
+        s.t_start = t1;
+        s.sim_ms  = std::chrono::duration<double, std::milli>(clock::now() - t1).count();
+
+        if (tb_.publish()) dropped_.fetch_add(1, std::memory_order_relaxed);
+        steps_.fetch_add(1, std::memory_order_relaxed);
+        ++step;
+
+        deadline += period;
+        auto now = clock::now();
+        if (now > deadline) {
+            late_.fetch_add(1, std::memory_order_relaxed);
+            if (now - deadline > max_lag) deadline = now;
+        } else {
+            std::this_thread::sleep_until(deadline);
+        }
+    }
+}
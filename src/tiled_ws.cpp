@@ -0,0 +1,136 @@
+#include "tiled.hpp"
+#include <algorithm>
+#include "ink.hpp"
+#include "shading.hpp"
+#include "numa.hpp"
+#include "cpu_dispatch.hpp"
+
+// Tile de gotas: limpia H en [x0,x1]x[y0,y1] (inclusive) y suma las gotas del bin
+RIPPLE_MULTIVERSION
+static void splat_tile(float* H, float* CR, float* CG, float* CB, int W,
+                       const std::vector<Drop>& drops, const std::vector<DropBand>& bands,
+                       const std::vector<int>& bin, int x0, int x1, int y0, int y1,
+                       bool ink_enabled, float ink_gain, bool fast_math, int canvas_y0)
+{
+    const size_t P = size_t(plane_pitch(W));
+    for (int y = y0; y <= y1; ++y)
+        std::fill(H + size_t(y)*P + x0, H + size_t(y)*P + x1 + 1, 0.0f);
+    for (int i : bin) {
+        const DropBand& b = bands[size_t(i)];
+        splat_drop_rect<false>(H, CR, CG, CB, W, drops[size_t(i)], b,
+                               std::max(x0, b.xmin), std::min(x1, b.xmax),
+                               std::max(y0, b.ymin), std::min(y1, b.ymax),
+                               ink_enabled, ink_gain, fast_math, canvas_y0);
+    }
+}
+
+TiledBackend::TiledBackend(const AppConfig& cfg, WorkStealingPool& pool)
+: pool_(pool), W_(cfg.width), H_(cfg.height) {
+    tilesX_ = (W_ + TILE - 1) / TILE;
+    tilesY_ = (H_ + TILE - 1) / TILE;
+    bins_.resize(size_t(tilesX_) * size_t(tilesY_));
+    size_t SZ = plane_size(W_, H_);
+    TR.resize(SZ);
+    TG.resize(SZ);
+    TB.resize(SZ);
+    first_touch_rows(TR, W_, H_);
+    first_touch_rows(TG, W_, H_);
+    first_touch_rows(TB, W_, H_);
+}
+
+void TiledBackend::accumulate(World& world, float t_now) {
+    const AppConfig& cfg = world.cfg;
+    const auto& drops = world.drops;
+    const int nd = int(drops.size());
+    bands_.resize(size_t(nd));
+    live_.resize(size_t(nd));
+
+    // Bandas por gota (independientes entre sí)
+    pool_.parallel_for(0, nd, 256, [&](int i0, int i1){
+        for (int i = i0; i < i1; ++i)
+            live_[size_t(i)] = drop_band(drops[size_t(i)], t_now, W_, H_, bands_[size_t(i)],
+                                           cfg.cull_eps, cfg.ink_enabled ? cfg.ink_gain : 0.0f, cfg.canvas_y0) ? 1 : 0;
+    });
+
+    // Binning: el anillo [rmin, rmax] debe cortar el rectángulo del tile
+    // (gotas en filas del lienzo: el tile se corre canvas_y0)
+    const float oy = float(cfg.canvas_y0);
+    for (auto& b : bins_) b.clear();
+    size_t refs = 0;
+    for (int i = 0; i < nd; ++i) {
+        if (!live_[size_t(i)]) continue;
+        const Drop& d = drops[size_t(i)];
+        const DropBand& b = bands_[size_t(i)];
+        int tx0 = b.xmin / TILE, tx1 = b.xmax / TILE;
+        int ty0 = b.ymin / TILE, ty1 = b.ymax / TILE;
+        for (int ty = ty0; ty <= ty1; ++ty) {
+            float ry0 = float(ty*TILE) + oy, ry1 = float(std::min(H_, (ty+1)*TILE)) + oy;
+            for (int tx = tx0; tx <= tx1; ++tx) {
+                float rx0 = float(tx*TILE), rx1 = float(std::min(W_, (tx+1)*TILE));
+                // distancia mínima y máxima del centro de la gota al rectángulo
+                float nx = std::clamp(d.x, rx0, rx1) - d.x, ny = std::clamp(d.y, ry0, ry1) - d.y;
+                float fx = std::max(std::abs(rx0 - d.x), std::abs(rx1 - d.x));
+                float fy = std::max(std::abs(ry0 - d.y), std::abs(ry1 - d.y));
+                if (nx*nx + ny*ny > b.rmax2 || fx*fx + fy*fy < b.rmin2) continue;
+                bins_[size_t(ty)*size_t(tilesX_) + size_t(tx)].push_back(i);
+                refs++;
+            }
+        }
+    }
+    size_t nonempty = 0;
+    for (auto& b : bins_) if (!b.empty()) nonempty++;
+    drops_per_tile_ = nonempty ? double(refs) / double(nonempty) : 0.0;
+
+    float* H  = world.H.data();
+    float* CR = world.CR.data();
+    float* CG = world.CG.data();
+    float* CB = world.CB.data();
+    const int ntiles = tilesX_ * tilesY_;
+    pool_.parallel_for(0, ntiles, 1, [&](int t0, int t1){
+        for (int t = t0; t < t1; ++t) {
+            int tx = t % tilesX_, ty = t / tilesX_;
+            int x0 = tx*TILE, x1 = std::min(W_, x0 + TILE) - 1;
+            int y0 = ty*TILE, y1 = std::min(H_, y0 + TILE) - 1;
+            splat_tile(H, CR, CG, CB, W_, drops, bands_, bins_[size_t(t)], x0, x1, y0, y1,
+                       cfg.ink_enabled, cfg.ink_gain, cfg.math == 1, cfg.canvas_y0);
+        }
+    });
+}
+
+void TiledBackend::ink(World& world, float dt) {
+    const AppConfig& cfg = world.cfg;
+    const float kdec = ink_decay_factor(dt, cfg.ink_decay);
+    const int rows = 16;
+
+    // Mismo orden que el camino clásico: decay, blur sobre la tinta decaída, mezcla
+    pool_.parallel_for(0, H_, rows, [&](int y0, int y1){
+        ink_decay_rows(world.CR, world.CG, world.CB, W_, y0, y1, kdec);
+    });
+    // Sin blur la "mezcla" solo satura a [0,1], como el decay del camino clásico
+    if (cfg.ink_blur_mix > 0.0f)
+        pool_.parallel_for(0, H_, rows, [&](int y0, int y1){
+            ink_blur_rows(world.CR, world.CG, world.CB, TR, TG, TB, W_, H_, y0, y1);
+        });
+    pool_.parallel_for(0, H_, rows, [&](int y0, int y1){
+        ink_blend_rows(world.CR, world.CG, world.CB, TR, TG, TB, W_, y0, y1, cfg.ink_blur_mix);
+    });
+}
+
+void TiledBackend::shade(const World& world, uint32_t* pixels, int pitch) {
+    const AppConfig& cfg = world.cfg;
+    ShadeInputs in{ world.H.data(), world.CR.data(), world.CG.data(), world.CB.data(), W_, H_,
+                    cfg.slope, cfg.palette, cfg.ink_enabled, cfg.ink_strength };
+    in.fast_math = cfg.math == 1;
+    in.canvas_y0 = cfg.canvas_y0; in.canvas_h = cfg.canvas_h;
+    uint8_t* base = reinterpret_cast<uint8_t*>(pixels);
+    const int ntiles = tilesX_ * tilesY_;
+    pool_.parallel_for(0, ntiles, 2, [&](int t0, int t1){
+        for (int t = t0; t < t1; ++t) {
+            int tx = t % tilesX_, ty = t / tilesX_;
+            int x0 = tx*TILE, x1 = std::min(W_, x0 + TILE);
+            int y0 = ty*TILE, y1 = std::min(H_, y0 + TILE);
+            for (int y = y0; y < y1; ++y)
+                shade_span(in, y, x0, x1, reinterpret_cast<uint32_t*>(base + y*size_t(pitch)));
+        }
+    });
+}
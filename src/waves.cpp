@@ -1,6 +1,12 @@
 #include "waves.hpp"
+#include "drop_log.hpp"
 #include <algorithm>
 #include <cmath>
+#include <functional>
+#include <limits>
+#include <omp.h>
+// Lote mínimo para regenerar gotas en paralelo
+static constexpr int RESPAWN_PAR_MIN = 4096;
 
 // Color cíclico para gotas: rojo, amarillo, verde, naranja
 static void pick_cycle_color(int idx, float& r, float& g, float& b) {
@@ -19,17 +25,21 @@ static inline float hash2(int x, int y){
     return float((h ^ (h >> 16u)) & 0x00FFFFFFu) / float(0x01000000); // [0,1)
 }
 
-World::World(const AppConfig& c)
-: cfg(c), rng(c.seed) {
+World::World(const AppConfig& c, bool planes)
+: cfg(c), seed(resolve_seed(c.seed)) {
     drops.resize(cfg.N);
-    size_t SZ = size_t(cfg.width) * size_t(cfg.height);
-    H .assign(SZ, 0.0f);
-    CR.assign(SZ, 0.0f);
-    CG.assign(SZ, 0.0f);
-    CB.assign(SZ, 0.0f);
+    if (!planes) return;
+    // resize() no escribe: los planos nuevos ya están en ceros y, si salen de la
+    // arena, en el nodo de los hilos que los recorren (arena.hpp)
+    size_t SZ = plane_size(cfg.width, cfg.height);
+    H .resize(SZ);
+    CR.resize(SZ);
+    CG.resize(SZ);
+    CB.resize(SZ);
 }
 
-void World::respawn_drop(Drop& d, float now_s) {
+static void spawn_drop(Drop& d, DropRNG& rng, const WaveParams& wp, const AppConfig& cfg,
+                       float now_s, int color_idx) {
     d.x = rng.rb(0.0f, float(cfg.width));
     d.y = rng.rb(0.0f, float(cfg.height));
     d.t0 = now_s - rng.rb(0.0f, 0.25f);
@@ -51,17 +61,187 @@ void World::respawn_drop(Drop& d, float now_s) {
     d.splash_m     = rng.rbi(wp.splash_m_min, wp.splash_m_max);
     d.splash_phi   = rng.rb(0.0f, float(2*M_PI));
 
-    pick_cycle_color(nextColorIdx++, d.col_r, d.col_g, d.col_b);
+    pick_cycle_color(color_idx, d.col_r, d.col_g, d.col_b);
+}
+
+void World::respawn_batch(const std::vector<int>& idx, float now_s) {
+    const int n = int(idx.size());
+    if (n == 0) return;
+    const int c0 = nextColorIdx;
+    nextColorIdx += n;
+    // Lotes chicos en serie (~18 draws por gota: no compensa abrir un equipo).
+    // Dentro de un equipo (motor team, respawn en un single) se reparte como
+    // taskloop entre los hilos que llegan a la barrera.
+    const bool par = parallel_respawn && n >= RESPAWN_PAR_MIN;
+    if (par && omp_in_parallel()) {
+        #pragma omp taskloop grainsize(1024)
+        for (int k = 0; k < n; ++k) {
+            const int i = idx[size_t(k)];
+            DropRNG r(seed, uint32_t(i), ++gen_[size_t(i)]);
+            spawn_drop(drops[size_t(i)], r, wp, cfg, now_s, c0 + k);
+        }
+    } else {
+        #pragma omp parallel for schedule(static) if(par)
+        for (int k = 0; k < n; ++k) {
+            const int i = idx[size_t(k)];
+            DropRNG r(seed, uint32_t(i), ++gen_[size_t(i)]);
+            spawn_drop(drops[size_t(i)], r, wp, cfg, now_s, c0 + k);
+        }
+    }
+    if (recorder) recorder->on_spawn(idx, drops);
+    // Heap: con un lote mayor que el heap, reconstruir (O(N)) sale más barato
+    const size_t old = expiry_.size();
+    for (int i : idx) {
+        const Drop& d = drops[size_t(i)];
+        expiry_.push_back({d.t0 + d.maxLife, i, gen_[size_t(i)]});
+    }
+    if (size_t(n) > old) std::make_heap(expiry_.begin(), expiry_.end(), std::greater<>());
+    else for (size_t k = old; k < expiry_.size(); ++k)
+        std::push_heap(expiry_.begin(), expiry_.begin() + std::ptrdiff_t(k) + 1, std::greater<>());
 }
 
 void World::init(float now_s) {
-    for (auto& d : drops) respawn_drop(d, now_s);
+    gen_.assign(drops.size(), 0);
+    expiry_.clear();
+    batch_.resize(drops.size());
+    for (size_t i = 0; i < drops.size(); ++i) batch_[i] = int(i);
+    respawn_batch(batch_, now_s);
+    respawned = int(drops.size());
 }
+
 void World::maybe_respawn(float now_s) {
-    for (auto& d : drops) {
+    // La clave t0 + maxLife está redondeada: se sacan las entradas a menos de 1 ms
+    // y se decide con la misma condición que el barrido (edad > maxLife)
+    batch_.clear();
+    retry_.clear();
+    while (!expiry_.empty() && expiry_.front().t - now_s < 1e-3f) {
+        const DropExpiry e = expiry_.front();
+        std::pop_heap(expiry_.begin(), expiry_.end(), std::greater<>());
+        expiry_.pop_back();
+        if (size_t(e.idx) >= drops.size() || e.gen != gen_[size_t(e.idx)]) continue;
+        const Drop& d = drops[size_t(e.idx)];
+        if (now_s - d.t0 > d.maxLife) batch_.push_back(e.idx);
+        else retry_.push_back(e);
+    }
+    for (const DropExpiry& e : retry_) {
+        expiry_.push_back(e);
+        std::push_heap(expiry_.begin(), expiry_.end(), std::greater<>());
+    }
+    std::sort(batch_.begin(), batch_.end());   // colores y acceso a drops en orden
+    respawn_batch(batch_, now_s);
+    respawned = int(batch_.size());
+    if (cfg.cull_eps > 0.0f) cull_scan(now_s);
+    if (recorder) recorder->end_frame(now_s, *this);
+}
+
+void World::set_active_drops(int n, float now_s) {
+    const size_t old_n = drops.size();
+    drops.resize(size_t(std::max(1, n)));
+    if (gen_.size() < drops.size()) gen_.resize(drops.size(), 0);
+    batch_.clear();
+    for (size_t i = old_n; i < drops.size(); ++i) batch_.push_back(int(i));
+    respawn_batch(batch_, now_s);
+}
+
+uint64_t drops_hash(const std::vector<Drop>& drops) {
+    uint64_t h = 0xCBF29CE484222325ull;
+    const auto* p = reinterpret_cast<const unsigned char*>(drops.data());
+    for (size_t i = 0; i < drops.size() * sizeof(Drop); ++i) { h ^= p[i]; h *= 0x100000001B3ull; }
+    return h;
+}
+
+// Píxeles que recorre el kernel para la banda [rmin, rmax]: anillo acotado por su bbox
+static double band_px(const Drop& d, float rmin, float rmax, int W, int Hh) {
+    float bw = std::min(float(W),  d.x + rmax + 2.0f) - std::max(0.0f, d.x - rmax - 2.0f);
+    float bh = std::min(float(Hh), d.y + rmax + 2.0f) - std::max(0.0f, d.y - rmax - 2.0f);
+    if (bw <= 0.0f || bh <= 0.0f) return 0.0;
+    return std::min(double(M_PI) * (double(rmax)*rmax - double(rmin)*rmin), double(bw) * bh);
+}
+
+double drops_pixel_work(const World& w, float now_s) {
+    double px = 0.0;
+    for (const Drop& d : w.drops) {
+        float age = now_s - d.t0;
+        if (age <= 0.0f) continue;
+        float ring = d.c * age, hw = drop_band_halfwidth(d);
+        px += band_px(d, std::max(0.0f, ring - hw), ring + hw, w.cfg.width, w.cfg.height);
+    }
+    return px;
+}
+
+void World::cull_scan(float now_s) {
+    const float ink_gain = cfg.ink_enabled ? cfg.ink_gain : 0.0f;
+    cull = CullStats{};
+    cull.frames = 1;
+    batch_.clear();
+    for (size_t i = 0; i < drops.size(); ++i) {
+        const Drop& d = drops[i];
         float age = now_s - d.t0;
-        if (age > d.maxLife) respawn_drop(d, now_s);
+        if (age <= 0.0f) continue;
+
+        float ring = d.c * age, hw = drop_band_halfwidth(d);
+        float rmin = std::max(0.0f, ring - hw), rmax = ring + hw;
+        double full = band_px(d, rmin, rmax, cfg.width, cfg.height);
+        cull.px_full += full;
+
+        float lo, hi;
+        if (!drop_cull_range(d, age, cfg.cull_eps, ink_gain, lo, hi)) {
+            cull.invisible++;
+            if (cfg.cull_respawn) batch_.push_back(int(i));
+            continue;
+        }
+        lo = std::max(lo, rmin); hi = std::min(hi, rmax);
+        if (lo < hi) cull.px_kept += band_px(d, lo, hi, cfg.width, cfg.height);
+    }
+    // la entrada vieja en el heap queda obsoleta por la generación
+    cull.respawned = int(batch_.size());
+    respawned += cull.respawned;
+    respawn_batch(batch_, now_s);
+}
+
+// Rama s > 1 de |s|·e^(-s²/2) = q: punto fijo s = sqrt(2 ln(s/q)), creciente
+// desde sqrt(-2 ln q); < 0 si el pico e^(-1/2) no llega a q
+static float dgauss_reach(float q) {
+    if (!(q < 0.60653066f)) return -1.0f;
+    float s = std::sqrt(-2.0f * std::log(q));
+    for (int k = 0; k < 4; ++k) s = std::sqrt(2.0f * std::log(s / q));
+    return s * 1.01f;
+}
+// e^(-s²/2) = q
+static float gauss_reach(float q) {
+    return q < 1.0f ? std::sqrt(-2.0f * std::log(q)) : -1.0f;
+}
+
+bool drop_cull_range(const Drop& d, float tau, float eps, float ink_gain, float& lo, float& hi) {
+    const float ring = d.c * tau;
+    const float sg = std::max(1e-3f, d.sigma), cs = std::max(1e-3f, d.cap_sigma);
+    lo = std::numeric_limits<float>::max(); hi = -1.0f;
+    auto grow = [&](float a, float b){ lo = std::min(lo, a); hi = std::max(hi, b); };
+
+    const float damp = std::exp(-d.alpha * tau);
+    // main: A0·damp·dgauss(s)·att
+    float sm = dgauss_reach(eps / 3.0f / std::max(1e-30f, d.A0 * damp));
+    if (sm > 0.0f) grow(ring - sm*sg, ring + sm*sg);
+    // capilares: dos lóbulos en ring ± cap_delta, eps/6 cada uno
+    float ac = d.cap_gain * d.A0 * std::exp(-1.25f * d.alpha * tau) * 0.5f;
+    float sc = dgauss_reach(eps / 6.0f / std::max(1e-30f, ac));
+    if (sc > 0.0f) grow(ring - d.cap_delta - sc*cs, ring + d.cap_delta + sc*cs);
+    // splash: gaussiana centrada (corona <= 1.25)
+    if (tau <= TAU_SPLASH_MAX) {
+        float as = d.splash_amp * std::exp(-d.splash_decay * tau) * 1.25f;
+        float ss = gauss_reach(eps / 3.0f / std::max(1e-30f, as));
+        if (ss > 0.0f) grow(0.0f, ss * d.splash_r0);
+    }
+    // tinta: ink_gain·damp·e^(-s²/2)·att·col, col <= 1
+    if (ink_gain > 0.0f) {
+        float si = gauss_reach(eps / std::max(1e-30f, ink_gain * damp));
+        if (si > 0.0f) grow(ring - si*sg, ring + si*sg);
     }
+    if (hi < 0.0f) return false;
+    // el kernel evalúa con el radio desplazado hasta ±0.175 px (jitter)
+    lo = std::max(0.0f, lo - 0.175f);
+    hi += 0.175f;
+    return true;
 }
 
 // ---- Perfil realista: "derivada de Gauss" en el anillo ----
@@ -100,8 +280,7 @@ float ripple_contrib(float x, float y, float t, const Drop& d) {
     // Splash inicial (corona breve)
     float splash = 0.0f;
     {
-        const float tauSplashMax = 0.25f;
-        if (tau <= tauSplashMax) {
+        if (tau <= TAU_SPLASH_MAX) {
             float rho = d.splash_r0;
             float r2  = (dist2)/(2.0f*rho*rho);
             float ang = std::atan2(dy, dx);
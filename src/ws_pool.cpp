@@ -0,0 +1,102 @@
+#include "ws_pool.hpp"
+#include <algorithm>
+
+WorkStealingPool::WorkStealingPool(int threads) {
+    const int n = std::max(1, threads);
+    for (int i = 0; i < n; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+        workers_.back()->rng = 0x9E3779B9u * uint32_t(i + 1);
+    }
+    for (int i = 1; i < n; ++i)
+        threads_.emplace_back(&WorkStealingPool::worker_main, this, i);
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lk(job_m_);
+        quit_ = true;
+    }
+    job_cv_.notify_all();
+    for (auto& t : threads_) t.join();
+}
+
+void WorkStealingPool::push(int id, Range r) {
+    Worker& w = *workers_[size_t(id)];
+    std::lock_guard<std::mutex> lk(w.m);
+    w.dq.push_back(r);
+}
+
+bool WorkStealingPool::run_one(int id) {
+    Range r{0, 0};
+    bool got = false;
+
+    // 1) Trabajo propio: LIFO (lo más reciente, caliente en caché)
+    {
+        Worker& w = *workers_[size_t(id)];
+        std::lock_guard<std::mutex> lk(w.m);
+        if (!w.dq.empty()) { r = w.dq.back(); w.dq.pop_back(); got = true; }
+    }
+
+    // 2) Robo: FIFO desde el frente de una víctima aleatoria (rangos grandes)
+    if (!got) {
+        const int n = size();
+        Worker& self = *workers_[size_t(id)];
+        for (int k = 0; k < n && !got; ++k) {
+            self.rng = self.rng * 1664525u + 1013904223u;
+            int v = int((self.rng >> 8) % uint32_t(n));
+            if (v == id) continue;
+            Worker& victim = *workers_[size_t(v)];
+            std::lock_guard<std::mutex> lk(victim.m);
+            if (!victim.dq.empty()) {
+                r = victim.dq.front(); victim.dq.pop_front(); got = true;
+                steals_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+    if (!got) return false;
+
+    // Partir a la mitad hasta el grano; las mitades altas quedan robables
+    while (r.e - r.b > grain_) {
+        int mid = r.b + (r.e - r.b) / 2;
+        push(id, Range{mid, r.e});
+        r.e = mid;
+    }
+    (*fn_)(r.b, r.e);
+    remaining_.fetch_sub(r.e - r.b, std::memory_order_acq_rel);
+    return true;
+}
+
+void WorkStealingPool::worker_main(int id) {
+    uint64_t seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lk(job_m_);
+            job_cv_.wait(lk, [&]{ return quit_ || job_gen_ != seen; });
+            if (quit_) return;
+            seen = job_gen_;
+        }
+        while (remaining_.load(std::memory_order_acquire) > 0) {
+            if (!run_one(id)) std::this_thread::yield();
+        }
+    }
+}
+
+void WorkStealingPool::parallel_for(int begin, int end, int grain,
+                                    const std::function<void(int,int)>& fn) {
+    if (end <= begin) return;
+    if (size() == 1) { fn(begin, end); return; }
+
+    fn_ = &fn;
+    grain_ = std::max(1, grain);
+    remaining_.store(end - begin, std::memory_order_release);
+    push(0, Range{begin, end});
+    {
+        std::lock_guard<std::mutex> lk(job_m_);
+        ++job_gen_;
+    }
+    job_cv_.notify_all();
+
+    while (remaining_.load(std::memory_order_acquire) > 0) {
+        if (!run_one(0)) std::this_thread::yield();
+    }
+}